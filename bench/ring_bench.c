@@ -0,0 +1,140 @@
+//~
+//
+//                                 Ring Benchmark.
+// NOTE(voxel): Throughput of spsc_ring and mpmc_queue from 2 up to 16 threads, next to
+//              the same bounded ring behind an OS_Mutex. Every item is summed on the way
+//              out, so a lost or doubled item shows up as a mismatch. Numbers only mean
+//              much on a machine with a few cores. Build with ./build.sh bench
+//
+//~
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/os.h"
+
+#define BENCH_ITEMS 2162160ull
+#define BENCH_CAPACITY 1024
+#define BENCH_MAX_THREADS 16
+
+SPSCRing_Prototype(u64);
+SPSCRing_Impl(u64);
+MPMCQueue_Prototype(u64);
+MPMCQueue_Impl(u64);
+
+typedef u32 BenchKind;
+enum {
+	BenchKind_SPSC,
+	BenchKind_MPMC,
+	BenchKind_Mutex,
+};
+
+static const char* bench_kind_names[] = { "spsc_ring", "mpmc_queue", "OS_Mutex" };
+
+static BenchKind bench_kind;
+static spsc_ring(u64) bench_spsc;
+static mpmc_queue(u64) bench_mpmc;
+
+static OS_Mutex bench_mutex;
+static u64 bench_locked_items[BENCH_CAPACITY];
+static u64 bench_locked_read;
+static u64 bench_locked_write;
+
+static u64 bench_per_producer;
+static u64 bench_per_consumer;
+static u64 bench_sums[BENCH_MAX_THREADS];
+
+//~ Baseline
+
+static b8 bench_locked_push(u64 data) {
+	OS_MutexLock(&bench_mutex);
+	b8 pushed = bench_locked_write - bench_locked_read < BENCH_CAPACITY;
+	if (pushed) bench_locked_items[bench_locked_write++ % BENCH_CAPACITY] = data;
+	OS_MutexUnlock(&bench_mutex);
+	return pushed;
+}
+
+static b8 bench_locked_pop(u64* out) {
+	OS_MutexLock(&bench_mutex);
+	b8 popped = bench_locked_read != bench_locked_write;
+	if (popped) *out = bench_locked_items[bench_locked_read++ % BENCH_CAPACITY];
+	OS_MutexUnlock(&bench_mutex);
+	return popped;
+}
+
+//~ Benchmark
+
+static b8 bench_push(u64 data) {
+	switch (bench_kind) {
+		case BenchKind_SPSC: return spsc_ring_push(u64, &bench_spsc, data);
+		case BenchKind_MPMC: return mpmc_queue_push(u64, &bench_mpmc, data);
+		default:             return bench_locked_push(data);
+	}
+}
+
+static b8 bench_pop(u64* out) {
+	switch (bench_kind) {
+		case BenchKind_SPSC: return spsc_ring_pop(u64, &bench_spsc, out);
+		case BenchKind_MPMC: return mpmc_queue_pop(u64, &bench_mpmc, out);
+		default:             return bench_locked_pop(out);
+	}
+}
+
+static u64 bench_producer(void* context) {
+	u64 first = (u64) context * bench_per_producer + 1;
+	for (u64 i = 0; i < bench_per_producer; i++) {
+		while (!bench_push(first + i)) OS_ThreadYield();
+	}
+	return 0;
+}
+
+static u64 bench_consumer(void* context) {
+	u64 sum = 0;
+	u64 data;
+	for (u64 i = 0; i < bench_per_consumer; i++) {
+		while (!bench_pop(&data)) OS_ThreadYield();
+		sum += data;
+	}
+	bench_sums[(u64) context] = sum;
+	return 0;
+}
+
+static void bench_run(BenchKind kind, u32 producers, u32 consumers) {
+	bench_kind = kind;
+	// BENCH_ITEMS splits evenly between any thread count used below
+	bench_per_producer = BENCH_ITEMS / producers;
+	bench_per_consumer = BENCH_ITEMS / consumers;
+
+	OS_Thread threads[BENCH_MAX_THREADS];
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < consumers; i++) threads[i] = OS_ThreadCreate(bench_consumer, (void*) (u64) i);
+	for (u32 i = 0; i < producers; i++) threads[consumers + i] = OS_ThreadCreate(bench_producer, (void*) (u64) i);
+	for (u32 i = 0; i < producers + consumers; i++) OS_ThreadWaitForJoin(&threads[i]);
+	f64 seconds = (OS_TimeNanosecondsNow() - begin) / 1e9;
+
+	u64 sum = 0;
+	for (u32 i = 0; i < consumers; i++) sum += bench_sums[i];
+	printf("%-10s %2u producers %2u consumers  %7.2f M items/s%s\n", bench_kind_names[kind], producers,
+		   consumers, BENCH_ITEMS / seconds / 1e6, sum == BENCH_ITEMS * (BENCH_ITEMS + 1) / 2 ? "" : "  SUM MISMATCH");
+}
+
+int main(void) {
+	OS_Init();
+	ThreadContext context = {0};
+	tctx_init(&context);
+
+	spsc_ring_init(u64, &bench_spsc, BENCH_CAPACITY);
+	mpmc_queue_init(u64, &bench_mpmc, BENCH_CAPACITY);
+
+	bench_run(BenchKind_SPSC, 1, 1);
+	bench_run(BenchKind_Mutex, 1, 1);
+
+	u32 configs[][2] = { {1, 1}, {2, 2}, {4, 4}, {8, 8}, {1, 15}, {15, 1} };
+	for (BenchKind kind = BenchKind_MPMC; kind <= BenchKind_Mutex; kind++) {
+		for (u32 i = 0; i < ArrayCount(configs); i++) bench_run(kind, configs[i][0], configs[i][1]);
+	}
+
+	spsc_ring_free(u64, &bench_spsc);
+	mpmc_queue_free(u64, &bench_mpmc);
+	tctx_free(&context);
+	return 0;
+}
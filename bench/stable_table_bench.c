@@ -0,0 +1,106 @@
+//~
+//
+//                                 StableTable Benchmark.
+// NOTE(voxel): 10k u64 keys through insert, hit, miss and delete, once starting from 64
+//              slots (so it grows the whole way) and once from 1024. Then the worst single
+//              insert while growing to 200k keys. Build with ./build.sh bench
+//
+//~
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/os.h"
+
+#define BENCH_KEYS 10000
+#define BENCH_GROW_KEYS 200000
+
+typedef struct BenchKey {
+	u64 id;
+} BenchKey;
+
+typedef struct BenchValue BenchValue;
+struct BenchValue {
+	BenchKey key;
+	BenchValue* hash_next;
+	BenchValue* hash_prev;
+	u64 payload;
+};
+
+static b8 BenchKeyIsNull(BenchKey key) { return key.id == 0; }
+static b8 BenchKeyEquals(BenchKey a, BenchKey b) { return a.id == b.id; }
+// Evenly stepped ids, like UI keys built from a counter
+static u64 BenchKeyHash(BenchKey key) { return key.id; }
+
+StableTable_Prototype(BenchKey, BenchValue);
+StableTable_Impl(BenchKey, BenchValue, BenchKeyIsNull, BenchKeyEquals, BenchKeyHash);
+
+static f64 bench_ns_since(u64 begin, u64 iterations) {
+	return (OS_TimeNanosecondsNow() - begin) / (f64) iterations;
+}
+
+static void bench_run(u64 initial_slots) {
+	stable_table(BenchKey, BenchValue) table;
+	stable_table_init(BenchKey, BenchValue, &table, initial_slots);
+	volatile u64 sink = 0;
+	
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u64 i = 1; i <= BENCH_KEYS; i++) {
+		BenchValue value = { .key = { i * 64 }, .payload = i };
+		stable_table_set(BenchKey, BenchValue, &table, value.key, value);
+	}
+	f64 insert_ns = bench_ns_since(begin, BENCH_KEYS);
+	
+	begin = OS_TimeNanosecondsNow();
+	for (u64 i = 1; i <= BENCH_KEYS; i++) {
+		BenchValue* value = nullptr;
+		if (stable_table_get(BenchKey, BenchValue, &table, ((BenchKey) { i * 64 }), &value)) sink += value->payload;
+	}
+	f64 hit_ns = bench_ns_since(begin, BENCH_KEYS);
+	
+	begin = OS_TimeNanosecondsNow();
+	for (u64 i = 1; i <= BENCH_KEYS; i++) {
+		BenchValue* value = nullptr;
+		sink += stable_table_get(BenchKey, BenchValue, &table, ((BenchKey) { i * 64 + 1 }), &value);
+	}
+	f64 miss_ns = bench_ns_since(begin, BENCH_KEYS);
+	
+	StableTableStats stats = stable_table_stats(BenchKey, BenchValue, &table);
+	
+	begin = OS_TimeNanosecondsNow();
+	for (u64 i = 1; i <= BENCH_KEYS; i++) {
+		sink += stable_table_del(BenchKey, BenchValue, &table, ((BenchKey) { i * 64 }));
+	}
+	f64 delete_ns = bench_ns_since(begin, BENCH_KEYS);
+	
+	printf("%5llu initial slots   insert %7.1f  hit %7.1f  miss %7.1f  delete %7.1f ns/op\n",
+		   initial_slots, insert_ns, hit_ns, miss_ns, delete_ns);
+	printf("                      %llu slots, load %.2f, %llu used, longest chain %llu\n",
+		   stats.slot_count, stats.load_factor, stats.used_slots, stats.longest_chain);
+	stable_table_free(BenchKey, BenchValue, &table);
+}
+
+int main(void) {
+	OS_Init();
+	ThreadContext context = {0};
+	tctx_init(&context);
+	
+	printf("%u u64 keys\n", BENCH_KEYS);
+	bench_run(64);
+	bench_run(1024);
+	
+	//- Incremental rehashing keeps every single insert short
+	stable_table(BenchKey, BenchValue) table;
+	stable_table_init(BenchKey, BenchValue, &table, 64);
+	u64 worst = 0;
+	for (u64 i = 1; i <= BENCH_GROW_KEYS; i++) {
+		BenchValue value = { .key = { i * 64 }, .payload = i };
+		u64 begin = OS_TimeNanosecondsNow();
+		stable_table_set(BenchKey, BenchValue, &table, value.key, value);
+		worst = Max(worst, OS_TimeNanosecondsNow() - begin);
+	}
+	printf("worst single insert while growing to %u keys: %.3f ms\n", BENCH_GROW_KEYS, worst / 1e6);
+	stable_table_free(BenchKey, BenchValue, &table);
+	
+	tctx_free(&context);
+	return 0;
+}
@@ -0,0 +1,137 @@
+//~
+//
+//                                 String Benchmark.
+// NOTE(voxel): Hashing and searching over key and path sized strings. The baselines are
+//              what str.c did before wyhash and the first/last byte filter, kept here so
+//              the two can be compared on the same machine. Build with ./build.sh bench
+//
+//~
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/os.h"
+
+//~ Baselines
+
+// FNV-1a, one byte at a time
+static u64 bench_fnv_hash_64(string_const str) {
+	u64 hash = 2166136261u;
+	for (u64 i = 0; i < str.size; i++) {
+		hash ^= str.str[i];
+		hash *= 16777619;
+	}
+	return hash;
+}
+
+// Scans for the first byte, then compares the whole needle
+static u64 bench_naive_find_first(string_const str, string_const needle, u32 offset) {
+	if (!needle.size) return 0;
+	if (str.size < needle.size) return str.size;
+	u64 one_past_last = str.size - needle.size + 1;
+	for (u64 i = offset; i < one_past_last; i++) {
+		if (str.str[i] == needle.str[0] && memcmp(str.str + i, needle.str, needle.size) == 0)
+			return i;
+	}
+	return str.size;
+}
+
+// Same one-past-the-start return as str_find_last
+static u64 bench_naive_find_last(string_const str, string_const needle, u32 offset) {
+	if (offset == 0) offset = str.size;
+	u64 prev = 0;
+	u64 idx = 0;
+	while (true) {
+		prev = idx;
+		idx = bench_naive_find_first(str, needle, idx);
+		if (idx >= offset) break;
+		idx++;
+	}
+	return prev;
+}
+
+//~ Benchmark
+
+static u64 bench_rng = 88172645463325252ull;
+static u64 bench_random(void) {
+	bench_rng ^= bench_rng << 13;
+	bench_rng ^= bench_rng >> 7;
+	bench_rng ^= bench_rng << 17;
+	return bench_rng;
+}
+
+static f64 bench_ns_since(u64 begin, u64 iterations) {
+	return (OS_TimeNanosecondsNow() - begin) / (f64) iterations;
+}
+
+int main(void) {
+	OS_Init();
+	ThreadContext context = {0};
+	tctx_init(&context);
+	
+	static u8 text[8192];
+	for (u32 i = 0; i < sizeof(text); i++) text[i] = 'a' + bench_random() % 26;
+	volatile u64 sink = 0;
+	
+	//- Hashing, from UI keys up to whole files
+	u32 sizes[] = { 12, 24, 40, 100, 200, 4096 };
+	for (u32 s = 0; s < ArrayCount(sizes); s++) {
+		string_const key = { text, sizes[s] };
+		u64 iterations = 200000000 / (sizes[s] + 16);
+		
+		u64 begin = OS_TimeNanosecondsNow();
+		for (u64 i = 0; i < iterations; i++) {
+			key.str = text + (i & 63);
+			sink += bench_fnv_hash_64(key);
+		}
+		f64 fnv_ns = bench_ns_since(begin, iterations);
+		
+		begin = OS_TimeNanosecondsNow();
+		for (u64 i = 0; i < iterations; i++) {
+			key.str = text + (i & 63);
+			sink += str_hash_64(key);
+		}
+		f64 wyhash_ns = bench_ns_since(begin, iterations);
+		printf("hash %5u B        fnv %8.2f ns   str_hash_64 %8.2f ns\n", sizes[s], fnv_ns, wyhash_ns);
+	}
+	
+	//- Searching paths and text
+	string_const path = str_lit("/home/user/projects/chip8-sim/res/shaders/gl46/render_2d_batch.frag.glsl");
+	string_const slash = str_lit("/");
+	string_const extension = str_lit(".frag");
+	u32 iterations = 2000000;
+	
+	string_const haystack = { text, sizeof(text) };
+	string_const missing = str_lit("glyph_cache");
+	if (bench_naive_find_last(path, slash, 0) != str_find_last(path, slash, 0) ||
+		bench_naive_find_first(path, extension, 0) != str_find_first(path, extension, 0) ||
+		bench_naive_find_first(haystack, missing, 0) != str_find_first(haystack, missing, 0))
+		printf("str_find_first/last disagree with the naive search\n");
+	
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < iterations; i++) sink += bench_naive_find_last(path, slash, 0);
+	f64 naive_ns = bench_ns_since(begin, iterations);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < iterations; i++) sink += str_find_last(path, slash, 0);
+	printf("find_last '/' in a %llu B path    naive %8.1f ns   str_find_last  %8.1f ns\n", path.size,
+		   naive_ns, bench_ns_since(begin, iterations));
+	
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < iterations; i++) sink += bench_naive_find_first(path, extension, 0);
+	naive_ns = bench_ns_since(begin, iterations);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < iterations; i++) sink += str_find_first(path, extension, 0);
+	printf("find_first '.frag' in the path   naive %8.1f ns   str_find_first %8.1f ns\n",
+		   naive_ns, bench_ns_since(begin, iterations));
+	
+	iterations = 20000;
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < iterations; i++) sink += bench_naive_find_first(haystack, missing, 0);
+	naive_ns = bench_ns_since(begin, iterations);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < iterations; i++) sink += str_find_first(haystack, missing, 0);
+	printf("find_first miss over 8 KB        naive %8.0f ns   str_find_first %8.0f ns\n",
+		   naive_ns, bench_ns_since(begin, iterations));
+	
+	tctx_free(&context);
+	return 0;
+}
@@ -0,0 +1,180 @@
+//~
+//
+//                                 SwissTable Benchmark.
+// NOTE(voxel): SwissTable against the HashTable it replaced, on the two things it replaced
+//              it for. string -> i32 like the uniform location tables, from the 16 names a
+//              shader has up to 200k keys, and X11 Window ids -> window handles. Build with
+//              ./build.sh bench
+//
+//~
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/os.h"
+
+#define BENCH_LOOKUPS 4000000
+#define BENCH_MAX_WINDOWS 64
+
+// A uniform location. Its own type so these don't clash with the backends' string -> i32 tables
+typedef i32 BenchLocation;
+
+static b8 BenchLocationIsNull(BenchLocation location) { return location == 0;  }
+static b8 BenchLocationIsTombstone(BenchLocation location) { return location == 69; }
+
+HashTable_Prototype(string, BenchLocation);
+HashTable_Impl(string, BenchLocation, str_is_null, str_eq, str_hash, 69, BenchLocationIsNull, BenchLocationIsTombstone);
+SwissTable_Prototype(string, BenchLocation);
+SwissTable_Impl(string, BenchLocation, str_eq, str_hash);
+
+// Laid out like X11's Window, so this doesn't need Xlib. Hashed the same way x11_window.c does
+typedef u64 BenchWindow;
+typedef void* BenchWindowHandle;
+
+static b8 BenchWindowIsNull(BenchWindow window) { return window == 0; }
+static b8 BenchWindowsAreEqual(BenchWindow a, BenchWindow b) { return a == b; }
+static u64 BenchWindowHash(BenchWindow window) { return (u64) window; }
+static b8 BenchWindowHandleIsNull(BenchWindowHandle handle) { return handle == nullptr; }
+static b8 BenchWindowHandleIsTombstone(BenchWindowHandle handle) { return (u64) handle == 69; }
+
+HashTable_Prototype(BenchWindow, BenchWindowHandle);
+HashTable_Impl(BenchWindow, BenchWindowHandle, BenchWindowIsNull, BenchWindowsAreEqual, BenchWindowHash,
+			   (BenchWindowHandle) 69, BenchWindowHandleIsNull, BenchWindowHandleIsTombstone);
+SwissTable_Prototype(BenchWindow, BenchWindowHandle);
+SwissTable_Impl(BenchWindow, BenchWindowHandle, BenchWindowsAreEqual, BenchWindowHash);
+
+static const char* bench_uniform_names[] = {
+	"u_projection", "u_view", "u_model", "u_tint", "u_time", "u_clip_rects", "u_texture", "u_resolution",
+	"u_scale", "u_offset", "u_color", "u_cursor", "u_glyph_atlas", "u_shadow", "u_light_dir", "u_ambient",
+};
+
+static u64 bench_rng = 88172645463325252ull;
+static u64 bench_random(void) {
+	bench_rng ^= bench_rng << 13;
+	bench_rng ^= bench_rng >> 7;
+	bench_rng ^= bench_rng << 17;
+	return bench_rng;
+}
+
+static f64 bench_ns_since(u64 begin, u64 iterations) {
+	return (OS_TimeNanosecondsNow() - begin) / (f64) iterations;
+}
+
+//~ string -> i32
+
+static void bench_strings(M_Arena* arena, u32 key_count) {
+	string* keys = arena_alloc(arena, key_count * sizeof(string));
+	string* missing = arena_alloc(arena, key_count * sizeof(string));
+	for (u32 i = 0; i < key_count; i++) {
+		keys[i] = key_count == ArrayCount(bench_uniform_names) ?
+			str_from_format(arena, "%s", bench_uniform_names[i]) :
+			str_from_format(arena, "u_uniform_%u_%llx", i, bench_random() & 0xFFFF);
+		missing[i] = str_from_format(arena, "u_missing_%u", i);
+	}
+	u32* order = arena_alloc(arena, BENCH_LOOKUPS * sizeof(u32));
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) order[i] = bench_random() % key_count;
+
+	hash_table(string, BenchLocation) old_table;
+	swiss_table(string, BenchLocation) swiss;
+	hash_table_init(string, BenchLocation, &old_table);
+	swiss_table_init(string, BenchLocation, &swiss);
+
+	// From empty, with a handful of keys the first allocation is most of what this measures
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < key_count; i++) hash_table_set(string, BenchLocation, &old_table, keys[i], i + 1);
+	f64 old_insert = bench_ns_since(begin, key_count);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < key_count; i++) swiss_table_set(string, BenchLocation, &swiss, keys[i], i + 1);
+	f64 swiss_insert = bench_ns_since(begin, key_count);
+
+	i64 old_sum = 0, swiss_sum = 0;
+	BenchLocation value = 0;
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) {
+		hash_table_get(string, BenchLocation, &old_table, keys[order[i]], &value);
+		old_sum += value;
+	}
+	f64 old_hit = bench_ns_since(begin, BENCH_LOOKUPS);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) {
+		swiss_table_get(string, BenchLocation, &swiss, keys[order[i]], &value);
+		swiss_sum += value;
+	}
+	f64 swiss_hit = bench_ns_since(begin, BENCH_LOOKUPS);
+
+	u32 found = 0;
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) found += hash_table_get(string, BenchLocation, &old_table, missing[order[i]], &value);
+	f64 old_miss = bench_ns_since(begin, BENCH_LOOKUPS);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) found += swiss_table_get(string, BenchLocation, &swiss, missing[order[i]], &value);
+	f64 swiss_miss = bench_ns_since(begin, BENCH_LOOKUPS);
+
+	printf("string -> i32 %6u keys  insert %6.1f / %6.1f  hit %6.1f / %6.1f  miss %6.1f / %6.1f ns%s\n",
+		   key_count, old_insert, swiss_insert, old_hit, swiss_hit, old_miss, swiss_miss,
+		   old_sum == swiss_sum && !found ? "" : "  MISMATCH");
+
+	hash_table_free(string, BenchLocation, &old_table);
+	swiss_table_free(string, BenchLocation, &swiss);
+}
+
+//~ Window -> handle
+
+static void bench_windows(u32 window_count) {
+	hash_table(BenchWindow, BenchWindowHandle) old_table;
+	swiss_table(BenchWindow, BenchWindowHandle) swiss;
+	hash_table_init(BenchWindow, BenchWindowHandle, &old_table);
+	swiss_table_init(BenchWindow, BenchWindowHandle, &swiss);
+
+	// The server hands out ids to each client from a base with big strides between clients
+	BenchWindow windows[BENCH_MAX_WINDOWS];
+	for (u32 i = 0; i < window_count; i++) {
+		windows[i] = 0x2400001 + i * 0x200000;
+		BenchWindowHandle handle = (BenchWindowHandle) (u64) (i + 100);
+		hash_table_set(BenchWindow, BenchWindowHandle, &old_table, windows[i], handle);
+		swiss_table_set(BenchWindow, BenchWindowHandle, &swiss, windows[i], handle);
+	}
+
+	u64 old_sum = 0, swiss_sum = 0;
+	BenchWindowHandle handle = nullptr;
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) {
+		hash_table_get(BenchWindow, BenchWindowHandle, &old_table, windows[i % window_count], &handle);
+		old_sum += (u64) handle;
+	}
+	f64 old_ns = bench_ns_since(begin, BENCH_LOOKUPS);
+	begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_LOOKUPS; i++) {
+		swiss_table_get(BenchWindow, BenchWindowHandle, &swiss, windows[i % window_count], &handle);
+		swiss_sum += (u64) handle;
+	}
+	f64 swiss_ns = bench_ns_since(begin, BENCH_LOOKUPS);
+
+	printf("Window        %6u windows lookup %6.1f / %6.1f ns%s\n", window_count, old_ns, swiss_ns,
+		   old_sum == swiss_sum ? "" : "  MISMATCH");
+
+	hash_table_free(BenchWindow, BenchWindowHandle, &old_table);
+	swiss_table_free(BenchWindow, BenchWindowHandle, &swiss);
+}
+
+int main(void) {
+	OS_Init();
+	ThreadContext context = {0};
+	tctx_init(&context);
+
+	printf("HashTable / SwissTable\n");
+	M_Arena arena;
+	arena_init(&arena);
+	u32 key_counts[] = { ArrayCount(bench_uniform_names), 200, 10000, 200000 };
+	for (u32 i = 0; i < ArrayCount(key_counts); i++) {
+		bench_strings(&arena, key_counts[i]);
+		arena_clear(&arena);
+	}
+	arena_free(&arena);
+
+	for (u32 window_count = 1; window_count <= BENCH_MAX_WINDOWS; window_count *= 8) {
+		bench_windows(window_count);
+	}
+
+	tctx_free(&context);
+	return 0;
+}
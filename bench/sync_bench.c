@@ -0,0 +1,187 @@
+//~
+//
+//                                 Synchronization Benchmark.
+// NOTE(voxel): OS_Mutex, OS_Semaphore and OS_CondVar against the pthread and sem_t
+//              equivalents, from no contention up to 16 threads on one lock. Numbers only
+//              mean much on a machine with a few cores. Build with ./build.sh bench
+//
+//~
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/os.h"
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#define BENCH_ITERATIONS 400000
+#define BENCH_MAX_THREADS 16
+#define BENCH_CONSUMERS 4
+
+static b32 bench_use_os;
+static OS_Mutex bench_os_mutex;
+static pthread_mutex_t bench_pthread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile u64 bench_shared;
+
+static OS_Semaphore bench_os_ping, bench_os_pong;
+static sem_t bench_sem_ping, bench_sem_pong;
+
+static OS_CondVar bench_os_cv;
+static pthread_cond_t bench_pthread_cv = PTHREAD_COND_INITIALIZER;
+static u64 bench_queued;
+static b32 bench_done;
+
+static void bench_lock(void) {
+	if (bench_use_os) OS_MutexLock(&bench_os_mutex);
+	else pthread_mutex_lock(&bench_pthread_mutex);
+}
+
+static void bench_unlock(void) {
+	if (bench_use_os) OS_MutexUnlock(&bench_os_mutex);
+	else pthread_mutex_unlock(&bench_pthread_mutex);
+}
+
+static f64 bench_ns_since(u64 begin, u64 iterations) {
+	return (OS_TimeNanosecondsNow() - begin) / (f64) iterations;
+}
+
+//~ Mutex
+
+static u64 bench_lock_worker(void* context) {
+	for (u32 i = 0; i < BENCH_ITERATIONS; i++) {
+		bench_lock();
+		bench_shared++;
+		bench_unlock();
+	}
+	return 0;
+}
+
+static void bench_mutex(void) {
+	for (u32 thread_count = 1; thread_count <= BENCH_MAX_THREADS; thread_count *= 2) {
+		OS_Thread threads[BENCH_MAX_THREADS];
+		bench_shared = 0;
+		u64 begin = OS_TimeNanosecondsNow();
+		for (u32 i = 0; i < thread_count; i++) threads[i] = OS_ThreadCreate(bench_lock_worker, nullptr);
+		for (u32 i = 0; i < thread_count; i++) OS_ThreadWaitForJoin(&threads[i]);
+		f64 ns = bench_ns_since(begin, (u64) thread_count * BENCH_ITERATIONS);
+		if (bench_shared != (u64) thread_count * BENCH_ITERATIONS) printf("mutex lost increments\n");
+		printf("%-13s lock/unlock %2u threads    %8.1f ns\n", bench_use_os ? "OS_Mutex" : "pthread_mutex",
+			   thread_count, ns);
+	}
+}
+
+//~ Semaphore
+
+static u64 bench_pong_worker(void* context) {
+	for (u32 i = 0; i < BENCH_ITERATIONS / 4; i++) {
+		if (bench_use_os) {
+			OS_SemaphoreWait(&bench_os_ping);
+			OS_SemaphoreSignal(&bench_os_pong, 1);
+		} else {
+			sem_wait(&bench_sem_ping);
+			sem_post(&bench_sem_pong);
+		}
+	}
+	return 0;
+}
+
+static void bench_semaphore(void) {
+	const char* name = bench_use_os ? "OS_Semaphore" : "sem_t";
+	OS_SemaphoreInit(&bench_os_ping, 0);
+	OS_SemaphoreInit(&bench_os_pong, 0);
+	sem_init(&bench_sem_ping, 0, 0);
+	sem_init(&bench_sem_pong, 0, 0);
+	
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_ITERATIONS; i++) {
+		if (bench_use_os) {
+			OS_SemaphoreSignal(&bench_os_ping, 1);
+			OS_SemaphoreWait(&bench_os_ping);
+		} else {
+			sem_post(&bench_sem_ping);
+			sem_wait(&bench_sem_ping);
+		}
+	}
+	printf("%-13s signal+wait, uncontended   %8.1f ns\n", name, bench_ns_since(begin, BENCH_ITERATIONS));
+	
+	begin = OS_TimeNanosecondsNow();
+	OS_Thread thread = OS_ThreadCreate(bench_pong_worker, nullptr);
+	for (u32 i = 0; i < BENCH_ITERATIONS / 4; i++) {
+		if (bench_use_os) {
+			OS_SemaphoreSignal(&bench_os_ping, 1);
+			OS_SemaphoreWait(&bench_os_pong);
+		} else {
+			sem_post(&bench_sem_ping);
+			sem_wait(&bench_sem_pong);
+		}
+	}
+	OS_ThreadWaitForJoin(&thread);
+	printf("%-13s ping-pong round trip       %8.1f ns\n", name, bench_ns_since(begin, BENCH_ITERATIONS / 4));
+	
+	OS_SemaphoreFree(&bench_os_ping);
+	OS_SemaphoreFree(&bench_os_pong);
+	sem_destroy(&bench_sem_ping);
+	sem_destroy(&bench_sem_pong);
+}
+
+//~ Condition Variable
+
+static u64 bench_consumer(void* context) {
+	u64 consumed = 0;
+	for (;;) {
+		bench_lock();
+		while (!bench_queued && !bench_done) {
+			if (bench_use_os) OS_CondVarWait(&bench_os_cv, &bench_os_mutex);
+			else pthread_cond_wait(&bench_pthread_cv, &bench_pthread_mutex);
+		}
+		if (!bench_queued) {
+			bench_unlock();
+			break;
+		}
+		bench_queued--;
+		consumed++;
+		bench_unlock();
+	}
+	return consumed;
+}
+
+static void bench_condvar(void) {
+	OS_Thread threads[BENCH_CONSUMERS];
+	bench_queued = 0;
+	bench_done = false;
+	u64 begin = OS_TimeNanosecondsNow();
+	for (u32 i = 0; i < BENCH_CONSUMERS; i++) threads[i] = OS_ThreadCreate(bench_consumer, nullptr);
+	for (u32 i = 0; i < BENCH_ITERATIONS; i++) {
+		bench_lock();
+		bench_queued++;
+		bench_unlock();
+		if (bench_use_os) OS_CondVarSignal(&bench_os_cv);
+		else pthread_cond_signal(&bench_pthread_cv);
+	}
+	
+	bench_lock();
+	bench_done = true;
+	bench_unlock();
+	if (bench_use_os) OS_CondVarBroadcast(&bench_os_cv);
+	else pthread_cond_broadcast(&bench_pthread_cv);
+	for (u32 i = 0; i < BENCH_CONSUMERS; i++) OS_ThreadWaitForJoin(&threads[i]);
+	
+	if (bench_queued) printf("condvar left %llu items behind\n", bench_queued);
+	printf("%-13s 1 producer, %u consumers  %8.1f ns/item\n", bench_use_os ? "OS_CondVar" : "pthread_cond",
+		   BENCH_CONSUMERS, bench_ns_since(begin, BENCH_ITERATIONS));
+}
+
+int main(void) {
+	OS_Init();
+	printf("%u processors\n", OS_ProcessorCount());
+	OS_MutexInit(&bench_os_mutex);
+	OS_CondVarInit(&bench_os_cv);
+	
+	for (bench_use_os = 0; bench_use_os < 2; bench_use_os++) bench_mutex();
+	for (bench_use_os = 0; bench_use_os < 2; bench_use_os++) bench_semaphore();
+	for (bench_use_os = 0; bench_use_os < 2; bench_use_os++) bench_condvar();
+	
+	OS_CondVarFree(&bench_os_cv);
+	OS_MutexFree(&bench_os_mutex);
+	return 0;
+}
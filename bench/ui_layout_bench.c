@@ -0,0 +1,282 @@
+//~
+//
+//                                 UI Layout Benchmark.
+// NOTE(voxel): The flattened layout passes against the recursive ones they replaced, on a
+//              frame of about 5k boxes (panels of labels, buttons, checkboxes and nested
+//              boxes, plus a scrolling list). Both have to come up with the same bounds for
+//              every box, or it says so. Needs a window and the backend, and res/ for the
+//              font, so run it from the repo root. Build with ./build.sh bench
+//
+//~
+
+// The layout passes are static, this has to be the same translation unit as the UI layer
+#include "opt/ui.c"
+#include "core/backend.h"
+
+#define BENCH_FRAMES 200
+#define BENCH_WARMUP_FRAMES 20
+#define BENCH_PANELS 90
+#define BENCH_PANEL_ITEMS 30
+
+//~ Baseline
+// What UI_EndFrame ran before UI_LayoutFlatten: a recursion over the tree per axis and per pass
+
+static void bench_recurse_forward(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
+	f32 edge_correction_factor = box->parent ?
+		box->parent->edge_size + (box->parent->edge_size)*0.25 : 0;
+
+	if (box->semantic_size[axis].kind == SizeKind_Pixels) {
+		box->computed_size[axis] = box->semantic_size[axis].value;
+	} else if (box->semantic_size[axis].kind == SizeKind_TextContent) {
+		if (axis == axis2_x) {
+			box->computed_size[axis] = UI_TextRunGet(box->font, box->identifier, ui_cache->current_frame_index)->width + box->semantic_size[axis].value * 2;
+		} else {
+			box->computed_size[axis] = box->font->font_size + box->semantic_size[axis].value * 2;
+		}
+	} else if (box->semantic_size[axis].kind == SizeKind_PercentOfParent) {
+		box->computed_size[axis] = (box->parent->computed_size[axis] - edge_correction_factor*2) *
+			box->semantic_size[axis].value / 100.f;
+	}
+
+	for (UI_Box* curr = box->first; curr; curr = curr->next) {
+		bench_recurse_forward(ui_cache, curr, axis);
+	}
+}
+
+static void bench_recurse_backward(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
+	f32 size = 0.f;
+	for (UI_Box* curr = box->first; curr; curr = curr->next) {
+		bench_recurse_backward(ui_cache, curr, axis);
+		size += curr->computed_size[axis];
+	}
+	if (box->semantic_size[axis].kind == SizeKind_ChildrenSum) {
+		box->computed_size[axis] = size;
+	}
+	if (axis == box->layout_axis) {
+		box->content_size = size;
+	}
+}
+
+static void bench_recurse_position(UI_Cache* ui_cache, UI_Box* box, f32 depth) {
+	f32 edge_correction_factor = box->parent ? (box->parent->edge_size)*0.25 : 0;
+	f32 child_depth = box->edge_size + edge_correction_factor;
+	if (box->flags & BoxFlag_ViewScroll) child_depth -= box->view_offset;
+	for (UI_Box* curr = box->first; curr; curr = curr->next) {
+		bench_recurse_position(ui_cache, curr, child_depth);
+		child_depth += curr->computed_size[box->layout_axis];
+	}
+
+	if (box->parent) {
+		box->computed_rel_position[box->parent->layout_axis] = depth;
+		box->computed_rel_position[!box->parent->layout_axis] = box->parent->edge_size + edge_correction_factor;
+	}
+}
+
+static void bench_recurse_bounds(UI_Cache* ui_cache, UI_Box* box, f32 xoff, f32 yoff, b8 snap) {
+	xoff += box->computed_rel_position[axis2_x];
+	yoff += box->computed_rel_position[axis2_y];
+
+	box->target_bounds.x = xoff;
+	box->target_bounds.y = yoff;
+	box->target_bounds.w = box->computed_size[axis2_x];
+	box->target_bounds.h = box->computed_size[axis2_y];
+	if (snap) {
+		box->bounds = box->target_bounds;
+		box->direct_set = false;
+	}
+
+	rect clippable_bounds = box->bounds;
+	if (box->flags & BoxFlag_DrawBorder) {
+		f32 edge_correction_factor = box->parent ? (box->parent->edge_size)*0.25 : 0;
+		clippable_bounds.x += box->edge_size + edge_correction_factor;
+		clippable_bounds.y += box->edge_size + edge_correction_factor;
+		clippable_bounds.w -= box->edge_size * 2 + edge_correction_factor;
+		clippable_bounds.h -= box->edge_size * 2 + edge_correction_factor;
+	}
+
+	box->clipped_bounds = rect_get_overlap(clippable_bounds, UI_ClippingRectPeek(ui_cache));
+	if (box->flags & BoxFlag_Clip) {
+		UI_ClippingRectPush(ui_cache, box->clipped_bounds);
+	}
+
+	f32 x0 = box->clipped_bounds.x, x1 = box->clipped_bounds.x + box->clipped_bounds.w;
+	f32 y0 = box->clipped_bounds.y, y1 = box->clipped_bounds.y + box->clipped_bounds.h;
+	for (UI_Box* curr = box->first; curr; curr = curr->next) {
+		bench_recurse_bounds(ui_cache, curr, xoff, yoff, snap || (box->flags & BoxFlag_ViewScroll));
+		rect child = UI_BoxSubtreeBounds(curr);
+		x0 = Min(x0, child.x); x1 = Max(x1, child.x + child.w);
+		y0 = Min(y0, child.y); y1 = Max(y1, child.y + child.h);
+	}
+	if (box->first) box->subtree_bounds = (rect) { x0, y0, x1 - x0, y1 - y0 };
+
+	if (box->flags & BoxFlag_Clip) {
+		UI_ClippingRectPop(ui_cache);
+	}
+}
+
+static void bench_layout_recursive(UI_Cache* ui_cache) {
+	for (u32 i = axis2_x; i < axis2_count; i++) {
+		bench_recurse_forward(ui_cache, ui_cache->root, i);
+		bench_recurse_backward(ui_cache, ui_cache->root, i);
+	}
+	bench_recurse_position(ui_cache, ui_cache->root, 0.f);
+	bench_recurse_bounds(ui_cache, ui_cache->root, 0.f, 0.f, false);
+}
+
+static void bench_layout_flattened(UI_Cache* ui_cache) {
+	UI_LayoutFlatten(ui_cache);
+	UI_LayoutSizesFromChildren(ui_cache);
+	UI_LayoutPlace(ui_cache);
+}
+
+//~ Checking
+
+typedef struct BenchBoxLayout {
+	rect target_bounds;
+	rect clipped_bounds;
+	rect subtree_bounds;
+	f32 content_size;
+} BenchBoxLayout;
+
+static BenchBoxLayout bench_box_layout(UI_Box* box) {
+	BenchBoxLayout layout;
+	MemoryZeroStruct(&layout, BenchBoxLayout);
+	layout.target_bounds = box->target_bounds;
+	layout.clipped_bounds = box->clipped_bounds;
+	layout.subtree_bounds = UI_BoxSubtreeBounds(box);
+	layout.content_size = box->content_size;
+	return layout;
+}
+
+// Pre-order, the same order both times since the tree doesn't change in between
+static u32 bench_layout_save(UI_Box* box, BenchBoxLayout* out, u32 index) {
+	out[index++] = bench_box_layout(box);
+	for (UI_Box* curr = box->first; curr; curr = curr->next) index = bench_layout_save(curr, out, index);
+	return index;
+}
+
+// Whatever a layout pass computes, so the second one can't pass by leaving the first one's work.
+// The root's size comes from UI_BeginFrame, not from layout
+static void bench_layout_clear(UI_Box* box) {
+	if (box->parent) MemoryZero(box->computed_size, sizeof(box->computed_size));
+	MemoryZero(box->computed_rel_position, sizeof(box->computed_rel_position));
+	MemoryZeroStruct(&box->target_bounds, rect);
+	MemoryZeroStruct(&box->clipped_bounds, rect);
+	MemoryZeroStruct(&box->subtree_bounds, rect);
+	box->content_size = 0;
+	for (UI_Box* curr = box->first; curr; curr = curr->next) bench_layout_clear(curr);
+}
+
+static u32 bench_layout_compare(UI_Box* box, BenchBoxLayout* expected, u32* index) {
+	BenchBoxLayout layout = bench_box_layout(box);
+	u32 mismatches = memcmp(&layout, &expected[(*index)++], sizeof(BenchBoxLayout)) != 0;
+	for (UI_Box* curr = box->first; curr; curr = curr->next) mismatches += bench_layout_compare(curr, expected, index);
+	return mismatches;
+}
+
+//~ Benchmark
+
+static void bench_build_frame(UI_Cache* ui) {
+	UI_PrefWidthPush(ui, UI_Percentage(100));
+	UI_PrefHeightPush(ui, UI_Pixels(30));
+	for (u32 p = 0; p < BENCH_PANELS; p++) {
+		UI_EdgeSizePush(ui, 1 + p % 3);
+		UI_LayoutAxisPush(ui, p % 2 ? axis2_x : axis2_y);
+		UI_PrefHeight(ui, UI_ChildrenSum()) UI_PrefWidth(ui, UI_Percentage(90)) {
+			UI_Box* panel = UI_BoxMakeF(ui, BoxFlag_DrawBorder | BoxFlag_Clip | BoxFlag_DrawBackground, "panel%u", p);
+			UI_Parent(ui, panel) UI_PrefWidth(ui, UI_Percentage(p % 2 ? 20 : 100)) UI_PrefHeight(ui, UI_Pixels(24)) {
+				for (u32 i = 0; i < BENCH_PANEL_ITEMS; i++) {
+					switch (i % 5) {
+						case 0: {
+							UI_PrefWidth(ui, UI_TextContent(4)) UI_PrefHeight(ui, UI_TextContent(2))
+								UI_BoxMakeF(ui, BoxFlag_DrawText, "label %u %u##label%u_%u", p, i, p, i);
+						} break;
+						case 1: UI_ButtonF(ui, "B%u##button%u_%u", i, p, i); break;
+						case 2: UI_CheckboxF(ui, "checkbox%u_%u", p, i); break;
+						default: {
+							UI_LayoutAxisPush(ui, axis2_x);
+							UI_Box* inner = UI_BoxMakeF(ui, BoxFlag_DrawBorder, "inner%u_%u", p, i);
+							UI_LayoutAxisPop(ui);
+							UI_Parent(ui, inner) UI_PrefWidth(ui, UI_Percentage(50)) UI_PrefHeight(ui, UI_Percentage(100)) {
+								UI_BoxMake(ui, BoxFlag_DrawBackground, str_lit(""));
+								UI_BoxMakeF(ui, BoxFlag_DrawBackground, "leaf%u_%u", p, i);
+							}
+						} break;
+					}
+				}
+			}
+		}
+		UI_LayoutAxisPop(ui);
+		UI_EdgeSizePop(ui);
+	}
+
+	UI_PrefHeight(ui, UI_Pixels(200)) {
+		UI_ListRange range = UI_ListBegin(ui, str_lit("list"), 20, 1000);
+		for (u64 i = range.first; i < range.one_past_last; i++) UI_BoxMakeF(ui, BoxFlag_DrawText, "row %llu##row%llu", i, i);
+		UI_ListEnd(ui);
+	}
+}
+
+int main(void) {
+	OS_Init();
+	ThreadContext context = {0};
+	tctx_init(&context);
+	U_FrameArenaInit();
+
+	OS_Window* window = OS_WindowCreate(1280, 720, str_lit("UI Layout Benchmark"));
+	B_BackendInit(window);
+	UI_Cache* ui = M_AllocZero(sizeof(UI_Cache));
+	UI_Init(window, ui);
+
+	f64 recursive_total = 0, flattened_total = 0;
+	f64 recursive_min = 1e9, flattened_min = 1e9;
+	u32 timed_frames = 0, mismatches = 0;
+	BenchBoxLayout* expected = nullptr;
+	u32 box_count = 0;
+
+	for (u32 frame = 0; frame < BENCH_FRAMES; frame++) {
+		U_ResetFrameArena();
+		UI_BeginFrame(window, ui);
+		bench_build_frame(ui);
+
+		u64 begin = OS_TimeNanosecondsNow();
+		bench_layout_recursive(ui);
+		f64 recursive_ns = (f64) (OS_TimeNanosecondsNow() - begin);
+
+		expected = arena_alloc(U_GetFrameArena(), ui->box_count * sizeof(BenchBoxLayout));
+		bench_layout_save(ui->root, expected, 0);
+		bench_layout_clear(ui->root);
+
+		begin = OS_TimeNanosecondsNow();
+		bench_layout_flattened(ui);
+		f64 flattened_ns = (f64) (OS_TimeNanosecondsNow() - begin);
+
+		u32 index = 0;
+		mismatches += bench_layout_compare(ui->root, expected, &index);
+
+		if (frame >= BENCH_WARMUP_FRAMES) {
+			recursive_total += recursive_ns;
+			flattened_total += flattened_ns;
+			recursive_min = Min(recursive_min, recursive_ns);
+			flattened_min = Min(flattened_min, flattened_ns);
+			timed_frames++;
+		}
+		box_count = ui->box_count;
+
+		UI_EndFrame(ui, 0.016f);
+		B_BackendSwapchainNext(window);
+	}
+
+	printf("%u boxes, %u frames\n", box_count, timed_frames);
+	printf("recursive  mean %8.1f us  min %8.1f us\n", recursive_total / timed_frames / 1e3, recursive_min / 1e3);
+	printf("flattened  mean %8.1f us  min %8.1f us\n", flattened_total / timed_frames / 1e3, flattened_min / 1e3);
+	if (mismatches) printf("%u boxes over all frames came out different between the two\n", mismatches);
+
+	UI_Free(ui);
+	M_Free(ui);
+	B_BackendFree(window);
+	OS_WindowClose(window);
+	U_FrameArenaFree();
+	tctx_free(&context);
+	return 0;
+}
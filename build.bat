@@ -6,6 +6,14 @@ IF NOT EXIST bin\int mkdir bin\int
 REM call vcvarsall.bat x64
 SET cc=clang
 
+REM ------------------
+REM      Options
+REM ------------------
+
+REM Has to match Use_PerfHUD (and Use_UI) in build_base.bat, main.c only wires the HUD in
+REM when USE_PERF_HUD is defined
+SET Use_PerfHUD=false
+
 REM ------------------
 REM    Main Project
 REM ------------------
@@ -22,7 +30,7 @@ SET backend=BACKEND_D3D11
 
 REM ==============
 if %cc% == cl.exe (
-  SET compiler_flags=/Zc:preprocessor /wd4090 /wd5105 /nologo
+  SET compiler_flags=/std:c11 /Zc:preprocessor /wd4090 /wd5105 /nologo
   SET include_flags=/I.\source\ /I.\third_party\include\ /I.\third_party\source\
   SET linker_flags=/link /DEBUG:FULL /LIBPATH:.\third_party\lib OpenAL32.lib shell32.lib user32.lib winmm.lib userenv.lib gdi32.lib /LIBPATH:.\bin codebase.lib
   SET output=/Fe.\bin\chip8 /Fo.\bin\int\
@@ -38,6 +46,11 @@ if %cc% == clang (
 )
 REM ==============
 
+if %Use_PerfHUD% == true (
+  if %cc% == cl.exe SET defines=!defines! /DUSE_PERF_HUD
+  if %cc% == clang SET defines=!defines! -DUSE_PERF_HUD
+)
+
 REM SET compiler_flags=!compiler_flags! -fsanitize=address
 
 REM ==============
@@ -11,6 +11,8 @@ cc=clang
 Use_Render2D=false
 Use_Physics2D=false
 Use_UI=true
+# Needs Use_UI
+Use_PerfHUD=true
 
 # ------------------
 #    Main Project
@@ -66,6 +68,20 @@ then
   c_filenames="$c_filenames source/opt/ui.c"
 fi
 
+# main.c only wires the HUD in when USE_PERF_HUD is defined
+layer_defines=
+if $Use_PerfHUD == true
+then
+  if $Use_UI == true
+  then
+    echo Optional Layer Selected: PerfHUD
+    c_filenames="$c_filenames source/opt/perf_hud.c"
+    layer_defines="$layer_defines -DUSE_PERF_HUD"
+  else
+    echo PerfHUD needs Use_UI, leaving it out
+  fi
+fi
+
 # ==============
 
 
@@ -74,8 +90,9 @@ fi
 compiler_flags="-Wall -Wvarargs -Werror -Wno-unused-function -Wno-format-security -Wno-incompatible-pointer-types-discards-qualifiers -Wno-unused-but-set-variable -Wno-int-to-void-pointer-cast"
 include_flags="-Isource -Ithird_party/include -Ithird_party/source"
 linker_flags="-g -lm -lX11 -Lthird_party/lib"
-defines="-D_DEBUG -D_CRT_SECURE_NO_WARNINGS"
+defines="-D_DEBUG -D_CRT_SECURE_NO_WARNINGS $layer_defines"
 output="-obin/codebase"
+# -DBACKEND_GL46, -DBACKEND_GL33 or -DBACKEND_SOFT (CPU rasterizer, runs without a GPU or display)
 backend="-DBACKEND_GL46"
 # ==============
 
@@ -89,6 +106,31 @@ fi
 # ==============
 
 # compiler_flags="$compiler_flags -fsanitize=address"
+# Logs every arena, pool and scratch allocation, see the Tracing section of base/mem.h
+# defines="$defines -DM_TRACE"
+
+# ------------------
+#    Benchmarks
+# ------------------
+# ./build.sh bench builds every bench/*.c into bin/ against base, os and core, optimized,
+# instead of building the main project. Benches for an optional layer include its .c
+
+if [ "$1" = "bench" ]
+then
+  bench_filenames=
+  for entry in ./source/base/*.c ./source/impl/*.c ./source/os/*.c ./source/core/*.c
+  do
+    bench_filenames="$bench_filenames $entry"
+  done
+  
+  for entry in ./bench/*.c
+  do
+    name=$(basename $entry .c)
+    echo Building $name...
+    $cc $entry $bench_filenames -O2 $compiler_flags $defines $backend $include_flags $linker_flags -lpthread -obin/$name
+  done
+  exit
+fi
 
 echo Building codebase.exe...
 $cc $c_filenames $compiler_flags $defines $backend $include_flags $linker_flags $output
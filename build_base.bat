@@ -17,6 +17,8 @@ REM ------------------
 SET Use_Render2D=true
 SET Use_Physics2D=false
 SET Use_UI=false
+REM Needs Use_UI, and has to match Use_PerfHUD in build.bat
+SET Use_PerfHUD=false
 
 
 SET backend=BACKEND_D3D11
@@ -25,7 +27,7 @@ SET backend=BACKEND_D3D11
 
 REM ==============
 if %cc% == cl.exe (
-  SET compiler_flags=/Zc:preprocessor /wd4090 /wd5105 /nologo /DEBUG /c
+  SET compiler_flags=/std:c11 /Zc:preprocessor /wd4090 /wd5105 /nologo /DEBUG /c
   SET include_flags=/I.\source\ /I.\third_party\include\ /I.\third_party\source\
   SET output_flag=/Fo.\bin\int
   SET defines=/D_DEBUG /D_CRT_SECURE_NO_WARNINGS /D%backend%
@@ -66,6 +68,15 @@ if %Use_UI% == true (
   %cc% %compiler_flags% source\opt\ui.c %defines% %include_flags% %output_flag%/opt/ui.obj
 )
 
+if %Use_PerfHUD% == true (
+  if %Use_UI% == true (
+    ECHO Optional Layer Selected: PerfHUD
+    %cc% %compiler_flags% source\opt\perf_hud.c %defines% %include_flags% %output_flag%/opt/perf_hud.obj
+  ) else (
+    ECHO PerfHUD needs Use_UI, leaving it out
+  )
+)
+
 REM ==============
 
 
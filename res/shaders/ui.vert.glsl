@@ -1,12 +1,15 @@
 #version 330 core
 
+// One instance per quad, the six vertices are generated from gl_VertexID
 layout (location = 0) in vec2  a_boxsize;
 layout (location = 1) in vec2  a_boxcenter;
-layout (location = 2) in vec2  a_uv;
-layout (location = 3) in float a_texidx;
-layout (location = 4) in vec4  a_color;
-layout (location = 5) in vec4  a_clip_quad;
-layout (location = 6) in vec3  a_rounding_softness_and_edge_size;
+layout (location = 2) in vec4  a_uvrect;
+layout (location = 3) in vec4  a_color_tl;
+layout (location = 4) in vec4  a_color_tr;
+layout (location = 5) in vec4  a_color_br;
+layout (location = 6) in vec4  a_color_bl;
+layout (location = 7) in vec3  a_rounding_softness_and_edge_size;
+layout (location = 8) in vec2  a_texidx_and_clipidx;
 
 out vec2  v_boxsize;
 out vec2  v_boxcenter;
@@ -26,19 +29,29 @@ const vec2 vertex_multiplers[6] = vec2[6](
 										  vec2(-.5, +.5)
 										  );
 
+// tl, tr, br, bl
+const int corner_indices[6] = int[6](0, 1, 2, 0, 2, 3);
+
+// Must match UI_MAX_CLIP_RECTS in opt/ui.h
 layout (std140) uniform ActualConstants {
 	mat4 u_projection;
+	vec4 u_clip_rects[128];
 };
 
 void main() {
-    vec2 pos = a_boxcenter + (a_boxsize * vertex_multiplers[gl_VertexID % 6]);
+	int vertex = gl_VertexID % 6;
+	vec2 multiplier = vertex_multiplers[vertex];
+    vec2 pos = a_boxcenter + (a_boxsize * multiplier);
 	gl_Position = u_projection * vec4(pos, 0.0, 1.0);
+	
+	vec4 corner_colors[4] = vec4[4](a_color_tl, a_color_tr, a_color_br, a_color_bl);
+	
 	v_boxsize = a_boxsize;
 	v_boxcenter = a_boxcenter;
-	v_texindex = a_texidx;
-	v_texcoord = a_uv;
-	v_color = a_color;
-	v_clip_quad = a_clip_quad;
+	v_texindex = a_texidx_and_clipidx.x;
+	v_texcoord = a_uvrect.xy + a_uvrect.zw * (multiplier + 0.5);
+	v_color = corner_colors[corner_indices[vertex]];
+	v_clip_quad = u_clip_rects[int(a_texidx_and_clipidx.y)];
 	v_rounding_softness_and_edge_size = a_rounding_softness_and_edge_size;
 	v_sampling_loc = pos;
 }
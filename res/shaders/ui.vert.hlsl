@@ -11,8 +11,10 @@ struct VS_Out {
     float4 pos       : SV_Position;
 };
 
+// Must match UI_MAX_CLIP_RECTS in opt/ui.h
 cbuffer ActualConstants {
     matrix u_projection;
+    float4 u_clip_rects[128];
 };
 
 static const float2 vertex_multiplers[] = {
@@ -24,26 +26,35 @@ static const float2 vertex_multiplers[] = {
     float2(-.5, +.5),
 };
 
+// tl, tr, br, bl
+static const uint corner_indices[] = { 0, 1, 2, 0, 2, 3 };
+
+// One instance per quad, the six vertices are generated from SV_VertexID
 VS_Out main(
     float2 size : BoxSize,
     float2 center : BoxCenter,
-    float2 tex_coord : TexCoord,
-    float1 tex_idx : TexIndex,
-    float4 color : Color,
-    float4 clip_quad : ClipQuad,
+    float4 uv_rect : TexRect,
+    float4 color_tl : ColorTL,
+    float4 color_tr : ColorTR,
+    float4 color_br : ColorBR,
+    float4 color_bl : ColorBL,
     float3 rounding_softness_and_edgesize : RoundingSoftnessAndEdgeSize,
+    uint2  tex_and_clip_idx : TexAndClipIndex,
     uint   vertex_id : SV_VertexID
 ) {
     VS_Out ret;
-    float2 pos = center + (size * vertex_multiplers[vertex_id % 6]);
+    uint vertex = vertex_id % 6;
+    float2 multiplier = vertex_multiplers[vertex];
+    float2 pos = center + (size * multiplier);
+    float4 corner_colors[4] = { color_tl, color_tr, color_br, color_bl };
 
     ret.pos       = mul(u_projection, float4(pos, 0.0, 1.0));
     ret.size      = size;
     ret.center    = center;
-    ret.tex_idx   = tex_idx;
-    ret.tex_coord = tex_coord;
-    ret.color     = color;
-    ret.clip_quad = clip_quad;
+    ret.tex_idx   = tex_and_clip_idx.x;
+    ret.tex_coord = uv_rect.xy + uv_rect.zw * (multiplier + 0.5);
+    ret.color     = corner_colors[corner_indices[vertex]];
+    ret.clip_quad = u_clip_rects[tex_and_clip_idx.y];
     ret.rounding_softness_and_edgesize = rounding_softness_and_edgesize;
     ret.sampling_loc = pos;
     return ret;
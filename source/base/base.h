@@ -4,7 +4,9 @@
 #define BASE_H
 
 #include "defines.h"
+#include "bits.h"
 #include "ds.h"
+#include "jobs.h"
 #include "log.h"
 #include "mem.h"
 #include "str.h"
@@ -0,0 +1,36 @@
+/* date = October 19th 2026 10:12 am */
+
+#ifndef BITS_H
+#define BITS_H
+
+#include "defines.h"
+
+#if defined(COMPILER_CL)
+#  include <intrin.h>
+#endif
+
+//~ Bit Scanning
+// NOTE(voxel): Both are undefined for 0, every caller already checks the mask before asking.
+// Forward is the index of the lowest set bit, Reverse the index of the highest one
+
+static inline u32 bit_scan_forward(u64 x) {
+#if defined(COMPILER_CL)
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return (u32) index;
+#else
+	return (u32) __builtin_ctzll(x);
+#endif
+}
+
+static inline u32 bit_scan_reverse(u64 x) {
+#if defined(COMPILER_CL)
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return (u32) index;
+#else
+	return (u32) (63 - __builtin_clzll(x));
+#endif
+}
+
+#endif //BITS_H
@@ -5,6 +5,8 @@
 
 #include "defines.h"
 #include "os/os.h"
+#include "mem.h"
+#include "bits.h"
 #include <string.h>
 
 #define DoubleCapacity(x) ((x) <= 0 ? 8 : x * 2)
@@ -35,10 +37,10 @@ void Data##_array##_add(Data##_array* array, Data data) {\
 if (array->len + 1 > array->cap) {\
 void* prev = array->elems;\
 u32 new_cap = DoubleCapacity(array->cap);\
-array->elems = calloc(new_cap, sizeof(Data));\
+array->elems = M_AllocZero(new_cap * sizeof(Data));\
 memmove(array->elems, prev, array->len * sizeof(Data));\
 array->cap = new_cap;\
-free(prev);\
+M_Free(prev);\
 }\
 array->elems[array->len++] = data;\
 }\
@@ -46,10 +48,10 @@ void Data##_array##_add_at(Data##_array* array, Data data, u32 idx) {\
 if (array->len + 1 > array->cap) {\
 void* prev = array->elems;\
 u32 new_cap = DoubleCapacity(array->cap);\
-array->elems = calloc(new_cap, sizeof(Data));\
+array->elems = M_AllocZero(new_cap * sizeof(Data));\
 memmove(array->elems, prev, array->len * sizeof(Data));\
 array->cap = new_cap;\
-free(prev);\
+M_Free(prev);\
 }\
 memmove(array->elems + idx + 1, array->elems + idx, sizeof(Data) * (array->len - idx));\
 array->elems[idx] = data;\
@@ -58,10 +60,10 @@ array->len++;\
 void Data##_array##_reserve(Data##_array* array, u32 count) {\
 void* prev = array->elems;\
 u32 new_cap = count;\
-array->elems = calloc(new_cap, sizeof(Data));\
+array->elems = M_AllocZero(new_cap * sizeof(Data));\
 memmove(array->elems, prev, array->len * sizeof(Data));\
 array->cap = new_cap;\
-if (prev) free(prev);\
+if (prev) M_Free(prev);\
 }\
 Data Data##_array##_remove(Data##_array* array, int idx) {\
 if (idx >= array->len || idx < 0) return (Data){0};\
@@ -79,7 +81,7 @@ return value;\
 void Data##_array##_free(Data##_array* array) {\
 array->cap = 0;\
 array->len = 0;\
-free(array->elems);\
+M_Free(array->elems);\
 }
 
 #define dstack(type) type##_stack
@@ -107,9 +109,10 @@ void Data##_stack##_push(Data##_stack* stack, Data data) {\
 if (stack->len + 1 > stack->cap) {\
 void* prev = stack->elems;\
 u32 new_cap = DoubleCapacity(stack->cap);\
-stack->elems = calloc(new_cap, sizeof(Data));\
+stack->elems = M_AllocZero(new_cap * sizeof(Data));\
 memmove(stack->elems, prev, stack->len * sizeof(Data));\
-free(prev);\
+stack->cap = new_cap;\
+M_Free(prev);\
 }\
 stack->elems[stack->len++] = data;\
 }\
@@ -127,7 +130,133 @@ stack->len = 0;\
 void Data##_stack##_free(Data##_stack* stack) {\
 stack->cap = 0;\
 stack->len = 0;\
-free(stack->elems);\
+M_Free(stack->elems);\
+}
+
+//~ Arena Array
+
+// NOTE(voxel): Same shape as a darray, but the elements come out of an arena. Growing an
+// array that's still the last thing in its arena just extends it in place. Otherwise it
+// moves to the top of the arena and the old block stays behind until the arena gets cleared.
+// There's no free, the arena owns the memory
+#define arena_array(type) type##_arena_array
+
+#define arena_array_init(type, array, arena) type##_arena_array##_init(array, arena)
+#define arena_array_add(type, array, data) type##_arena_array##_add(array, data)
+#define arena_array_add_at(type, array, data, idx) type##_arena_array##_add_at(array, data, idx)
+#define arena_array_reserve(type, array, count) type##_arena_array##_reserve(array, count)
+#define arena_array_remove(type, array, idx) type##_arena_array##_remove(array, idx)
+#define arena_array_clear(type, array) type##_arena_array##_clear(array)
+
+#define ArenaArray_Prototype(Data)\
+typedef struct Data##_arena_array {\
+u32 cap;\
+u32 len;\
+Data* elems;\
+M_Arena* arena;\
+} Data##_arena_array;\
+void Data##_arena_array##_init(Data##_arena_array* array, M_Arena* arena);\
+void Data##_arena_array##_add(Data##_arena_array* array, Data data);\
+void Data##_arena_array##_add_at(Data##_arena_array* array, Data data, u32 idx);\
+void Data##_arena_array##_reserve(Data##_arena_array* array, u32 count);\
+Data Data##_arena_array##_remove(Data##_arena_array* array, int idx);\
+void Data##_arena_array##_clear(Data##_arena_array* array);
+
+#define ArenaArray_Impl(Data)\
+void Data##_arena_array##_init(Data##_arena_array* array, M_Arena* arena) {\
+MemoryZeroStruct(array, Data##_arena_array);\
+array->arena = arena;\
+}\
+void Data##_arena_array##_reserve(Data##_arena_array* array, u32 count) {\
+if (count <= array->cap) return;\
+if (!array->elems || !arena_extend(array->arena, array->elems, array->cap * sizeof(Data), count * sizeof(Data))) {\
+Data* elems = arena_alloc(array->arena, count * sizeof(Data));\
+if (array->len) memcpy(elems, array->elems, array->len * sizeof(Data));\
+array->elems = elems;\
+}\
+array->cap = count;\
+}\
+void Data##_arena_array##_add(Data##_arena_array* array, Data data) {\
+if (array->len + 1 > array->cap) Data##_arena_array##_reserve(array, DoubleCapacity(array->cap));\
+array->elems[array->len++] = data;\
+}\
+void Data##_arena_array##_add_at(Data##_arena_array* array, Data data, u32 idx) {\
+if (array->len + 1 > array->cap) Data##_arena_array##_reserve(array, DoubleCapacity(array->cap));\
+memmove(array->elems + idx + 1, array->elems + idx, sizeof(Data) * (array->len - idx));\
+array->elems[idx] = data;\
+array->len++;\
+}\
+Data Data##_arena_array##_remove(Data##_arena_array* array, int idx) {\
+if (idx >= array->len || idx < 0) return (Data){0};\
+Data value = array->elems[idx];\
+memmove(array->elems + idx, array->elems + idx + 1, sizeof(Data) * (array->len - idx - 1));\
+array->len--;\
+return value;\
+}\
+void Data##_arena_array##_clear(Data##_arena_array* array) {\
+array->len = 0;\
+}
+
+//~ Small Array
+
+// NOTE(voxel): A darray with room for N elements inside of it, it only goes to the heap once
+// it outgrows them. While it fits, elems points into the struct itself, so init it before
+// use and pass it around by pointer, a copy would still point at the original's elements
+#define small_array(type, n) type##_small_array##n
+
+#define small_array_init(type, n, array) type##_small_array##n##_init(array)
+#define small_array_add(type, n, array, data) type##_small_array##n##_add(array, data)
+#define small_array_add_at(type, n, array, data, idx) type##_small_array##n##_add_at(array, data, idx)
+#define small_array_remove(type, n, array, idx) type##_small_array##n##_remove(array, idx)
+#define small_array_free(type, n, array) type##_small_array##n##_free(array)
+
+#define SmallArray_Prototype(Data, N)\
+typedef struct Data##_small_array##N {\
+u32 cap;\
+u32 len;\
+Data* elems;\
+Data inline_elems[N];\
+} Data##_small_array##N;\
+void Data##_small_array##N##_init(Data##_small_array##N* array);\
+void Data##_small_array##N##_add(Data##_small_array##N* array, Data data);\
+void Data##_small_array##N##_add_at(Data##_small_array##N* array, Data data, u32 idx);\
+Data Data##_small_array##N##_remove(Data##_small_array##N* array, int idx);\
+void Data##_small_array##N##_free(Data##_small_array##N* array);
+
+#define SmallArray_Impl(Data, N)\
+void Data##_small_array##N##_init(Data##_small_array##N* array) {\
+array->cap = N;\
+array->len = 0;\
+array->elems = array->inline_elems;\
+}\
+static void Data##_small_array##N##_grow(Data##_small_array##N* array) {\
+u32 new_cap = array->cap * 2;\
+Data* elems = M_Alloc(new_cap * sizeof(Data));\
+memcpy(elems, array->elems, array->len * sizeof(Data));\
+if (array->elems != array->inline_elems) M_Free(array->elems);\
+array->elems = elems;\
+array->cap = new_cap;\
+}\
+void Data##_small_array##N##_add(Data##_small_array##N* array, Data data) {\
+if (array->len + 1 > array->cap) Data##_small_array##N##_grow(array);\
+array->elems[array->len++] = data;\
+}\
+void Data##_small_array##N##_add_at(Data##_small_array##N* array, Data data, u32 idx) {\
+if (array->len + 1 > array->cap) Data##_small_array##N##_grow(array);\
+memmove(array->elems + idx + 1, array->elems + idx, sizeof(Data) * (array->len - idx));\
+array->elems[idx] = data;\
+array->len++;\
+}\
+Data Data##_small_array##N##_remove(Data##_small_array##N* array, int idx) {\
+if (idx >= array->len || idx < 0) return (Data){0};\
+Data value = array->elems[idx];\
+memmove(array->elems + idx, array->elems + idx + 1, sizeof(Data) * (array->len - idx - 1));\
+array->len--;\
+return value;\
+}\
+void Data##_small_array##N##_free(Data##_small_array##N* array) {\
+if (array->elems != array->inline_elems) M_Free(array->elems);\
+Data##_small_array##N##_init(array);\
 }
 
 #define HashTable_MaxLoad 0.75
@@ -176,7 +305,7 @@ table->len = 0;\
 table->elems = nullptr;\
 }\
 void Key##_##Value##_hash_table_free(Key##_##Value##_hash_table* table) {\
-free(table->elems);\
+M_Free(table->elems);\
 table->cap = 0;\
 table->len = 0;\
 table->elems = nullptr;\
@@ -198,7 +327,7 @@ index = (index + 1) % cap;\
 }\
 }\
 static void Key##_##Value##_hash_table_adjust_cap(Key##_##Value##_hash_table* table, u64 cap) {\
-Key##_##Value##_hash_table_entry* entries = calloc(cap, sizeof(Key##_##Value##_hash_table_entry));\
+Key##_##Value##_hash_table_entry* entries = M_AllocZero(cap * sizeof(Key##_##Value##_hash_table_entry));\
 table->len = 0;\
 for (u64 i = 0; i < table->cap; i++) {\
 Key##_##Value##_hash_table_entry* curr = &table->elems[i];\
@@ -208,7 +337,7 @@ dest->key = curr->key;\
 dest->value = curr->value;\
 table->len++;\
 }\
-free(table->elems);\
+M_Free(table->elems);\
 table->cap = cap;\
 table->elems = entries;\
 }\
@@ -265,12 +394,27 @@ entry->value = Key##_##Value##_hash_table_tombstone;\
 return true;\
 }
 
-// More specialized form of hash table which doesn't grow and provides stable pointers
-// It allows semi-infinite allocations using a Memory Pool
+// More specialized form of hash table which provides stable pointers
+// Values are allocated from a Memory Pool and never move, slots only point at chains of them.
+// Once there's more than one value per slot the slot count doubles, and the old slots get
+// moved over StableTable_RehashStep at a time by the operations that follow, so no single
+// insert pays for the whole table. Lookups check the old slots that haven't moved yet.
 // Due to this, we have a few requirements for the value type
 // @requirement a key member
 // @requirement hash_next and hash_prev pointer fields
 
+#define StableTable_MinSlots 16
+#define StableTable_RehashStep 8
+
+typedef struct StableTableStats {
+	u64 count;
+	u64 slot_count;
+	f32 load_factor;
+	u64 used_slots;
+	u64 longest_chain;
+	b8  rehashing;
+} StableTableStats;
+
 #define stable_table_key(key, value) key##_##value##_stable_table_key
 #define stable_table_value(key, value) key##_##value##_stable_table_value
 #define stable_table(key, value) key##_##value##_stable_table
@@ -282,14 +426,25 @@ return true;\
 key_t##_##value_t##_stable_table_get_guarantee(table, key, val)
 #define stable_table_del(key_t, value_t, table, key) key_t##_##value_t##_stable_table_del(table, key)
 #define stable_table_free(key_t, value_t, table) key_t##_##value_t##_stable_table_free(table)
+#define stable_table_stats(key_t, value_t, table) key_t##_##value_t##_stable_table_stats(table)
+
+// Deleting `it` inside the loop is fine, inserting anything is not
+#define stable_table_foreach(key_t, value_t, table, it)\
+for (key_t##_##value_t##_stable_table_value *it = key_t##_##value_t##_stable_table_first(table),\
+*it##_next = key_t##_##value_t##_stable_table_next(table, it);\
+it; it = it##_next, it##_next = key_t##_##value_t##_stable_table_next(table, it))
 
 #define StableTable_Prototype(Key, Value)\
 typedef Key Key##_##Value##_stable_table_key;\
 typedef Value Key##_##Value##_stable_table_value;\
 typedef struct Key##_##Value##_stable_table {\
 M_Pool element_pool;\
-u64 len;\
-Key##_##Value##_stable_table_value* elems;\
+u64 count;\
+u64 slot_count;\
+Key##_##Value##_stable_table_value** slots;\
+u64 old_slot_count;\
+u64 rehash_index;\
+Key##_##Value##_stable_table_value** old_slots;\
 } Key##_##Value##_stable_table;\
 void Key##_##Value##_stable_table_init(Key##_##Value##_stable_table* table, u64 num_slots);\
 void Key##_##Value##_stable_table_free(Key##_##Value##_stable_table* table);\
@@ -297,114 +452,522 @@ b8 Key##_##Value##_stable_table_get(Key##_##Value##_stable_table* table, Key##_#
 void Key##_##Value##_stable_table_get_guarantee(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value** val);\
 void Key##_##Value##_stable_table_set(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value val);\
 b8 Key##_##Value##_stable_table_del(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key);\
+Key##_##Value##_stable_table_value* Key##_##Value##_stable_table_first(Key##_##Value##_stable_table* table);\
+Key##_##Value##_stable_table_value* Key##_##Value##_stable_table_next(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_value* curr);\
+StableTableStats Key##_##Value##_stable_table_stats(Key##_##Value##_stable_table* table);
+
+// NOTE(voxel): Slot counts are powers of two. The hash gets multiplied and folded first,
+// so keys that only differ in their high bits (or step evenly) still spread out
+static inline u64 StableTable_Slot(u64 hash, u64 slot_count) {
+	u64 x = hash * 0x9E3779B97F4A7C15ull;
+	return (x ^ (x >> 32)) & (slot_count - 1);
+}
 
 #define StableTable_Impl(Key, Value, KeyIsNull, KeyIsEqual, HashKey)\
 void Key##_##Value##_stable_table_init(Key##_##Value##_stable_table* table, u64 num_slots) {\
+MemoryZeroStruct(table, Key##_##Value##_stable_table);\
 pool_init(&table->element_pool, sizeof(Key##_##Value##_stable_table_value));\
-table->len = num_slots;\
-table->elems = OS_MemoryReserve(sizeof(Key##_##Value##_stable_table_value) * num_slots);\
-OS_MemoryCommit(table->elems, sizeof(Key##_##Value##_stable_table_value) * num_slots);\
+table->slot_count = StableTable_MinSlots;\
+while (table->slot_count < num_slots) table->slot_count *= 2;\
+table->slots = M_AllocZero(table->slot_count * sizeof(Key##_##Value##_stable_table_value*));\
 }\
 void Key##_##Value##_stable_table_free(Key##_##Value##_stable_table* table) {\
-OS_MemoryRelease(table->elems, sizeof(Key##_##Value##_stable_table_value) * table->len);\
+M_Free(table->slots);\
+M_Free(table->old_slots);\
 pool_free(&table->element_pool);\
-}\
-b8 Key##_##Value##_stable_table_get(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value** val) {\
-u64 slot = HashKey(key) % table->len;\
-Key##_##Value##_stable_table_value* curr = &table->elems[slot];\
-if (KeyIsNull(curr->key)) return false;\
+MemoryZeroStruct(table, Key##_##Value##_stable_table);\
+}\
+static void Key##_##Value##_stable_table_link(Key##_##Value##_stable_table_value** slot, Key##_##Value##_stable_table_value* val) {\
+val->hash_prev = nullptr;\
+val->hash_next = *slot;\
+if (*slot) (*slot)->hash_prev = val;\
+*slot = val;\
+}\
+static void Key##_##Value##_stable_table_rehash_step(Key##_##Value##_stable_table* table, u64 steps) {\
+if (!table->old_slots) return;\
+for (u64 i = 0; i < steps && table->rehash_index < table->old_slot_count; i++, table->rehash_index++) {\
+Key##_##Value##_stable_table_value* curr = table->old_slots[table->rehash_index];\
 while (curr) {\
-if (KeyIsEqual(curr->key, key)) {\
-*val = curr;\
-return true;\
+Key##_##Value##_stable_table_value* next = curr->hash_next;\
+u64 slot = StableTable_Slot(HashKey(curr->key), table->slot_count);\
+Key##_##Value##_stable_table_link(&table->slots[slot], curr);\
+curr = next;\
 }\
-curr = curr->hash_next;\
+table->old_slots[table->rehash_index] = nullptr;\
 }\
-return false;\
+if (table->rehash_index == table->old_slot_count) {\
+M_Free(table->old_slots);\
+table->old_slots = nullptr;\
+table->old_slot_count = 0;\
+table->rehash_index = 0;\
 }\
-void Key##_##Value##_stable_table_get_guarantee(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value** val) {\
-u64 slot = HashKey(key) % table->len;\
-Key##_##Value##_stable_table_value* curr = &table->elems[slot];\
-Key##_##Value##_stable_table_value* one_before_curr = curr;\
-if (!KeyIsNull(curr->key)) {\
-while (curr) {\
-if (!KeyIsNull(curr->key)) {\
-if (KeyIsEqual(curr->key, key)) {\
-*val = curr;\
-return;\
 }\
+static Key##_##Value##_stable_table_value** Key##_##Value##_stable_table_find(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value** found) {\
+u64 hash = HashKey(key);\
+Key##_##Value##_stable_table_value** slot = &table->slots[StableTable_Slot(hash, table->slot_count)];\
+for (Key##_##Value##_stable_table_value* curr = *slot; curr; curr = curr->hash_next) {\
+if (KeyIsEqual(curr->key, key)) { *found = curr; return slot; }\
 }\
-one_before_curr = curr;\
-curr = curr->hash_next;\
+if (table->old_slots) {\
+u64 old_index = StableTable_Slot(hash, table->old_slot_count);\
+if (old_index >= table->rehash_index) {\
+slot = &table->old_slots[old_index];\
+for (Key##_##Value##_stable_table_value* curr = *slot; curr; curr = curr->hash_next) {\
+if (KeyIsEqual(curr->key, key)) { *found = curr; return slot; }\
 }\
-curr = pool_alloc(&table->element_pool);\
-curr->hash_prev = one_before_curr;\
-one_before_curr->hash_next = curr;\
-curr->key = key;\
-*val = curr;\
-} else {\
+}\
+}\
+*found = nullptr;\
+return nullptr;\
+}\
+b8 Key##_##Value##_stable_table_get(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value** val) {\
+if (KeyIsNull(key)) return false;\
+Key##_##Value##_stable_table_rehash_step(table, StableTable_RehashStep);\
+Key##_##Value##_stable_table_value* found;\
+Key##_##Value##_stable_table_find(table, key, &found);\
+if (!found) return false;\
+*val = found;\
+return true;\
+}\
+void Key##_##Value##_stable_table_get_guarantee(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value** val) {\
+if (Key##_##Value##_stable_table_get(table, key, val)) return;\
+if (table->count + 1 > table->slot_count) {\
+Key##_##Value##_stable_table_rehash_step(table, table->old_slot_count);\
+table->old_slots = table->slots;\
+table->old_slot_count = table->slot_count;\
+table->rehash_index = 0;\
+table->slot_count *= 2;\
+table->slots = M_AllocZero(table->slot_count * sizeof(Key##_##Value##_stable_table_value*));\
+}\
+Key##_##Value##_stable_table_value* curr = pool_alloc(&table->element_pool);\
 MemoryZeroStruct(curr, Key##_##Value##_stable_table_value);\
 curr->key = key;\
+Key##_##Value##_stable_table_link(&table->slots[StableTable_Slot(HashKey(key), table->slot_count)], curr);\
+table->count++;\
 *val = curr;\
 }\
-}\
 void Key##_##Value##_stable_table_set(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key, Key##_##Value##_stable_table_value val) {\
-u64 slot = HashKey(key) % table->len;\
-Key##_##Value##_stable_table_value* curr = &table->elems[slot];\
-Key##_##Value##_stable_table_value* one_before_curr = curr;\
-if (!KeyIsNull(curr->key)) {\
-while (curr) {\
-if (!KeyIsNull(curr->key)) {\
-if (KeyIsEqual(curr->key, key)) {\
+Key##_##Value##_stable_table_value* curr;\
+Key##_##Value##_stable_table_get_guarantee(table, key, &curr);\
+Key##_##Value##_stable_table_value* hash_next = curr->hash_next;\
+Key##_##Value##_stable_table_value* hash_prev = curr->hash_prev;\
 *curr = val;\
-return;\
-}\
+curr->key = key;\
+curr->hash_next = hash_next;\
+curr->hash_prev = hash_prev;\
 }\
-one_before_curr = curr;\
-curr = curr->hash_next;\
+b8 Key##_##Value##_stable_table_del(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key) {\
+if (KeyIsNull(key)) return false;\
+Key##_##Value##_stable_table_value* found;\
+Key##_##Value##_stable_table_value** slot = Key##_##Value##_stable_table_find(table, key, &found);\
+if (!found) return false;\
+if (found->hash_prev) found->hash_prev->hash_next = found->hash_next;\
+else *slot = found->hash_next;\
+if (found->hash_next) found->hash_next->hash_prev = found->hash_prev;\
+pool_dealloc(&table->element_pool, found);\
+table->count--;\
+return true;\
 }\
-curr = pool_alloc(&table->element_pool);\
-curr->hash_prev = one_before_curr;\
-one_before_curr->hash_next = curr;\
-*curr = val;\
-curr->key = key;\
-} else {\
-MemoryZeroStruct(curr, Key##_##Value##_stable_table_value);\
-*curr = val;\
-curr->key = key;\
+static Key##_##Value##_stable_table_value* Key##_##Value##_stable_table_first_from(Key##_##Value##_stable_table* table, u64 slot) {\
+for (; slot < table->slot_count; slot++) {\
+if (table->slots[slot]) return table->slots[slot];\
+}\
+return nullptr;\
+}\
+Key##_##Value##_stable_table_value* Key##_##Value##_stable_table_first(Key##_##Value##_stable_table* table) {\
+Key##_##Value##_stable_table_rehash_step(table, table->old_slot_count);\
+return Key##_##Value##_stable_table_first_from(table, 0);\
+}\
+Key##_##Value##_stable_table_value* Key##_##Value##_stable_table_next(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_value* curr) {\
+if (!curr) return nullptr;\
+if (curr->hash_next) return curr->hash_next;\
+return Key##_##Value##_stable_table_first_from(table, StableTable_Slot(HashKey(curr->key), table->slot_count) + 1);\
+}\
+StableTableStats Key##_##Value##_stable_table_stats(Key##_##Value##_stable_table* table) {\
+StableTableStats stats = {0};\
+stats.count = table->count;\
+stats.slot_count = table->slot_count;\
+stats.load_factor = (f32) table->count / (f32) table->slot_count;\
+stats.rehashing = table->old_slots != nullptr;\
+for (u64 i = 0; i < table->slot_count + table->old_slot_count; i++) {\
+Key##_##Value##_stable_table_value* curr = i < table->slot_count ? table->slots[i] : table->old_slots[i - table->slot_count];\
+u64 chain = 0;\
+for (; curr; curr = curr->hash_next) chain++;\
+if (chain) stats.used_slots++;\
+stats.longest_chain = Max(stats.longest_chain, chain);\
+}\
+return stats;\
+}
+
+//~ Rings
+
+// NOTE(voxel): Bounded queues for handing things from one thread to another. Capacities get
+// rounded up to a power of two and the indices never wrap, a slot is index & mask. Whatever
+// each side writes sits on its own cache line, so a producer and a consumer running flat out
+// aren't fighting over the same line. Push returns false when full, pop when empty. Data gets
+// copied in and out, so keep it small or hand out pointers. The rings are cache line
+// aligned themselves, so one allocated with M_Alloc or in an arena is only as good as the
+// alignment it got there
+
+static inline u64 Ring_Capacity(u64 requested) {
+	u64 capacity = 2;
+	while (capacity < requested) capacity *= 2;
+	return capacity;
+}
+
+//- Single producer, single consumer
+// Each side keeps a copy of the other side's index and only goes back to the shared one when
+// the copy says the ring is full (or empty), which is rare once things are moving
+
+#define spsc_ring(type) type##_spsc_ring
+
+#define spsc_ring_init(type, ring, capacity) type##_spsc_ring##_init(ring, capacity)
+#define spsc_ring_push(type, ring, data) type##_spsc_ring##_push(ring, data)
+#define spsc_ring_pop(type, ring, out) type##_spsc_ring##_pop(ring, out)
+#define spsc_ring_free(type, ring) type##_spsc_ring##_free(ring)
+
+#define SPSCRing_Prototype(Data)\
+typedef struct Data##_spsc_ring {\
+cache_line_aligned u64 write;\
+u64 cached_read;\
+cache_line_aligned u64 read;\
+u64 cached_write;\
+cache_line_aligned u64 mask;\
+Data* elems;\
+} Data##_spsc_ring;\
+void Data##_spsc_ring##_init(Data##_spsc_ring* ring, u64 capacity);\
+b8 Data##_spsc_ring##_push(Data##_spsc_ring* ring, Data data);\
+b8 Data##_spsc_ring##_pop(Data##_spsc_ring* ring, Data* out);\
+void Data##_spsc_ring##_free(Data##_spsc_ring* ring);
+
+#define SPSCRing_Impl(Data)\
+void Data##_spsc_ring##_init(Data##_spsc_ring* ring, u64 capacity) {\
+MemoryZeroStruct(ring, Data##_spsc_ring);\
+capacity = Ring_Capacity(capacity);\
+ring->mask = capacity - 1;\
+ring->elems = M_AllocZero(capacity * sizeof(Data));\
+}\
+b8 Data##_spsc_ring##_push(Data##_spsc_ring* ring, Data data) {\
+u64 write = ring->write;\
+if (write - ring->cached_read > ring->mask) {\
+ring->cached_read = OS_AtomicLoad(&ring->read, MemoryOrder_Acquire);\
+if (write - ring->cached_read > ring->mask) return false;\
+}\
+ring->elems[write & ring->mask] = data;\
+OS_AtomicStore(&ring->write, write + 1, MemoryOrder_Release);\
+return true;\
 }\
+b8 Data##_spsc_ring##_pop(Data##_spsc_ring* ring, Data* out) {\
+u64 read = ring->read;\
+if (read == ring->cached_write) {\
+ring->cached_write = OS_AtomicLoad(&ring->write, MemoryOrder_Acquire);\
+if (read == ring->cached_write) return false;\
 }\
-b8 Key##_##Value##_stable_table_del(Key##_##Value##_stable_table* table, Key##_##Value##_stable_table_key key) {\
-u64 slot = HashKey(key) % table->len;\
-Key##_##Value##_stable_table_value* curr = &table->elems[slot];\
-Key##_##Value##_stable_table_value* one_before_curr = curr;\
-if (KeyIsNull(curr->key)) return false;\
-while (curr) {\
-if (!KeyIsNull(curr->key)) {\
-if (KeyIsEqual(curr->key, key)) {\
-if (curr->hash_prev) {\
-curr->hash_prev->hash_next = curr->hash_next;\
-if (curr->hash_next) curr->hash_next->hash_prev = curr->hash_prev;\
+*out = ring->elems[read & ring->mask];\
+OS_AtomicStore(&ring->read, read + 1, MemoryOrder_Release);\
 return true;\
+}\
+void Data##_spsc_ring##_free(Data##_spsc_ring* ring) {\
+M_Free(ring->elems);\
+MemoryZeroStruct(ring, Data##_spsc_ring);\
+}
+
+//- Multiple producers, multiple consumers
+// Vyukov's bounded queue. Every cell has a sequence number that says whose turn it is: it's
+// pos when the cell is free for the push that claims pos, and pos + 1 once that push is done
+// and it's ready for the pop that claims pos. Claiming is a compare exchange on the shared
+// index, after that nobody else touches the cell until its sequence moves on
+
+#define mpmc_queue(type) type##_mpmc_queue
+
+#define mpmc_queue_init(type, queue, capacity) type##_mpmc_queue##_init(queue, capacity)
+#define mpmc_queue_push(type, queue, data) type##_mpmc_queue##_push(queue, data)
+#define mpmc_queue_pop(type, queue, out) type##_mpmc_queue##_pop(queue, out)
+#define mpmc_queue_free(type, queue) type##_mpmc_queue##_free(queue)
+
+#define MPMCQueue_Prototype(Data)\
+typedef struct Data##_mpmc_queue_cell {\
+u64 sequence;\
+Data data;\
+} Data##_mpmc_queue_cell;\
+typedef struct Data##_mpmc_queue {\
+cache_line_aligned u64 push_index;\
+cache_line_aligned u64 pop_index;\
+cache_line_aligned u64 mask;\
+Data##_mpmc_queue_cell* cells;\
+} Data##_mpmc_queue;\
+void Data##_mpmc_queue##_init(Data##_mpmc_queue* queue, u64 capacity);\
+b8 Data##_mpmc_queue##_push(Data##_mpmc_queue* queue, Data data);\
+b8 Data##_mpmc_queue##_pop(Data##_mpmc_queue* queue, Data* out);\
+void Data##_mpmc_queue##_free(Data##_mpmc_queue* queue);
+
+#define MPMCQueue_Impl(Data)\
+void Data##_mpmc_queue##_init(Data##_mpmc_queue* queue, u64 capacity) {\
+MemoryZeroStruct(queue, Data##_mpmc_queue);\
+capacity = Ring_Capacity(capacity);\
+queue->mask = capacity - 1;\
+queue->cells = M_AllocZero(capacity * sizeof(Data##_mpmc_queue_cell));\
+for (u64 i = 0; i < capacity; i++) queue->cells[i].sequence = i;\
+}\
+b8 Data##_mpmc_queue##_push(Data##_mpmc_queue* queue, Data data) {\
+u64 pos = OS_AtomicLoad(&queue->push_index, MemoryOrder_Relaxed);\
+Data##_mpmc_queue_cell* cell;\
+for (;;) {\
+cell = &queue->cells[pos & queue->mask];\
+i64 diff = (i64) (OS_AtomicLoad(&cell->sequence, MemoryOrder_Acquire) - pos);\
+if (diff == 0) {\
+if (OS_AtomicCompareExchange(&queue->push_index, &pos, pos + 1, MemoryOrder_Relaxed)) break;\
+} else if (diff < 0) {\
+return false;\
 } else {\
-if (curr->hash_next) {\
-if (curr->hash_next->hash_next)\
-curr->hash_next->hash_next->hash_prev = curr;\
-Key##_##Value##_stable_table_value v = *curr->hash_next;\
-pool_dealloc(&table->element_pool, curr->hash_next);\
-*curr = v;\
+pos = OS_AtomicLoad(&queue->push_index, MemoryOrder_Relaxed);\
+}\
+}\
+cell->data = data;\
+OS_AtomicStore(&cell->sequence, pos + 1, MemoryOrder_Release);\
 return true;\
+}\
+b8 Data##_mpmc_queue##_pop(Data##_mpmc_queue* queue, Data* out) {\
+u64 pos = OS_AtomicLoad(&queue->pop_index, MemoryOrder_Relaxed);\
+Data##_mpmc_queue_cell* cell;\
+for (;;) {\
+cell = &queue->cells[pos & queue->mask];\
+i64 diff = (i64) (OS_AtomicLoad(&cell->sequence, MemoryOrder_Acquire) - (pos + 1));\
+if (diff == 0) {\
+if (OS_AtomicCompareExchange(&queue->pop_index, &pos, pos + 1, MemoryOrder_Relaxed)) break;\
+} else if (diff < 0) {\
+return false;\
 } else {\
-MemoryZeroStruct(curr, Key##_##Value##_stable_table_value);\
+pos = OS_AtomicLoad(&queue->pop_index, MemoryOrder_Relaxed);\
+}\
+}\
+*out = cell->data;\
+OS_AtomicStore(&cell->sequence, pos + queue->mask + 1, MemoryOrder_Release);\
 return true;\
 }\
+void Data##_mpmc_queue##_free(Data##_mpmc_queue* queue) {\
+M_Free(queue->cells);\
+MemoryZeroStruct(queue, Data##_mpmc_queue);\
+}
+
+//~ Swiss Table
+
+// NOTE(voxel): Open addressing in the style of abseil's swiss tables. Next to the entries is
+// one control byte per slot: the top bit set means empty (or deleted), otherwise the low 7
+// bits are a fragment of the key's hash. Lookups check a whole group of 16 control bytes
+// against the fragment with one SSE2 compare and only look at keys whose fragment matched,
+// so a miss almost never touches a key. Deleting marks the control byte, keys and values
+// don't need a null or tombstone representation of their own.
+// Groups get probed in triangular steps, which visits every group once since the group
+// count is a power of two. A group that still has an empty slot ends a probe.
+// Entries don't move unless the table grows (or gets rebuilt to clear out deleted slots)
+
+#define SwissTable_GroupSize 16
+#define SwissTable_Empty   ((i8) 0x80)
+#define SwissTable_Deleted ((i8) 0xFE)
+// Out of 8, counting deleted slots
+#define SwissTable_MaxLoad 7
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+
+static inline u32 SwissTable_Match(i8* group, i8 fragment) {
+	__m128i ctrl = _mm_loadu_si128((__m128i*) group);
+	return (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(fragment)));
+}
+
+// Both empty and deleted have the top bit set, so it's just the sign bits
+static inline u32 SwissTable_MatchFree(i8* group) {
+	return (u32) _mm_movemask_epi8(_mm_loadu_si128((__m128i*) group));
+}
+#else
+static inline u32 SwissTable_Match(i8* group, i8 fragment) {
+	u32 mask = 0;
+	for (u32 i = 0; i < SwissTable_GroupSize; i++) mask |= (u32) (group[i] == fragment) << i;
+	return mask;
+}
+
+static inline u32 SwissTable_MatchFree(i8* group) {
+	u32 mask = 0;
+	for (u32 i = 0; i < SwissTable_GroupSize; i++) mask |= (u32) (group[i] < 0) << i;
+	return mask;
+}
+#endif
+
+static inline u32 SwissTable_MatchEmpty(i8* group) {
+	return SwissTable_Match(group, SwissTable_Empty);
+}
+
+// The hash gets the same multiply as in StableTable_Slot, which carries every bit of it up
+// to the top. The product is then split two ways instead of folded into one slot: the group
+// is its low bits xored with the ones 32 up, the fragment is its top 7 bits. Those only
+// overlap past 2^25 groups, below that a group match says nothing about the fragment
+static inline u64 SwissTable_Mix(u64 hash) {
+	return hash * 0x9E3779B97F4A7C15ull;
+}
+static inline u64 SwissTable_Group(u64 mixed, u64 group_mask) {
+	return (mixed ^ (mixed >> 32)) & group_mask;
+}
+static inline i8 SwissTable_Fragment(u64 mixed) {
+	return (i8) (mixed >> 57);
+}
+
+#define swiss_table_key(key, value) key##_##value##_swiss_table_key
+#define swiss_table_value(key, value) key##_##value##_swiss_table_value
+#define swiss_table_entry(key, value) key##_##value##_swiss_table_entry
+#define swiss_table(key, value) key##_##value##_swiss_table
+
+#define swiss_table_init(key_t, value_t, table) key_t##_##value_t##_swiss_table_init(table)
+#define swiss_table_reserve(key_t, value_t, table, count) key_t##_##value_t##_swiss_table_reserve(table, count)
+#define swiss_table_set(key_t, value_t, table, key, val) key_t##_##value_t##_swiss_table_set(table, key, val)
+#define swiss_table_get(key_t, value_t, table, key, val) key_t##_##value_t##_swiss_table_get(table, key, val)
+#define swiss_table_get_ptr(key_t, value_t, table, key, val) key_t##_##value_t##_swiss_table_get_ptr(table, key, val)
+#define swiss_table_del(key_t, value_t, table, key) key_t##_##value_t##_swiss_table_del(table, key)
+#define swiss_table_clear(key_t, value_t, table) key_t##_##value_t##_swiss_table_clear(table)
+#define swiss_table_free(key_t, value_t, table) key_t##_##value_t##_swiss_table_free(table)
+
+// Deleting `it` inside the loop is fine, inserting anything is not
+#define swiss_table_foreach(key_t, value_t, table, it)\
+for (key_t##_##value_t##_swiss_table_entry* it = key_t##_##value_t##_swiss_table_next(table, nullptr);\
+it; it = key_t##_##value_t##_swiss_table_next(table, it))
+
+#define SwissTable_Prototype(Key, Value)\
+typedef Key Key##_##Value##_swiss_table_key;\
+typedef Value Key##_##Value##_swiss_table_value;\
+typedef struct Key##_##Value##_swiss_table_entry {\
+Key##_##Value##_swiss_table_key key;\
+Key##_##Value##_swiss_table_value value;\
+} Key##_##Value##_swiss_table_entry;\
+typedef struct Key##_##Value##_swiss_table {\
+u64 cap;\
+u64 len;\
+u64 deleted;\
+i8* ctrl;\
+Key##_##Value##_swiss_table_entry* elems;\
+} Key##_##Value##_swiss_table;\
+void Key##_##Value##_swiss_table_init(Key##_##Value##_swiss_table* table);\
+void Key##_##Value##_swiss_table_free(Key##_##Value##_swiss_table* table);\
+void Key##_##Value##_swiss_table_reserve(Key##_##Value##_swiss_table* table, u64 count);\
+b8 Key##_##Value##_swiss_table_get(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, Key##_##Value##_swiss_table_value* val);\
+b8 Key##_##Value##_swiss_table_get_ptr(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, Key##_##Value##_swiss_table_value** val);\
+b8 Key##_##Value##_swiss_table_set(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, Key##_##Value##_swiss_table_value val);\
+b8 Key##_##Value##_swiss_table_del(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key);\
+void Key##_##Value##_swiss_table_clear(Key##_##Value##_swiss_table* table);\
+Key##_##Value##_swiss_table_entry* Key##_##Value##_swiss_table_next(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_entry* curr);
+
+#define SwissTable_Impl(Key, Value, KeyIsEqual, HashKey)\
+void Key##_##Value##_swiss_table_init(Key##_##Value##_swiss_table* table) {\
+MemoryZeroStruct(table, Key##_##Value##_swiss_table);\
+}\
+void Key##_##Value##_swiss_table_free(Key##_##Value##_swiss_table* table) {\
+M_Free(table->ctrl);\
+MemoryZeroStruct(table, Key##_##Value##_swiss_table);\
+}\
+static i64 Key##_##Value##_swiss_table_find(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, u64 mixed) {\
+if (!table->cap) return -1;\
+u64 group_mask = table->cap / SwissTable_GroupSize - 1;\
+u64 group = SwissTable_Group(mixed, group_mask);\
+i8 fragment = SwissTable_Fragment(mixed);\
+for (u64 probe = 1; probe <= group_mask + 1; probe++) {\
+i8* ctrl = table->ctrl + group * SwissTable_GroupSize;\
+for (u32 match = SwissTable_Match(ctrl, fragment); match; match &= match - 1) {\
+u64 index = group * SwissTable_GroupSize + bit_scan_forward(match);\
+if (KeyIsEqual(table->elems[index].key, key)) return (i64) index;\
+}\
+if (SwissTable_MatchEmpty(ctrl)) return -1;\
+group = (group + probe) & group_mask;\
+}\
+return -1;\
+}\
+static u64 Key##_##Value##_swiss_table_find_free(i8* ctrl_base, u64 cap, u64 mixed) {\
+u64 group_mask = cap / SwissTable_GroupSize - 1;\
+u64 group = SwissTable_Group(mixed, group_mask);\
+for (u64 probe = 1;; probe++) {\
+u32 free_mask = SwissTable_MatchFree(ctrl_base + group * SwissTable_GroupSize);\
+if (free_mask) return group * SwissTable_GroupSize + bit_scan_forward(free_mask);\
+group = (group + probe) & group_mask;\
+}\
+}\
+static void Key##_##Value##_swiss_table_rebuild(Key##_##Value##_swiss_table* table, u64 cap) {\
+u64 ctrl_size = cap;\
+i8* ctrl = M_Alloc(ctrl_size + cap * sizeof(Key##_##Value##_swiss_table_entry));\
+Key##_##Value##_swiss_table_entry* elems = (Key##_##Value##_swiss_table_entry*) (ctrl + ctrl_size);\
+memset(ctrl, SwissTable_Empty, ctrl_size);\
+for (u64 i = 0; i < table->cap; i++) {\
+if (table->ctrl[i] < 0) continue;\
+u64 mixed = SwissTable_Mix(HashKey(table->elems[i].key));\
+u64 index = Key##_##Value##_swiss_table_find_free(ctrl, cap, mixed);\
+ctrl[index] = SwissTable_Fragment(mixed);\
+elems[index] = table->elems[i];\
+}\
+M_Free(table->ctrl);\
+table->ctrl = ctrl;\
+table->elems = elems;\
+table->cap = cap;\
+table->deleted = 0;\
 }\
+void Key##_##Value##_swiss_table_reserve(Key##_##Value##_swiss_table* table, u64 count) {\
+u64 cap = table->cap ? table->cap : SwissTable_GroupSize;\
+while (count > cap / 8 * SwissTable_MaxLoad) cap *= 2;\
+if (cap != table->cap) Key##_##Value##_swiss_table_rebuild(table, cap);\
 }\
-one_before_curr = curr;\
+b8 Key##_##Value##_swiss_table_get(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, Key##_##Value##_swiss_table_value* val) {\
+i64 index = Key##_##Value##_swiss_table_find(table, key, SwissTable_Mix(HashKey(key)));\
+if (index < 0) return false;\
+if (val != nullptr) *val = table->elems[index].value;\
+return true;\
 }\
-curr = curr->hash_next;\
+b8 Key##_##Value##_swiss_table_get_ptr(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, Key##_##Value##_swiss_table_value** val) {\
+i64 index = Key##_##Value##_swiss_table_find(table, key, SwissTable_Mix(HashKey(key)));\
+if (index < 0) return false;\
+if (val != nullptr) *val = &table->elems[index].value;\
+return true;\
 }\
+b8 Key##_##Value##_swiss_table_set(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key, Key##_##Value##_swiss_table_value val) {\
+u64 mixed = SwissTable_Mix(HashKey(key));\
+i64 found = Key##_##Value##_swiss_table_find(table, key, mixed);\
+if (found >= 0) {\
+table->elems[found].value = val;\
 return false;\
+}\
+if (table->len + table->deleted + 1 > table->cap / 8 * SwissTable_MaxLoad) {\
+/* Mostly deleted slots means a rebuild at the same size is enough */\
+u64 cap = table->cap ? table->cap : SwissTable_GroupSize;\
+if (table->len + 1 > cap / 16 * SwissTable_MaxLoad) cap *= 2;\
+Key##_##Value##_swiss_table_rebuild(table, cap);\
+}\
+u64 index = Key##_##Value##_swiss_table_find_free(table->ctrl, table->cap, mixed);\
+if (table->ctrl[index] == SwissTable_Deleted) table->deleted--;\
+table->ctrl[index] = SwissTable_Fragment(mixed);\
+table->elems[index].key = key;\
+table->elems[index].value = val;\
+table->len++;\
+return true;\
+}\
+b8 Key##_##Value##_swiss_table_del(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_key key) {\
+i64 index = Key##_##Value##_swiss_table_find(table, key, SwissTable_Mix(HashKey(key)));\
+if (index < 0) return false;\
+/* A group that was never full never made a probe move on, so it can go straight back to empty */\
+if (SwissTable_MatchEmpty(table->ctrl + (index & ~(u64) (SwissTable_GroupSize - 1)))) {\
+table->ctrl[index] = SwissTable_Empty;\
+} else {\
+table->ctrl[index] = SwissTable_Deleted;\
+table->deleted++;\
+}\
+table->len--;\
+return true;\
+}\
+void Key##_##Value##_swiss_table_clear(Key##_##Value##_swiss_table* table) {\
+if (table->ctrl) memset(table->ctrl, SwissTable_Empty, table->cap);\
+table->len = 0;\
+table->deleted = 0;\
+}\
+Key##_##Value##_swiss_table_entry* Key##_##Value##_swiss_table_next(Key##_##Value##_swiss_table* table, Key##_##Value##_swiss_table_entry* curr) {\
+u64 index = curr ? (u64) (curr - table->elems) + 1 : 0;\
+for (; index < table->cap; index++) {\
+if (table->ctrl[index] >= 0) return &table->elems[index];\
+}\
+return nullptr;\
 }
 
 #endif //DS_H
@@ -0,0 +1,198 @@
+#include "jobs.h"
+#include <assert.h>
+
+//~ Chase-Lev Deque
+// Lê, Pop, Cohen and Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak
+// Memory Models". Fixed size instead of growable, see J_DEQUE_SIZE
+
+static b8 jobs_deque_push(J_Deque* deque, J_Job* job) {
+	i64 b = OS_AtomicLoad(&deque->bottom, MemoryOrder_Relaxed);
+	i64 t = OS_AtomicLoad(&deque->top, MemoryOrder_Acquire);
+	if (b - t >= J_DEQUE_SIZE) return false;
+	OS_AtomicStore(&deque->slots[b & (J_DEQUE_SIZE - 1)], job, MemoryOrder_Relaxed);
+	// Pairs with the acquire of bottom in jobs_deque_steal, the job is visible before the slot is
+	OS_AtomicStore(&deque->bottom, b + 1, MemoryOrder_Release);
+	return true;
+}
+
+// Owner only
+static J_Job* jobs_deque_pop(J_Deque* deque) {
+	i64 b = OS_AtomicLoad(&deque->bottom, MemoryOrder_Relaxed) - 1;
+	OS_AtomicStore(&deque->bottom, b, MemoryOrder_Relaxed);
+	OS_AtomicFence(MemoryOrder_SeqCst);
+	i64 t = OS_AtomicLoad(&deque->top, MemoryOrder_Relaxed);
+
+	if (t > b) {
+		OS_AtomicStore(&deque->bottom, b + 1, MemoryOrder_Relaxed);
+		return nullptr;
+	}
+
+	J_Job* job = OS_AtomicLoad(&deque->slots[b & (J_DEQUE_SIZE - 1)], MemoryOrder_Relaxed);
+	if (t == b) {
+		// Last one left, thieves might be going for it too
+		if (!OS_AtomicCompareExchange(&deque->top, &t, t + 1, MemoryOrder_SeqCst))
+			job = nullptr;
+		OS_AtomicStore(&deque->bottom, b + 1, MemoryOrder_Relaxed);
+	}
+	return job;
+}
+
+static J_Job* jobs_deque_steal(J_Deque* deque) {
+	i64 t = OS_AtomicLoad(&deque->top, MemoryOrder_Acquire);
+	OS_AtomicFence(MemoryOrder_SeqCst);
+	i64 b = OS_AtomicLoad(&deque->bottom, MemoryOrder_Acquire);
+	if (t >= b) return nullptr;
+
+	J_Job* job = OS_AtomicLoad(&deque->slots[t & (J_DEQUE_SIZE - 1)], MemoryOrder_Relaxed);
+	if (!OS_AtomicCompareExchange(&deque->top, &t, t + 1, MemoryOrder_SeqCst))
+		return nullptr;
+	return job;
+}
+
+//~ Workers
+
+static J_Worker* jobs_current_worker(void) {
+	ThreadContext* context = (ThreadContext*) OS_ThreadContextGet();
+	return context ? (J_Worker*) context->job_worker : nullptr;
+}
+
+static void jobs_execute(J_Job* job) {
+	job->func(job->data);
+	OS_AtomicFetchAdd(&job->counter->value, -1, MemoryOrder_AcqRel);
+}
+
+// xorshift64, only picks where to start looking for something to steal
+static u64 jobs_next_random(J_Worker* worker) {
+	worker->rng ^= worker->rng << 13;
+	worker->rng ^= worker->rng >> 7;
+	worker->rng ^= worker->rng << 17;
+	return worker->rng;
+}
+
+static b8 jobs_try_run_one(J_Worker* worker) {
+	J_Job* job = jobs_deque_pop(&worker->deque);
+	if (!job) {
+		J_System* system = worker->system;
+		u32 start = (u32) (jobs_next_random(worker) % system->worker_count);
+		for (u32 i = 0; i < system->worker_count && !job; i++) {
+			u32 victim = (start + i) % system->worker_count;
+			if (victim == worker->index) continue;
+			job = jobs_deque_steal(&system->workers[victim].deque);
+		}
+	}
+	if (!job) return false;
+	jobs_execute(job);
+	return true;
+}
+
+// NOTE(voxel): Idle workers yield for a while in case more work shows up right away, then
+// go to sleep on the system's semaphore. A worker announces itself in sleeping and looks at
+// the deques one last time before waiting, and jobs_run pushes before looking at sleeping,
+// with a seq_cst fence on both sides. So either the worker finds the job, or jobs_run finds
+// the worker and signals it. Extra signals only cost a spurious wake up
+#define J_IDLE_YIELDS 64
+
+static b8 jobs_any_queued(J_System* system) {
+	for (u32 i = 0; i < system->worker_count; i++) {
+		J_Deque* deque = &system->workers[i].deque;
+		if (OS_AtomicLoad(&deque->top, MemoryOrder_Relaxed) < OS_AtomicLoad(&deque->bottom, MemoryOrder_Relaxed))
+			return true;
+	}
+	return false;
+}
+
+static void jobs_idle(J_Worker* worker, u32* idle_rounds) {
+	if (*idle_rounds < J_IDLE_YIELDS) {
+		(*idle_rounds)++;
+		OS_ThreadYield();
+		return;
+	}
+	
+	J_System* system = worker->system;
+	OS_AtomicFetchAdd(&system->sleeping, 1, MemoryOrder_SeqCst);
+	OS_AtomicFence(MemoryOrder_SeqCst);
+	if (!jobs_any_queued(system) && OS_AtomicLoad(&system->running, MemoryOrder_Acquire))
+		OS_SemaphoreWait(&system->wake);
+	OS_AtomicFetchAdd(&system->sleeping, -1, MemoryOrder_Relaxed);
+	*idle_rounds = 0;
+}
+
+static u64 jobs_worker_main(void* context) {
+	J_Worker* worker = (J_Worker*) context;
+	tctx_init(&worker->context);
+	worker->context.job_worker = worker;
+
+	u32 idle_rounds = 0;
+	while (OS_AtomicLoad(&worker->system->running, MemoryOrder_Acquire)) {
+		if (jobs_try_run_one(worker)) idle_rounds = 0;
+		else jobs_idle(worker, &idle_rounds);
+	}
+
+	tctx_free(&worker->context);
+	return 0;
+}
+
+//~ Job System
+
+void jobs_init(J_System* system, u32 worker_count) {
+	ThreadContext* context = (ThreadContext*) OS_ThreadContextGet();
+	assert(context && "jobs_init needs a ThreadContext on the calling thread");
+
+	MemoryZeroStruct(system, J_System);
+	arena_init(&system->arena);
+	system->worker_count = worker_count ? worker_count : OS_ProcessorCount();
+	system->workers = arena_alloc_zero(&system->arena, system->worker_count * sizeof(J_Worker));
+	system->running = true;
+	OS_SemaphoreInit(&system->wake, 0);
+
+	for (u32 i = 0; i < system->worker_count; i++) {
+		J_Worker* worker = &system->workers[i];
+		worker->system = system;
+		worker->index = i;
+		worker->rng = 0x9E3779B97F4A7C15ull * (i + 1);
+	}
+
+	context->job_worker = &system->workers[0];
+	for (u32 i = 1; i < system->worker_count; i++) {
+		system->workers[i].thread = OS_ThreadCreate(jobs_worker_main, &system->workers[i]);
+	}
+}
+
+void jobs_free(J_System* system) {
+	OS_AtomicStore(&system->running, false, MemoryOrder_Release);
+	// Whoever isn't asleep yet sees running first
+	OS_SemaphoreSignal(&system->wake, system->worker_count);
+	for (u32 i = 1; i < system->worker_count; i++) {
+		OS_ThreadWaitForJoin(&system->workers[i].thread);
+	}
+
+	ThreadContext* context = (ThreadContext*) OS_ThreadContextGet();
+	context->job_worker = nullptr;
+	OS_SemaphoreFree(&system->wake);
+	arena_free(&system->arena);
+}
+
+void jobs_run(J_Job* jobs, u32 count, J_Counter* counter) {
+	J_Worker* worker = jobs_current_worker();
+	assert(worker && "jobs_run has to be called from a job system worker");
+
+	OS_AtomicFetchAdd(&counter->value, count, MemoryOrder_Release);
+	for (u32 i = 0; i < count; i++) {
+		jobs[i].counter = counter;
+		if (!jobs_deque_push(&worker->deque, &jobs[i])) jobs_execute(&jobs[i]);
+	}
+
+	OS_AtomicFence(MemoryOrder_SeqCst);
+	u32 sleeping = OS_AtomicLoad(&worker->system->sleeping, MemoryOrder_Relaxed);
+	if (sleeping) OS_SemaphoreSignal(&worker->system->wake, Min(sleeping, count));
+}
+
+void jobs_wait(J_Counter* counter) {
+	J_Worker* worker = jobs_current_worker();
+	assert(worker && "jobs_wait has to be called from a job system worker");
+
+	while (OS_AtomicLoad(&counter->value, MemoryOrder_Acquire) > 0) {
+		// Whatever is left is already running on other workers, sleeping would only add latency
+		if (!jobs_try_run_one(worker)) OS_ThreadYield();
+	}
+}
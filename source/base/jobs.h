@@ -0,0 +1,83 @@
+/* date = October 19th 2026 5:02 pm */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "defines.h"
+#include "mem.h"
+#include "os/os.h"
+
+//~ Job System
+
+// NOTE(voxel): Every worker owns a Chase-Lev deque. It pushes and pops jobs at the bottom,
+// and workers that ran out of their own jobs steal from the top of someone else's. The
+// thread that calls jobs_init becomes worker 0, so it has to be the one that frees the
+// system. Jobs can be started from any worker, including from inside other jobs.
+//
+// Workers get their own ThreadContext, so scratch_get works inside a job.
+//
+//   J_Job jobs[64];
+//   for (u32 i = 0; i < 64; i++) jobs[i] = (J_Job) { LoadThumbnail, &thumbnails[i] };
+//   J_Counter counter = {0};
+//   jobs_run(jobs, 64, &counter);
+//   jobs_wait(&counter);
+//
+// The jobs array has to stay alive until the counter gets waited on
+
+typedef void J_JobFunc(void* data);
+
+typedef struct J_Counter {
+	i64 value;
+} J_Counter;
+
+typedef struct J_Job {
+	J_JobFunc* func;
+	void* data;
+	// Set by jobs_run
+	J_Counter* counter;
+} J_Job;
+
+// Has to be a power of two. A worker that runs out of room runs the job right away
+#define J_DEQUE_SIZE 4096
+
+typedef struct J_Deque {
+	// top and bottom are written by different threads, so each gets a cache line
+	cache_line_aligned i64 top;
+	cache_line_aligned i64 bottom;
+	cache_line_aligned J_Job* slots[J_DEQUE_SIZE];
+} J_Deque;
+
+typedef struct J_System J_System;
+
+// NOTE(voxel): Aligned so the fields after the deque (rng gets written on every steal)
+// don't share a line with the next worker's top. The workers array is the first thing in
+// its arena, which starts on a page
+typedef struct J_Worker {
+	cache_line_aligned J_Deque deque;
+	J_System* system;
+	ThreadContext context;
+	OS_Thread thread;
+	u32 index;
+	u64 rng;
+} J_Worker;
+
+struct J_System {
+	M_Arena arena;
+	J_Worker* workers;
+	u32 worker_count;
+	b32 running;
+	// Idle workers wait on wake, sleeping is how many might be
+	OS_Semaphore wake;
+	u32 sleeping;
+};
+
+// worker_count includes the calling thread, 0 picks one worker per processor
+void jobs_init(J_System* system, u32 worker_count);
+void jobs_free(J_System* system);
+
+// Both only work on a worker thread, or the thread that called jobs_init
+void jobs_run(J_Job* jobs, u32 count, J_Counter* counter);
+// Runs other jobs while waiting, so it's fine to call from inside a job
+void jobs_wait(J_Counter* counter);
+
+#endif //JOBS_H
@@ -1,4 +1,7 @@
+// The tracing macros in mem.h would relabel every call mem.c makes to itself
+#define M_TRACE_INTERNAL
 #include "mem.h"
+#include "bits.h"
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
@@ -9,6 +12,25 @@
 
 #define DEFAULT_ALIGNMENT sizeof(void*)
 
+#if defined(M_TRACE)
+typedef u32 M_TraceEventKind;
+enum {
+	TraceEvent_None,
+	TraceEvent_ArenaAlloc,    // offset and size inside the arena at memory
+	TraceEvent_ArenaPop,      // Everything at offset or past it is gone
+	TraceEvent_PoolAlloc,     // offset is the element's address
+	TraceEvent_PoolFree,
+	TraceEvent_PoolClear,
+	TraceEvent_ScratchGet,    // memory is the block
+	TraceEvent_ScratchReturn,
+};
+
+static void mem_trace_event(M_TraceEventKind kind, void* memory, u64 offset, u64 size);
+#  define MemTrace(kind, memory, offset, size) mem_trace_event(kind, memory, offset, size)
+#else
+#  define MemTrace(kind, memory, offset, size)
+#endif
+
 b8 is_power_of_two(uintptr_t x) {
 	return (x & (x-1)) == 0;
 }
@@ -34,6 +56,15 @@ u64 align_forward_u64(u64 ptr, u64 align) {
 
 //~ Arena
 
+// Where a commit has to end for everything up to pos to be usable. Aligned in the address
+// space and not relative to the arena, huge pages only ever back aligned ranges
+static u64 arena_commit_end(M_Arena* arena, u64 pos) {
+    u64 granularity = arena->huge_pages ? M_ARENA_HUGE_PAGE_SIZE : M_ARENA_COMMIT_SIZE;
+    u64 base = (u64) arena->memory;
+    u64 end = align_forward_u64(base + pos, granularity) - base;
+    return end < arena->max ? end : arena->max;
+}
+
 void* arena_alloc(M_Arena* arena, u64 size) {
     void* memory = 0;
 	
@@ -42,16 +73,12 @@ void* arena_alloc(M_Arena* arena, u64 size) {
 	
     if (arena->alloc_position + size > arena->commit_position) {
         if (!arena->static_size) {
-            u64 commit_size = size;
-            
-            commit_size += M_ARENA_COMMIT_SIZE - 1;
-            commit_size -= commit_size % M_ARENA_COMMIT_SIZE;
-            
-            if (arena->commit_position >= arena->max) {
+            if (arena->alloc_position + size > arena->max) {
                 assert(0 && "Arena is out of memory");
             } else {
-                OS_MemoryCommit(arena->memory + arena->commit_position, commit_size);
-                arena->commit_position += commit_size;
+                u64 commit_end = arena_commit_end(arena, arena->alloc_position + size);
+                OS_MemoryCommit(arena->memory + arena->commit_position, commit_end - arena->commit_position);
+                arena->commit_position = commit_end;
             }
         } else {
             assert(0 && "Static-Size Arena is out of memory");
@@ -59,7 +86,12 @@ void* arena_alloc(M_Arena* arena, u64 size) {
     }
     
     memory = arena->memory + arena->alloc_position;
+    MemTrace(TraceEvent_ArenaAlloc, arena->memory, arena->alloc_position, size);
     arena->alloc_position += size;
+    if (arena->alloc_position > arena->window_high_water) {
+        arena->window_high_water = arena->alloc_position;
+        if (arena->alloc_position > arena->high_water) arena->high_water = arena->alloc_position;
+    }
     return memory;
 }
 
@@ -73,12 +105,14 @@ void arena_dealloc(M_Arena* arena, u64 size) {
     if (size > arena->alloc_position)
         size = arena->alloc_position;
     arena->alloc_position -= size;
+    MemTrace(TraceEvent_ArenaPop, arena->memory, arena->alloc_position, 0);
 }
 
 void arena_dealloc_to(M_Arena* arena, u64 pos) {
     if (pos > arena->max) pos = arena->max;
     if (pos < 0) pos = 0;
     arena->alloc_position = pos;
+    MemTrace(TraceEvent_ArenaPop, arena->memory, pos, 0);
 }
 
 void* arena_raise(M_Arena* arena, void* ptr, u64 size) {
@@ -87,6 +121,15 @@ void* arena_raise(M_Arena* arena, void* ptr, u64 size) {
     return raised;
 }
 
+b8 arena_extend(M_Arena* arena, void* ptr, u64 size, u64 new_size) {
+    u64 end = align_forward_u64(size, DEFAULT_ALIGNMENT);
+    if ((u8*) ptr + end != arena->memory + arena->alloc_position) return false;
+    u64 new_end = align_forward_u64(new_size, DEFAULT_ALIGNMENT);
+    if (new_end > end) arena_alloc(arena, new_end - end);
+    else arena_dealloc(arena, end - new_end);
+    return true;
+}
+
 void* arena_alloc_array_sized(M_Arena* arena, u64 elem_size, u64 count) {
     return arena_alloc(arena, elem_size * count);
 }
@@ -109,14 +152,42 @@ void arena_init_sized(M_Arena* arena, u64 max) {
     arena->static_size = false;
 }
 
+void arena_init_huge(M_Arena* arena, u64 max) {
+    arena_init_sized(arena, max);
+    arena->huge_pages = true;
+    OS_MemoryAdviseHugePages(arena->memory, arena->max);
+}
+
 void arena_clear(M_Arena* arena) {
     arena_dealloc(arena, arena->alloc_position);
+    if (arena->static_size) return;
+    
+    if (++arena->window_clears < M_ARENA_DECOMMIT_WINDOW) return;
+    u64 keep = arena_commit_end(arena, arena->window_high_water);
+    if (arena->commit_position > keep && arena->commit_position - keep >= M_ARENA_DECOMMIT_MIN) {
+        OS_MemoryDecommit(arena->memory + keep, arena->commit_position - keep);
+        arena->decommitted += arena->commit_position - keep;
+        arena->commit_position = keep;
+    }
+    arena->window_high_water = 0;
+    arena->window_clears = 0;
 }
 
 void arena_free(M_Arena* arena) {
+    MemTrace(TraceEvent_ArenaPop, arena->memory, 0, 0);
     OS_MemoryRelease(arena->memory, arena->max);
 }
 
+M_ArenaStats arena_get_stats(M_Arena* arena) {
+    return (M_ArenaStats) {
+        .reserved = arena->max,
+        .committed = arena->commit_position,
+        .live = arena->alloc_position,
+        .peak = arena->high_water,
+        .decommitted = arena->decommitted,
+    };
+}
+
 //~ Temp arena
 
 M_ArenaTemp arena_begin_temp(M_Arena* arena) {
@@ -131,16 +202,27 @@ void arena_end_temp(M_ArenaTemp temp) {
 
 M_Scratch scratch_get(void) {
 	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+#if defined(M_TRACE)
+	// Getting a new block allocates from the thread's arena, which takes the label first
+	const char* label = ctx->trace_label;
+	M_Scratch scratch = tctx_scratch_get(ctx);
+	ctx->trace_label = label;
+	MemTrace(TraceEvent_ScratchGet, scratch.arena.memory, 0, M_SCRATCH_SIZE);
+	return scratch;
+#else
 	return tctx_scratch_get(ctx);
+#endif
 }
 
 void scratch_reset(M_Scratch* scratch) {
 	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
 	tctx_scratch_reset(ctx, scratch);
+	MemTrace(TraceEvent_ArenaPop, scratch->arena.memory, 0, 0);
 }
 
 void scratch_return(M_Scratch* scratch) {
 	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+	MemTrace(TraceEvent_ScratchReturn, scratch->arena.memory, 0, 0);
 	tctx_scratch_return(ctx, scratch);
 }
 
@@ -156,6 +238,7 @@ void pool_init(M_Pool* pool, u64 element_size) {
 }
 
 void pool_clear(M_Pool* pool) {
+	MemTrace(TraceEvent_PoolClear, pool->memory, 0, 0);
 	for (u8* it = (u8*)pool + sizeof(M_Pool), *preit = it;
 		 it <= (u8*)pool->memory + pool->commit_position;
 		 preit = it, it += pool->element_size) {
@@ -165,37 +248,791 @@ void pool_clear(M_Pool* pool) {
 }
 
 void pool_free(M_Pool* pool) {
+	MemTrace(TraceEvent_PoolClear, pool->memory, 0, 0);
 	OS_MemoryRelease(pool->memory, pool->max);
 }
 
+// Same as pool_dealloc_range, for memory that was never handed out
+static void pool_push_range(M_Pool* pool, void* ptr, u64 count) {
+	u8* it = ptr;
+	for (u64 k = 0; k < count; k++) {
+		((M_PoolFreeNode*)it)->next = pool->head;
+		pool->head = (M_PoolFreeNode*) it;
+		it += pool->element_size;
+	}
+}
+
 void* pool_alloc(M_Pool* pool) {
 	if (pool->head) {
 		void* ret = pool->head;
 		pool->head = pool->head->next;
+		MemTrace(TraceEvent_PoolAlloc, pool->memory, (u64) ret, pool->element_size);
 		return ret;
 	} else {
-		if (pool->commit_position + M_POOL_COMMIT_CHUNK * pool->element_size >= pool->max) {
+		// Commits have to stay page aligned, the tail that doesn't fit an element is skipped
+		u64 commit_size = M_POOL_COMMIT_CHUNK * pool->element_size;
+		commit_size += M_ARENA_COMMIT_SIZE - 1;
+		commit_size -= commit_size % M_ARENA_COMMIT_SIZE;
+		
+		if (pool->commit_position + commit_size >= pool->max) {
 			assert(0 && "Pool is out of memory");
 			return nullptr;
 		}
 		void* commit_ptr = pool->memory + pool->commit_position;
-		OS_MemoryCommit(commit_ptr, M_POOL_COMMIT_CHUNK * pool->element_size);
-		pool_dealloc_range(pool, commit_ptr, M_POOL_COMMIT_CHUNK);
+		OS_MemoryCommit(commit_ptr, commit_size);
+		pool->commit_position += commit_size;
+		pool_push_range(pool, commit_ptr, commit_size / pool->element_size);
 		
 		return pool_alloc(pool);
 	}
 }
 
 void pool_dealloc(M_Pool* pool, void* ptr) {
+	MemTrace(TraceEvent_PoolFree, pool->memory, (u64) ptr, 0);
 	((M_PoolFreeNode*)ptr)->next = pool->head;
 	pool->head = ptr;
 }
 
 void pool_dealloc_range(M_Pool* pool, void* ptr, u64 count) {
-	u8* it = ptr;
+#if defined(M_TRACE)
 	for (u64 k = 0; k < count; k++) {
-		((M_PoolFreeNode*)it)->next = pool->head;
-		pool->head = (M_PoolFreeNode*) it;
-		it += pool->element_size;
+		MemTrace(TraceEvent_PoolFree, pool->memory, (u64) ((u8*) ptr + k * pool->element_size), 0);
+	}
+#endif
+	pool_push_range(pool, ptr, count);
+}
+
+//~ Heap
+
+// Blocks start past the header, 64 keeps every class at least as aligned as malloc's
+#define M_HEAP_SLAB_HEADER 64
+#define M_HEAP_LARGE_HEADER 64
+
+typedef struct M_HeapSlab {
+	M_Heap* owner;
+	u32 class_index;
+} M_HeapSlab;
+
+typedef struct M_HeapLarge {
+	u64 reserved; // Header included
+} M_HeapLarge;
+
+struct M_Heap {
+	M_PoolFreeNode* free[M_HEAP_CLASS_COUNT];
+	// What's left of the slab each class is carving blocks out of
+	u8* bump[M_HEAP_CLASS_COUNT];
+	u8* bump_end[M_HEAP_CLASS_COUNT];
+	// Other threads push, the owner only ever takes the whole list
+	M_PoolFreeNode* remote_free;
+	M_Heap* next;
+	b8 abandoned;
+	// Indexed like m_heap.site_keys. Only the owner writes, heap_get_call_sites adds them up
+	u64 site_allocations[M_HEAP_MAX_CALL_SITES];
+	u64 site_bytes[M_HEAP_MAX_CALL_SITES];
+};
+
+static struct {
+	// 0 until someone starts initializing, 2 once it's done
+	u32 init_state;
+	// Guards the slab pool and the heap list
+	OS_Mutex lock;
+	M_Pool slabs;
+	M_Arena heap_arena;
+	M_Heap* first_heap;
+	// For threads without a ThreadContext
+	OS_Mutex shared_lock;
+	M_Heap* shared;
+	// The file pointer in the low 48 bits and the line above it, 0 is an empty slot
+	u64 site_keys[M_HEAP_MAX_CALL_SITES];
+} m_heap;
+
+static M_Heap* heap_new(void) {
+	M_Heap* heap = arena_alloc_zero(&m_heap.heap_arena, sizeof(M_Heap));
+	heap->next = m_heap.first_heap;
+	m_heap.first_heap = heap;
+	return heap;
+}
+
+static void heap_init(void) {
+	if (OS_AtomicLoad(&m_heap.init_state, MemoryOrder_Acquire) == 2) return;
+	
+	u32 expected = 0;
+	if (OS_AtomicCompareExchange(&m_heap.init_state, &expected, 1, MemoryOrder_AcqRel)) {
+		OS_MutexInit(&m_heap.lock);
+		OS_MutexInit(&m_heap.shared_lock);
+		pool_init(&m_heap.slabs, M_HEAP_SLAB_SIZE);
+		arena_init(&m_heap.heap_arena);
+		m_heap.shared = heap_new();
+		OS_AtomicStore(&m_heap.init_state, 2, MemoryOrder_Release);
+	} else {
+		while (OS_AtomicLoad(&m_heap.init_state, MemoryOrder_Acquire) != 2) OS_ThreadYield();
+	}
+}
+
+static u32 heap_class_index(u64 size) {
+	if (size <= 128) return size ? (u32) ((size - 1) >> 4) : 0;
+	u64 s = size - 1;
+	u32 p = bit_scan_reverse(s);
+	return 8 + (p - 7) * 4 + (u32) ((s >> (p - 2)) & 3);
+}
+
+static u64 heap_class_size(u32 index) {
+	if (index < 8) return (index + 1) * 16;
+	u32 j = index - 8;
+	u32 p = 7 + j / 4;
+	return (1ull << p) + (j % 4 + 1) * (1ull << (p - 2));
+}
+
+static b8 heap_is_small(void* ptr) {
+	return (u8*) ptr >= m_heap.slabs.memory && (u8*) ptr < m_heap.slabs.memory + m_heap.slabs.max;
+}
+
+static M_HeapSlab* heap_slab_of(void* ptr) {
+	u64 offset = (u8*) ptr - m_heap.slabs.memory;
+	return (M_HeapSlab*) (m_heap.slabs.memory + offset - offset % M_HEAP_SLAB_SIZE);
+}
+
+static void heap_collect_remote(M_Heap* heap) {
+	M_PoolFreeNode* node = OS_AtomicExchange(&heap->remote_free, nullptr, MemoryOrder_Acquire);
+	while (node) {
+		M_PoolFreeNode* next = node->next;
+		u32 index = heap_slab_of(node)->class_index;
+		node->next = heap->free[index];
+		heap->free[index] = node;
+		node = next;
 	}
 }
+
+// Adopts a heap some thread left behind if there is one
+static M_Heap* heap_acquire(void) {
+	OS_MutexLock(&m_heap.lock);
+	M_Heap* heap = m_heap.first_heap;
+	while (heap && !heap->abandoned) heap = heap->next;
+	if (heap) heap->abandoned = false;
+	else heap = heap_new();
+	OS_MutexUnlock(&m_heap.lock);
+	return heap;
+}
+
+void heap_abandon(M_Heap* heap) {
+	OS_MutexLock(&m_heap.lock);
+	heap->abandoned = true;
+	OS_MutexUnlock(&m_heap.lock);
+}
+
+static void* heap_alloc_slow(M_Heap* heap, u32 index) {
+	u64 block_size = heap_class_size(index);
+	
+	if ((u64) (heap->bump_end[index] - heap->bump[index]) < block_size) {
+		// Anything other threads gave back comes before a new slab
+		heap_collect_remote(heap);
+		M_PoolFreeNode* node = heap->free[index];
+		if (node) {
+			heap->free[index] = node->next;
+			return node;
+		}
+		
+		OS_MutexLock(&m_heap.lock);
+#if defined(M_TRACE)
+		mem_trace_label("heap slab");
+#endif
+		M_HeapSlab* slab = pool_alloc(&m_heap.slabs);
+		OS_MutexUnlock(&m_heap.lock);
+		if (!slab) return nullptr;
+		
+		slab->owner = heap;
+		slab->class_index = index;
+		heap->bump[index] = (u8*) slab + M_HEAP_SLAB_HEADER;
+		heap->bump_end[index] = (u8*) slab + M_HEAP_SLAB_SIZE;
+	}
+	
+	void* block = heap->bump[index];
+	heap->bump[index] += block_size;
+	return block;
+}
+
+static void* heap_alloc_small(M_Heap* heap, u32 index) {
+	M_PoolFreeNode* node = heap->free[index];
+	if (node) {
+		heap->free[index] = node->next;
+		return node;
+	}
+	return heap_alloc_slow(heap, index);
+}
+
+static void* heap_alloc_large(u64 size) {
+	u64 reserved = align_forward_u64(size + M_HEAP_LARGE_HEADER, M_ARENA_COMMIT_SIZE);
+	u8* memory = OS_MemoryReserve(reserved);
+	OS_MemoryCommit(memory, reserved);
+	((M_HeapLarge*) memory)->reserved = reserved;
+	return memory + M_HEAP_LARGE_HEADER;
+}
+
+static u64 heap_usable_size(void* ptr) {
+	if (heap_is_small(ptr)) return heap_class_size(heap_slab_of(ptr)->class_index);
+	M_HeapLarge* header = (M_HeapLarge*) ((u8*) ptr - M_HEAP_LARGE_HEADER);
+	return header->reserved - M_HEAP_LARGE_HEADER;
+}
+
+// Returns M_HEAP_MAX_CALL_SITES once the table is full
+static u32 heap_call_site(const char* file, u32 line) {
+	u64 key = ((uintptr_t) file & 0xFFFFFFFFFFFFull) | ((u64) line << 48);
+	u32 index = (u32) ((key * 0x9E3779B97F4A7C15ull) >> 32) & (M_HEAP_MAX_CALL_SITES - 1);
+	for (u32 probe = 0; probe < M_HEAP_MAX_CALL_SITES; probe++) {
+		u64 current = OS_AtomicLoad(&m_heap.site_keys[index], MemoryOrder_Relaxed);
+		if (current == 0) {
+			// Whoever won the race might have claimed it for the same call site
+			OS_AtomicCompareExchange(&m_heap.site_keys[index], &current, key, MemoryOrder_Relaxed);
+			if (current == 0) return index;
+		}
+		if (current == key) return index;
+		index = (index + 1) & (M_HEAP_MAX_CALL_SITES - 1);
+	}
+	return M_HEAP_MAX_CALL_SITES;
+}
+
+// Single writer, so no read-modify-write has to be atomic, the stores only can't tear
+static void heap_count(M_Heap* heap, u32 site, u64 size) {
+	if (site == M_HEAP_MAX_CALL_SITES) return;
+	OS_AtomicStore(&heap->site_allocations[site], heap->site_allocations[site] + 1, MemoryOrder_Relaxed);
+	OS_AtomicStore(&heap->site_bytes[site], heap->site_bytes[site] + size, MemoryOrder_Relaxed);
+}
+
+void* heap_alloc(u64 size, const char* file, u32 line) {
+	heap_init();
+	u32 site = heap_call_site(file, line);
+	
+	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+	M_Heap* heap;
+	if (ctx) {
+		if (!ctx->heap) ctx->heap = heap_acquire();
+		heap = ctx->heap;
+	} else {
+		OS_MutexLock(&m_heap.shared_lock);
+		heap = m_heap.shared;
+	}
+	
+	heap_count(heap, site, size);
+	void* block = size > M_HEAP_MAX_SMALL ? heap_alloc_large(size) : heap_alloc_small(heap, heap_class_index(size));
+	
+	if (!ctx) OS_MutexUnlock(&m_heap.shared_lock);
+	return block;
+}
+
+void* heap_alloc_zero(u64 size, const char* file, u32 line) {
+	void* block = heap_alloc(size, file, line);
+	// Fresh reservations come zeroed from the OS
+	if (block && size <= M_HEAP_MAX_SMALL) memset(block, 0, size);
+	return block;
+}
+
+void* heap_realloc(void* ptr, u64 size, const char* file, u32 line) {
+	if (!ptr) return heap_alloc(size, file, line);
+	u64 usable = heap_usable_size(ptr);
+	if (size <= usable) return ptr;
+	
+	void* moved = heap_alloc(size, file, line);
+	if (moved) memcpy(moved, ptr, usable);
+	heap_free(ptr);
+	return moved;
+}
+
+void heap_free(void* ptr) {
+	if (!ptr) return;
+	if (!heap_is_small(ptr)) {
+		M_HeapLarge* header = (M_HeapLarge*) ((u8*) ptr - M_HEAP_LARGE_HEADER);
+		OS_MemoryRelease(header, header->reserved);
+		return;
+	}
+	
+	M_PoolFreeNode* node = (M_PoolFreeNode*) ptr;
+	M_Heap* owner = heap_slab_of(ptr)->owner;
+	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+	if (ctx && ctx->heap == owner) {
+		u32 index = heap_slab_of(ptr)->class_index;
+		node->next = owner->free[index];
+		owner->free[index] = node;
+		return;
+	}
+	
+	M_PoolFreeNode* head = OS_AtomicLoad(&owner->remote_free, MemoryOrder_Relaxed);
+	do {
+		node->next = head;
+	} while (!OS_AtomicCompareExchange(&owner->remote_free, &head, node, MemoryOrder_Release));
+}
+
+u32 heap_get_call_sites(M_HeapCallSite* out, u32 max) {
+	heap_init();
+	u32 count = 0;
+	OS_MutexLock(&m_heap.lock);
+	for (u32 i = 0; i < M_HEAP_MAX_CALL_SITES && count < max; i++) {
+		u64 key = OS_AtomicLoad(&m_heap.site_keys[i], MemoryOrder_Relaxed);
+		if (!key) continue;
+		
+		M_HeapCallSite* site = &out[count++];
+		site->file = (const char*) (uintptr_t) (key & 0xFFFFFFFFFFFFull);
+		site->line = (u32) (key >> 48);
+		site->allocations = 0;
+		site->bytes = 0;
+		for (M_Heap* heap = m_heap.first_heap; heap; heap = heap->next) {
+			site->allocations += OS_AtomicLoad(&heap->site_allocations[i], MemoryOrder_Relaxed);
+			site->bytes += OS_AtomicLoad(&heap->site_bytes[i], MemoryOrder_Relaxed);
+		}
+	}
+	OS_MutexUnlock(&m_heap.lock);
+	return count;
+}
+
+//~ Tracing
+
+#if defined(M_TRACE)
+
+#include "log.h"
+
+typedef struct M_TraceEvent {
+	u64 time;
+	const char* label;
+	u8* memory;
+	u64 offset;
+	u64 size;
+	M_TraceEventKind kind;
+	u32 thread;
+	// Per thread, keeps events with the same timestamp in the order they happened
+	u32 sequence;
+} M_TraceEvent;
+
+typedef struct M_TraceChunk M_TraceChunk;
+struct M_TraceChunk {
+	M_TraceChunk* next;
+	u32 thread;
+	u32 first_sequence;
+	// Only the owning thread writes, an event is in once count is past it
+	u32 count;
+	M_TraceEvent events[M_TRACE_CHUNK_EVENTS];
+};
+
+static struct {
+	// 0 until someone starts initializing, 2 once it's done
+	u32 init_state;
+	// Only ever pushed to
+	M_TraceChunk* chunks;
+	u32 chunk_count;
+	u32 thread_count;
+	u64 dropped;
+	b32 dumping;
+} m_trace;
+
+static void mem_trace_init(void) {
+	if (OS_AtomicLoad(&m_trace.init_state, MemoryOrder_Acquire) == 2) return;
+	
+	u32 expected = 0;
+	if (OS_AtomicCompareExchange(&m_trace.init_state, &expected, 1, MemoryOrder_AcqRel)) {
+		atexit(mem_trace_dump);
+		OS_AtomicStore(&m_trace.init_state, 2, MemoryOrder_Release);
+	} else {
+		while (OS_AtomicLoad(&m_trace.init_state, MemoryOrder_Acquire) != 2) OS_ThreadYield();
+	}
+}
+
+void mem_trace_label(const char* label) {
+	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+	if (ctx) ctx->trace_label = label;
+}
+
+static M_TraceChunk* mem_trace_new_chunk(ThreadContext* ctx) {
+	if (OS_AtomicLoad(&m_trace.chunk_count, MemoryOrder_Relaxed) >= M_TRACE_MAX_CHUNKS) return nullptr;
+	if (OS_AtomicFetchAdd(&m_trace.chunk_count, 1, MemoryOrder_Relaxed) >= M_TRACE_MAX_CHUNKS) return nullptr;
+	
+	M_TraceChunk* chunk = OS_MemoryReserve(sizeof(M_TraceChunk));
+	OS_MemoryCommit(chunk, sizeof(M_TraceChunk));
+	M_TraceChunk* previous = ctx->trace_chunk;
+	if (!previous) ctx->trace_thread = OS_AtomicFetchAdd(&m_trace.thread_count, 1, MemoryOrder_Relaxed);
+	chunk->thread = ctx->trace_thread;
+	chunk->first_sequence = previous ? previous->first_sequence + M_TRACE_CHUNK_EVENTS : 0;
+	
+	chunk->next = OS_AtomicLoad(&m_trace.chunks, MemoryOrder_Relaxed);
+	while (!OS_AtomicCompareExchange(&m_trace.chunks, &chunk->next, chunk, MemoryOrder_Release));
+	ctx->trace_chunk = chunk;
+	return chunk;
+}
+
+static void mem_trace_event(M_TraceEventKind kind, void* memory, u64 offset, u64 size) {
+	if (OS_AtomicLoad(&m_trace.dumping, MemoryOrder_Relaxed)) return;
+	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+	if (!ctx) return;
+	
+	// Taken either way, or it would end up on whatever comes next
+	const char* label = ctx->trace_label;
+	ctx->trace_label = nullptr;
+	if (kind == TraceEvent_ArenaAlloc && size == 0) return;
+	
+	mem_trace_init();
+	M_TraceChunk* chunk = ctx->trace_chunk;
+	if (!chunk || chunk->count == M_TRACE_CHUNK_EVENTS) chunk = mem_trace_new_chunk(ctx);
+	if (!chunk) {
+		OS_AtomicFetchAdd(&m_trace.dropped, 1, MemoryOrder_Relaxed);
+		return;
+	}
+	
+	M_TraceEvent* event = &chunk->events[chunk->count];
+	event->time = OS_TimeNanosecondsNow();
+	event->label = label ? label : "(unlabeled)";
+	event->memory = memory;
+	event->offset = offset;
+	event->size = size;
+	event->kind = kind;
+	event->thread = chunk->thread;
+	event->sequence = chunk->first_sequence + chunk->count;
+	OS_AtomicStore(&chunk->count, chunk->count + 1, MemoryOrder_Release);
+}
+
+//- Replay
+
+#define M_TRACE_MAX_LABELS 4096
+#define M_TRACE_MAX_ARENAS 4096
+
+typedef u32 M_TraceLabelKind;
+enum {
+	TraceLabel_Arena,
+	TraceLabel_Pool,
+	TraceLabel_Scratch,
+	TraceLabel_COUNT,
+};
+
+static const char* mem_trace_kind_names[TraceLabel_COUNT] = { "arena", "pool", "scratch" };
+
+typedef struct M_TraceLabelStats {
+	const char* label;
+	M_TraceLabelKind kind;
+	u64 count;
+	u64 bytes;
+	u64 live;
+	u64 live_count;
+	u64 peak;
+	u64 ended;
+	u64 lifetime;
+} M_TraceLabelStats;
+
+// Something that was allocated and hasn't gone away yet
+typedef struct M_TraceLive M_TraceLive;
+struct M_TraceLive {
+	// Down the arena's stack, or along the scratch blocks that are out
+	M_TraceLive* next;
+	u8* memory;
+	u64 offset;
+	u64 size;
+	u64 time;
+	u32 label;
+	u32 thread;
+};
+
+typedef struct M_TraceBucket {
+	u64 live[TraceLabel_COUNT];
+	u64 allocated;
+} M_TraceBucket;
+
+typedef struct M_TraceReplay {
+	M_Arena arena;
+	M_TraceLabelStats* labels;
+	u32 label_count;
+	// Open addressing on the arena's memory, each one leads the stack of what's live in it
+	u8** arena_keys;
+	M_TraceLive** arena_tops;
+	// Open addressing on the element's address
+	M_TraceLive** pool_slots;
+	u64 pool_mask;
+	M_TraceLive* scratch_out;
+	M_TraceBucket current;
+} M_TraceReplay;
+
+static int mem_trace_compare_events(const void* a, const void* b) {
+	const M_TraceEvent* x = (const M_TraceEvent*) a;
+	const M_TraceEvent* y = (const M_TraceEvent*) b;
+	if (x->time != y->time) return x->time < y->time ? -1 : 1;
+	if (x->thread != y->thread) return x->thread < y->thread ? -1 : 1;
+	return (x->sequence > y->sequence) - (x->sequence < y->sequence);
+}
+
+static int mem_trace_compare_labels(const void* a, const void* b) {
+	const M_TraceLabelStats* x = (const M_TraceLabelStats*) a;
+	const M_TraceLabelStats* y = (const M_TraceLabelStats*) b;
+	return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+static int mem_trace_compare_call_sites(const void* a, const void* b) {
+	const M_HeapCallSite* x = (const M_HeapCallSite*) a;
+	const M_HeapCallSite* y = (const M_HeapCallSite*) b;
+	return (x->bytes < y->bytes) - (x->bytes > y->bytes);
+}
+
+static u64 mem_trace_hash(u64 x) {
+	x ^= x >> 33;
+	x *= 0xFF51AFD7ED558CCDull;
+	x ^= x >> 33;
+	return x;
+}
+
+// The same file and line can be a different string in every translation unit that has it
+static u32 mem_trace_label_index(M_TraceReplay* replay, const char* label, M_TraceLabelKind kind) {
+	u64 hash = kind;
+	for (const char* c = label; *c; c++) hash = (hash ^ (u8) *c) * 0x100000001B3ull;
+	u32 index = (u32) mem_trace_hash(hash) & (M_TRACE_MAX_LABELS - 1);
+	for (u32 probe = 0; probe < M_TRACE_MAX_LABELS; probe++) {
+		M_TraceLabelStats* stats = &replay->labels[index];
+		if (!stats->label) {
+			stats->label = label;
+			stats->kind = kind;
+			replay->label_count++;
+			return index;
+		}
+		if (stats->kind == kind && (stats->label == label || strcmp(stats->label, label) == 0)) return index;
+		index = (index + 1) & (M_TRACE_MAX_LABELS - 1);
+	}
+	// Can't happen unless there are more call sites than slots, they share the last one then
+	return M_TRACE_MAX_LABELS - 1;
+}
+
+static M_TraceLive** mem_trace_arena_top(M_TraceReplay* replay, u8* memory) {
+	u32 index = (u32) mem_trace_hash((u64) memory) & (M_TRACE_MAX_ARENAS - 1);
+	for (u32 probe = 0; probe < M_TRACE_MAX_ARENAS; probe++) {
+		if (!replay->arena_keys[index]) replay->arena_keys[index] = memory;
+		if (replay->arena_keys[index] == memory) return &replay->arena_tops[index];
+		index = (index + 1) & (M_TRACE_MAX_ARENAS - 1);
+	}
+	return nullptr;
+}
+
+static M_TraceLive* mem_trace_begin(M_TraceReplay* replay, M_TraceEvent* event, M_TraceLabelKind kind) {
+	M_TraceLive* live = arena_alloc_zero(&replay->arena, sizeof(M_TraceLive));
+	live->memory = event->memory;
+	live->offset = event->offset;
+	live->size = event->size;
+	live->time = event->time;
+	live->thread = event->thread;
+	live->label = mem_trace_label_index(replay, event->label, kind);
+	
+	M_TraceLabelStats* stats = &replay->labels[live->label];
+	stats->count++;
+	stats->bytes += live->size;
+	stats->live += live->size;
+	stats->live_count++;
+	if (stats->live > stats->peak) stats->peak = stats->live;
+	replay->current.live[kind] += live->size;
+	replay->current.allocated += live->size;
+	return live;
+}
+
+static void mem_trace_end(M_TraceReplay* replay, M_TraceLive* live, u64 time) {
+	M_TraceLabelStats* stats = &replay->labels[live->label];
+	stats->live -= live->size;
+	stats->live_count--;
+	stats->ended++;
+	stats->lifetime += time - live->time;
+	replay->current.live[stats->kind] -= live->size;
+}
+
+static void mem_trace_arena_pop(M_TraceReplay* replay, u8* memory, u64 offset, u64 time) {
+	M_TraceLive** top = mem_trace_arena_top(replay, memory);
+	if (!top) return;
+	while (*top && (*top)->offset >= offset) {
+		mem_trace_end(replay, *top, time);
+		*top = (*top)->next;
+	}
+}
+
+static M_TraceLive** mem_trace_pool_slot(M_TraceReplay* replay, u64 address) {
+	u64 index = mem_trace_hash(address) & replay->pool_mask;
+	while (replay->pool_slots[index] && replay->pool_slots[index]->offset != address)
+		index = (index + 1) & replay->pool_mask;
+	return &replay->pool_slots[index];
+}
+
+// Backward shift, so lookups never have to step over tombstones
+static void mem_trace_pool_remove(M_TraceReplay* replay, M_TraceLive** slot) {
+	u64 hole = slot - replay->pool_slots;
+	u64 index = hole;
+	*slot = nullptr;
+	while (true) {
+		index = (index + 1) & replay->pool_mask;
+		M_TraceLive* live = replay->pool_slots[index];
+		if (!live) return;
+		u64 home = mem_trace_hash(live->offset) & replay->pool_mask;
+		// Only moves back if the hole is between where it wants to be and where it is
+		if (((index - home) & replay->pool_mask) >= ((index - hole) & replay->pool_mask)) {
+			replay->pool_slots[hole] = live;
+			replay->pool_slots[index] = nullptr;
+			hole = index;
+		}
+	}
+}
+
+static void mem_trace_replay_event(M_TraceReplay* replay, M_TraceEvent* event) {
+	switch (event->kind) {
+		case TraceEvent_ArenaAlloc: {
+			M_TraceLive* live = mem_trace_begin(replay, event, TraceLabel_Arena);
+			M_TraceLive** top = mem_trace_arena_top(replay, event->memory);
+			if (top) {
+				live->next = *top;
+				*top = live;
+			}
+		} break;
+		
+		case TraceEvent_ArenaPop: {
+			mem_trace_arena_pop(replay, event->memory, event->offset, event->time);
+		} break;
+		
+		case TraceEvent_PoolAlloc: {
+			M_TraceLive** slot = mem_trace_pool_slot(replay, event->offset);
+			if (*slot) {
+				mem_trace_end(replay, *slot, event->time);
+				*slot = nullptr;
+			}
+			*slot = mem_trace_begin(replay, event, TraceLabel_Pool);
+		} break;
+		
+		case TraceEvent_PoolFree: {
+			M_TraceLive** slot = mem_trace_pool_slot(replay, event->offset);
+			// pool_dealloc_range also gets used on memory that was never handed out
+			if (!*slot) break;
+			mem_trace_end(replay, *slot, event->time);
+			mem_trace_pool_remove(replay, slot);
+		} break;
+		
+		case TraceEvent_PoolClear: {
+			for (u64 i = 0; i <= replay->pool_mask; i++) {
+				M_TraceLive* live = replay->pool_slots[i];
+				if (!live || live->memory != event->memory) continue;
+				mem_trace_end(replay, live, event->time);
+				mem_trace_pool_remove(replay, &replay->pool_slots[i]);
+				// Whatever got shifted into i hasn't been looked at yet
+				i--;
+			}
+		} break;
+		
+		case TraceEvent_ScratchGet: {
+			mem_trace_arena_pop(replay, event->memory, 0, event->time);
+			M_TraceLive* live = mem_trace_begin(replay, event, TraceLabel_Scratch);
+			live->next = replay->scratch_out;
+			replay->scratch_out = live;
+		} break;
+		
+		case TraceEvent_ScratchReturn: {
+			mem_trace_arena_pop(replay, event->memory, 0, event->time);
+			for (M_TraceLive** it = &replay->scratch_out; *it; it = &(*it)->next) {
+				if ((*it)->memory != event->memory) continue;
+				mem_trace_end(replay, *it, event->time);
+				*it = (*it)->next;
+				break;
+			}
+		} break;
+	}
+}
+
+void mem_trace_dump(void) {
+	if (OS_AtomicExchange(&m_trace.dumping, true, MemoryOrder_Acquire)) return;
+	
+	//- Everything every thread logged, in order
+	u64 event_count = 0;
+	M_TraceChunk* first_chunk = OS_AtomicLoad(&m_trace.chunks, MemoryOrder_Acquire);
+	for (M_TraceChunk* chunk = first_chunk; chunk; chunk = chunk->next)
+		event_count += OS_AtomicLoad(&chunk->count, MemoryOrder_Acquire);
+	
+	M_Arena events_arena;
+	arena_init_sized(&events_arena, align_forward_u64((event_count + 1) * sizeof(M_TraceEvent), M_ARENA_COMMIT_SIZE));
+	M_TraceEvent* events = arena_alloc(&events_arena, event_count * sizeof(M_TraceEvent));
+	u64 pool_allocs = 0;
+	u64 copied = 0;
+	for (M_TraceChunk* chunk = first_chunk; chunk && copied < event_count; chunk = chunk->next) {
+		u64 count = Min((u64) OS_AtomicLoad(&chunk->count, MemoryOrder_Acquire), event_count - copied);
+		memcpy(events + copied, chunk->events, count * sizeof(M_TraceEvent));
+		copied += count;
+	}
+	qsort(events, copied, sizeof(M_TraceEvent), mem_trace_compare_events);
+	for (u64 i = 0; i < copied; i++) pool_allocs += events[i].kind == TraceEvent_PoolAlloc;
+	
+	//- Replay
+	M_TraceReplay replay = {0};
+	arena_init(&replay.arena);
+	replay.labels = arena_alloc_zero(&replay.arena, M_TRACE_MAX_LABELS * sizeof(M_TraceLabelStats));
+	replay.arena_keys = arena_alloc_zero(&replay.arena, M_TRACE_MAX_ARENAS * sizeof(u8*));
+	replay.arena_tops = arena_alloc_zero(&replay.arena, M_TRACE_MAX_ARENAS * sizeof(M_TraceLive*));
+	u64 pool_cap = 64;
+	while (pool_cap < pool_allocs * 2) pool_cap *= 2;
+	replay.pool_mask = pool_cap - 1;
+	replay.pool_slots = arena_alloc_zero(&replay.arena, pool_cap * sizeof(M_TraceLive*));
+	
+	u64 start = copied ? events[0].time : 0;
+	u64 end = copied ? events[copied - 1].time : 0;
+	u64 bucket_count = (end - start) / M_TRACE_BUCKET_NS + 1;
+	M_TraceBucket* buckets = arena_alloc_zero(&replay.arena, bucket_count * sizeof(M_TraceBucket));
+	u64 bucket = 0;
+	for (u64 i = 0; i < copied; i++) {
+		u64 event_bucket = (events[i].time - start) / M_TRACE_BUCKET_NS;
+		while (bucket < event_bucket) {
+			buckets[bucket++] = replay.current;
+			replay.current.allocated = 0;
+		}
+		mem_trace_replay_event(&replay, &events[i]);
+	}
+	buckets[bucket] = replay.current;
+	
+	//- Report
+	FILE* out = fopen(M_TRACE_OUTPUT, "w");
+	if (!out) {
+		LogError("[Mem Trace] Couldn't open %s", M_TRACE_OUTPUT);
+	} else {
+		fprintf(out, "%llu events from %u threads over %.3f s, %llu dropped\n\n", copied,
+				OS_AtomicLoad(&m_trace.thread_count, MemoryOrder_Relaxed), (end - start) / 1e9,
+				OS_AtomicLoad(&m_trace.dropped, MemoryOrder_Relaxed));
+		
+		M_TraceLabelStats* sorted = arena_alloc(&replay.arena, replay.label_count * sizeof(M_TraceLabelStats));
+		u32 sorted_count = 0;
+		for (u32 i = 0; i < M_TRACE_MAX_LABELS; i++) {
+			if (replay.labels[i].label) sorted[sorted_count++] = replay.labels[i];
+		}
+		qsort(sorted, sorted_count, sizeof(M_TraceLabelStats), mem_trace_compare_labels);
+		fprintf(out, "%-8s %10s %14s %12s %12s %8s %14s  %s\n", "kind", "count", "bytes", "peak", "live", "live #",
+				"avg lifetime", "call site");
+		for (u32 i = 0; i < sorted_count; i++) {
+			M_TraceLabelStats* stats = &sorted[i];
+			f64 lifetime_ms = stats->ended ? stats->lifetime / (f64) stats->ended / 1e6 : 0;
+			fprintf(out, "%-8s %10llu %14llu %12llu %12llu %8llu %11.3f ms  %s\n", mem_trace_kind_names[stats->kind],
+					stats->count, stats->bytes, stats->peak, stats->live, stats->live_count, lifetime_ms, stats->label);
+		}
+		
+		M_HeapCallSite* sites = arena_alloc(&replay.arena, M_HEAP_MAX_CALL_SITES * sizeof(M_HeapCallSite));
+		u32 site_count = heap_get_call_sites(sites, M_HEAP_MAX_CALL_SITES);
+		qsort(sites, site_count, sizeof(M_HeapCallSite), mem_trace_compare_call_sites);
+		fprintf(out, "\nHeap\n%10s %14s  %s\n", "count", "bytes", "call site");
+		for (u32 i = 0; i < site_count; i++) {
+			fprintf(out, "%10llu %14llu  %s:%u\n", sites[i].allocations, sites[i].bytes, sites[i].file, sites[i].line);
+		}
+		
+		fprintf(out, "\nScratch blocks that never went through scratch_return\n");
+		for (M_TraceLive* live = replay.scratch_out; live; live = live->next) {
+			fprintf(out, "%s, thread %u, %.3f ms in\n", replay.labels[live->label].label, live->thread,
+					(live->time - start) / 1e6);
+		}
+		
+		fprintf(out, "\nLive bytes every %.0f ms\n%10s %14s %14s %14s %14s\n", M_TRACE_BUCKET_NS / 1e6,
+				"ms", "arena", "pool", "scratch", "allocated");
+		for (u64 i = 0; i < bucket_count; i++) {
+			M_TraceBucket* row = &buckets[i];
+			fprintf(out, "%10.0f %14llu %14llu %14llu %14llu\n", (i + 1) * M_TRACE_BUCKET_NS / 1e6,
+					row->live[TraceLabel_Arena], row->live[TraceLabel_Pool], row->live[TraceLabel_Scratch],
+					row->allocated);
+		}
+		fclose(out);
+	}
+	
+	u32 leaked = 0;
+	for (M_TraceLive* live = replay.scratch_out; live; live = live->next) leaked++;
+	if (leaked) LogError("[Mem Trace] %u scratch blocks never went back through scratch_return, see %s", leaked, M_TRACE_OUTPUT);
+	else Log("[Mem Trace] Wrote %s", M_TRACE_OUTPUT);
+	
+	arena_free(&replay.arena);
+	arena_free(&events_arena);
+	OS_AtomicStore(&m_trace.dumping, false, MemoryOrder_Release);
+}
+
+#endif
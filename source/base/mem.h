@@ -13,17 +13,35 @@ typedef struct M_Arena {
     u64 max;
     u64 alloc_position;
     u64 commit_position;
+    // Furthest alloc_position has ever been, deallocs don't bring it back
+    u64 high_water;
+    // Same but since the start of the current decommit window, see arena_clear
+    u64 window_high_water;
+    u32 window_clears;
+    u64 decommitted;
     b8 static_size;
+    b8 huge_pages;
 } M_Arena;
 
 #define M_ARENA_MAX Gigabytes(1)
 #define M_ARENA_COMMIT_SIZE Kilobytes(8)
+#define M_ARENA_HUGE_PAGE_SIZE Megabytes(2)
+
+// NOTE(voxel): arena_clear gives committed memory back to the OS, but only what none of the
+// last M_ARENA_DECOMMIT_WINDOW clears needed, and only if there's at least
+// M_ARENA_DECOMMIT_MIN of it. An arena that spikes every few frames keeps its pages
+// instead of faulting them back in every time
+#define M_ARENA_DECOMMIT_WINDOW 64
+#define M_ARENA_DECOMMIT_MIN Kilobytes(256)
 
 void* arena_alloc(M_Arena* arena, u64 size);
 void* arena_alloc_zero(M_Arena* arena, u64 size);
 void  arena_dealloc(M_Arena* arena, u64 size);
 void  arena_dealloc_to(M_Arena* arena, u64 pos);
 void* arena_raise(M_Arena* arena, void* ptr, u64 size);
+// Grows or shrinks the size byte allocation at ptr to new_size where it is, which only works
+// when nothing got allocated after it. Returns false and leaves the arena alone otherwise
+b8    arena_extend(M_Arena* arena, void* ptr, u64 size, u64 new_size);
 void* arena_alloc_array_sized(M_Arena* arena, u64 elem_size, u64 count);
 
 #define arena_alloc_array(arena, elem_type, count) \
@@ -31,9 +49,21 @@ arena_alloc_array_sized(arena, sizeof(elem_type), count)
 
 void arena_init(M_Arena* arena);
 void arena_init_sized(M_Arena* arena, u64 max);
+// For big arenas. Commits happen a whole huge page at a time so that the OS can use them
+void arena_init_huge(M_Arena* arena, u64 max);
 void arena_clear(M_Arena* arena);
 void arena_free(M_Arena* arena);
 
+typedef struct M_ArenaStats {
+    u64 reserved;
+    u64 committed;
+    u64 live;        // Currently allocated
+    u64 peak;        // Most ever allocated at once
+    u64 decommitted; // Given back to the OS over the arena's lifetime
+} M_ArenaStats;
+
+M_ArenaStats arena_get_stats(M_Arena* arena);
+
 typedef struct M_ArenaTemp {
     M_Arena* arena;
     u64 pos;
@@ -75,4 +105,97 @@ void* pool_alloc(M_Pool* pool);
 void  pool_dealloc(M_Pool* pool, void* ptr);
 void  pool_dealloc_range(M_Pool* pool, void* ptr, u64 count);
 
+//~ Heap (Size Class Slab Allocator)
+
+// NOTE(voxel): For whatever doesn't have a lifetime an arena could hang off of. Sizes up to
+// M_HEAP_MAX_SMALL get rounded up to one of M_HEAP_CLASS_COUNT size classes, 16 byte steps up
+// to 128 and then four per power of two, and come out of M_HEAP_SLAB_SIZE slabs. The slabs
+// come from a pool everyone shares, but each one belongs to a single thread's heap, which
+// hands out its blocks without taking any locks. A block freed on another thread goes on its
+// heap's remote free list, and the owner takes those back once it runs out of local blocks.
+// Anything bigger gets its own reservation.
+//
+// Blocks stay with the heap they came from and slabs never go back to the pool. A thread's
+// heap gets left behind by tctx_free for the next thread that needs one. Threads without a
+// ThreadContext share a heap behind a lock.
+//
+// Every call through M_Alloc, M_AllocZero and M_Realloc gets counted under the file and line
+// it came from, see heap_get_call_sites
+
+#define M_HEAP_SLAB_SIZE Kilobytes(256)
+#define M_HEAP_MAX_SMALL Kilobytes(32)
+#define M_HEAP_CLASS_COUNT 40
+// Has to be a power of two. Call sites past that many still allocate, they just aren't counted
+#define M_HEAP_MAX_CALL_SITES 512
+
+typedef struct M_Heap M_Heap;
+
+typedef struct M_HeapCallSite {
+    const char* file;
+    u32 line;
+    u64 allocations;
+    u64 bytes;
+} M_HeapCallSite;
+
+void* heap_alloc(u64 size, const char* file, u32 line);
+void* heap_alloc_zero(u64 size, const char* file, u32 line);
+// Same as realloc. Stays where it is if the block already has room
+void* heap_realloc(void* ptr, u64 size, const char* file, u32 line);
+void  heap_free(void* ptr);
+// Leaves the heap for the next thread that needs one, tctx_free does this
+void  heap_abandon(M_Heap* heap);
+
+// Copies up to max call sites into out. Returns how many
+u32   heap_get_call_sites(M_HeapCallSite* out, u32 max);
+
+#define M_Alloc(size) heap_alloc((size), __FILE__, __LINE__)
+#define M_AllocZero(size) heap_alloc_zero((size), __FILE__, __LINE__)
+#define M_Realloc(ptr, size) heap_realloc((ptr), (size), __FILE__, __LINE__)
+#define M_Free(ptr) heap_free(ptr)
+
+//~ Tracing
+
+// NOTE(voxel): Build with -DM_TRACE and every arena_alloc, pool_alloc and scratch_get gets
+// logged under the file and line it was called from, along with everything that gives memory
+// back. Each thread appends to its own log, no locks involved. At exit the logs get replayed
+// in order and M_TRACE_OUTPUT gets
+//   - per call site: how many, how many bytes, the most live at once, what's still live at
+//     exit and how long things lived on average
+//   - the heap's call sites, see heap_get_call_sites
+//   - every scratch block that never went back through scratch_return
+//   - live bytes every M_TRACE_BUCKET_NS
+// Without M_TRACE none of it gets compiled in.
+//
+// The log is meant for sessions of a few minutes, it stops at M_TRACE_MAX_CHUNKS and counts
+// what it dropped after that. Threads without a ThreadContext don't get logged.
+
+#if defined(M_TRACE)
+
+#define M_TRACE_OUTPUT "mem_trace.txt"
+#define M_TRACE_CHUNK_EVENTS 65536
+#define M_TRACE_MAX_CHUNKS 128
+#define M_TRACE_BUCKET_NS 100000000ull
+
+#define M_TraceStringify_(x) #x
+#define M_TraceStringify(x) M_TraceStringify_(x)
+#define M_TraceLabel FILE_NAME ":" M_TraceStringify(__LINE__)
+
+// What the next traced call gets logged under
+void mem_trace_label(const char* label);
+// Runs at exit on its own
+void mem_trace_dump(void);
+
+// mem.c calls the plain functions, whatever called into it already left a label
+#  if !defined(M_TRACE_INTERNAL)
+#    define arena_alloc(arena, size) (mem_trace_label(M_TraceLabel), arena_alloc(arena, size))
+#    define arena_alloc_zero(arena, size) (mem_trace_label(M_TraceLabel), arena_alloc_zero(arena, size))
+#    define arena_alloc_array_sized(arena, elem_size, count) (mem_trace_label(M_TraceLabel), arena_alloc_array_sized(arena, elem_size, count))
+#    define arena_raise(arena, ptr, size) (mem_trace_label(M_TraceLabel), arena_raise(arena, ptr, size))
+#    define arena_extend(arena, ptr, size, new_size) (mem_trace_label(M_TraceLabel), arena_extend(arena, ptr, size, new_size))
+#    define pool_alloc(pool) (mem_trace_label(M_TraceLabel), pool_alloc(pool))
+#    define scratch_get() (mem_trace_label(M_TraceLabel), scratch_get())
+#  endif
+
+#endif
+
 #endif //MEM_H
\ No newline at end of file
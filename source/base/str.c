@@ -1,8 +1,18 @@
 #include "str.h"
+#include "bits.h"
 #include <stdio.h>
 #include <stdarg.h>
 #include <assert.h>
 
+// Only used by the builder, static so it can't clash with md.c's copy. Metadesk added %S
+// for its MD_String8, which is laid out just like string, so %S takes a string here
+#define STB_SPRINTF_IMPLEMENTATION
+#define STB_SPRINTF_STATIC
+#define STB_SPRINTF_DECORATE(name) str_stbsp_##name
+#define MD_String8 string_const
+#include "md/md_stb_sprintf.h"
+#undef MD_String8
+
 string_const str_alloc(M_Arena* arena, u64 size) {
     string_const str = {0};
     str.str = (u8*)arena_alloc(arena, size + 1);
@@ -33,15 +43,17 @@ string_const str_cat(M_Arena* arena, string_const a, string_const b) {
 string_const str_from_format(M_Arena* arena, const char* format, ...) {
     va_list args;
     va_start(args, format);
-    const char buf[8092];
-    vsnprintf(buf, 8092, format, args);
+    string_const s = str_from_formatv(arena, format, args);
     va_end(args);
-    u64 size = strlen(buf);
-    string_const s = str_alloc(arena, size);
-    memmove(s.str, buf, size);
     return s;
 }
 
+string_const str_from_formatv(M_Arena* arena, const char* format, va_list args) {
+    string_builder builder = string_builder_begin(arena);
+    string_builder_pushfv(&builder, format, args);
+    return string_builder_end(&builder);
+}
+
 b8 str_eq(string_const a, string_const b) {
     if (a.size != b.size) return false;
     return memcmp(a.str, b.str, b.size) == 0;
@@ -100,60 +112,183 @@ u64 str_substr_count(string_const str, string_const needle) {
     return ct;
 }
 
+//- Search
+
+// NOTE(voxel): Wojciech Muła's first and last byte filter. A block of candidate positions
+// gets compared against the needle's first byte, and the same block shifted by
+// needle.size - 1 against its last byte. Only positions where both matched get a memcmp,
+// which for text that isn't pathological is almost none of them. The AVX2 version only
+// gets compiled in when the build targets it
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define STR_SEARCH_WIDTH 32
+
+static inline u32 str_search_block(const u8* s, u64 needle_size, __m256i first, __m256i last) {
+    __m256i a = _mm256_loadu_si256((const __m256i*) s);
+    __m256i b = _mm256_loadu_si256((const __m256i*) (s + needle_size - 1));
+    return (u32) _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+}
+#  define str_search_splat(c) _mm256_set1_epi8((char) (c))
+typedef __m256i str_search_lanes;
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define STR_SEARCH_WIDTH 16
+
+static inline u32 str_search_block(const u8* s, u64 needle_size, __m128i first, __m128i last) {
+    __m128i a = _mm_loadu_si128((const __m128i*) s);
+    __m128i b = _mm_loadu_si128((const __m128i*) (s + needle_size - 1));
+    return (u32) _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+}
+#  define str_search_splat(c) _mm_set1_epi8((char) (c))
+typedef __m128i str_search_lanes;
+#endif
+
+// First and last bytes already matched
+static inline b8 str_search_verify(const u8* s, string_const needle) {
+    return needle.size <= 2 || memcmp(s + 1, needle.str + 1, needle.size - 2) == 0;
+}
+
 u64 str_find_first(string_const str, string_const needle, u32 offset) {
-    u64 i = 0;
-    if (needle.size > 0) {
-        i = str.size;
-        if (str.size >= needle.size) {
-            i = offset;
-            i8 c = needle.str[0];
-            u64 one_past_last = str.size - needle.size + 1;
-            for (; i < one_past_last; i++) {
-                if (str.str[i] == c) {
-                    if ((str.size - i) >= needle.size) {
-                        string_const sub = { .str = str.str + i, .size = needle.size };
-                        if (str_eq(sub, needle)) break;
-                    }
-                }
-            }
-            if (i == one_past_last) {
-                i = str.size;
-            }
+    if (needle.size == 0) return 0;
+    if (str.size < needle.size) return str.size;
+    
+    u64 one_past_last = str.size - needle.size + 1;
+    u8 first = needle.str[0];
+    u8 last = needle.str[needle.size - 1];
+    u64 i = offset;
+#if defined(STR_SEARCH_WIDTH)
+    str_search_lanes first_lanes = str_search_splat(first);
+    str_search_lanes last_lanes = str_search_splat(last);
+    for (; i + STR_SEARCH_WIDTH <= one_past_last; i += STR_SEARCH_WIDTH) {
+        for (u32 mask = str_search_block(str.str + i, needle.size, first_lanes, last_lanes); mask; mask &= mask - 1) {
+            u64 at = i + bit_scan_forward(mask);
+            if (str_search_verify(str.str + at, needle)) return at;
         }
     }
-    return i;
+#endif
+    for (; i < one_past_last; i++) {
+        if (str.str[i] == first && str.str[i + needle.size - 1] == last && str_search_verify(str.str + i, needle))
+            return i;
+    }
+    return str.size;
 }
 
+// NOTE(voxel): Returns one past where the match starts, or 0 when there's none. Only looks at
+// matches that start before offset, 0 meaning anywhere. The path helpers are built around
+// the one past, it's what they want to slice with anyway
 u64 str_find_last(string_const str, string_const needle, u32 offset) {
-    u64 prev = str.size;
+    if (needle.size == 0 || str.size < needle.size) return 0;
     if (offset == 0)
         offset = str.size;
-    u64 idx = 0;
-    while (true) {
-        prev = idx;
-        idx = str_find_first(str, needle, idx);
-        if (idx >= offset) break;
-        idx++;
+    
+    u64 i = Min((u64) offset, str.size - needle.size + 1);
+    u8 first = needle.str[0];
+    u8 last = needle.str[needle.size - 1];
+#if defined(STR_SEARCH_WIDTH)
+    str_search_lanes first_lanes = str_search_splat(first);
+    str_search_lanes last_lanes = str_search_splat(last);
+    while (i >= STR_SEARCH_WIDTH) {
+        i -= STR_SEARCH_WIDTH;
+        u32 mask = str_search_block(str.str + i, needle.size, first_lanes, last_lanes);
+        while (mask) {
+            u32 bit = bit_scan_reverse(mask);
+            if (str_search_verify(str.str + i + bit, needle)) return i + bit + 1;
+            mask &= ~(1u << bit);
+        }
+    }
+#endif
+    while (i > 0) {
+        i--;
+        if (str.str[i] == first && str.str[i + needle.size - 1] == last && str_search_verify(str.str + i, needle))
+            return i + 1;
     }
-    return prev;
+    return 0;
 }
 
-u32 str_hash(string_const str) {
-    u32 hash = 2166136261u;
-    for (int i = 0; i < str.size; i++) {
-        hash ^= str.str[i];
-        hash *= 16777619;
-    }
-    return hash;
+//- Hashing
+
+// NOTE(voxel): wyhash (Wang Yi's, the final version 4 one, without the seed). 16 bytes per
+// step, 48 once there's more than that, and short keys take a couple of overlapping reads
+// instead of a loop. Everything is one 64x64->128 multiply folded back down
+static const u64 str_hash_secret[4] = {
+    0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+static inline void str_hash_mum(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t) *a * *b;
+    *a = (u64) r;
+    *b = (u64) (r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32) *a, lb = (u32) *b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
 }
 
+static inline u64 str_hash_mix(u64 a, u64 b) {
+    str_hash_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline u64 str_hash_read64(const u8* p) { u64 v; memcpy(&v, p, 8); return v; }
+static inline u64 str_hash_read32(const u8* p) { u32 v; memcpy(&v, p, 4); return v; }
+
 u64 str_hash_64(string_const str) {
-    u64 hash = 2166136261u;
-    for (int i = 0; i < str.size; i++) {
-        hash ^= str.str[i];
-        hash *= 16777619;
+    const u8* p = str.str;
+    u64 size = str.size;
+    const u64* s = str_hash_secret;
+    u64 seed = str_hash_mix(s[0], s[1]);
+    u64 a, b;
+    
+    if (size <= 16) {
+        if (size >= 4) {
+            u64 step = (size >> 3) << 2;
+            a = (str_hash_read32(p) << 32) | str_hash_read32(p + step);
+            b = (str_hash_read32(p + size - 4) << 32) | str_hash_read32(p + size - 4 - step);
+        } else if (size > 0) {
+            a = ((u64) p[0] << 16) | ((u64) p[size >> 1] << 8) | p[size - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        u64 i = size;
+        if (i > 48) {
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = str_hash_mix(str_hash_read64(p) ^ s[1], str_hash_read64(p + 8) ^ seed);
+                see1 = str_hash_mix(str_hash_read64(p + 16) ^ s[2], str_hash_read64(p + 24) ^ see1);
+                see2 = str_hash_mix(str_hash_read64(p + 32) ^ s[3], str_hash_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = str_hash_mix(str_hash_read64(p) ^ s[1], str_hash_read64(p + 8) ^ seed);
+            p += 16;
+            i -= 16;
+        }
+        a = str_hash_read64(p + i - 16);
+        b = str_hash_read64(p + i - 8);
     }
-    return hash;
+    
+    a ^= s[1];
+    b ^= seed;
+    str_hash_mum(&a, &b);
+    return str_hash_mix(a ^ s[0] ^ size, b ^ s[1]);
+}
+
+u32 str_hash(string_const str) {
+    u64 hash = str_hash_64(str);
+    return (u32) (hash ^ (hash >> 32));
 }
 
 void string_list_push_node(string_const_list* list, string_const_list_node* node) {
@@ -209,13 +344,70 @@ string_const string_list_flatten(M_Arena* arena, string_const_list* list) {
     return final;
 }
 
+//- Builder
+
+// Makes sure there's room for size more bytes
+static void string_builder_reserve(string_builder* builder, u64 size) {
+    u64 needed = builder->size + size;
+    if (needed <= builder->cap) return;
+    u64 cap = Max(needed, builder->cap * 2);
+    if (!arena_extend(builder->arena, builder->str, builder->cap, cap)) {
+        u8* moved = arena_alloc(builder->arena, cap);
+        memcpy(moved, builder->str, builder->size);
+        builder->str = moved;
+    }
+    builder->cap = cap;
+}
+
+// stb_sprintf hands over every STB_SPRINTF_MIN bytes, already written where they belong
+static char* string_builder_format_callback(const char* buf, void* user, int len) {
+    string_builder* builder = (string_builder*) user;
+    builder->size += len;
+    string_builder_reserve(builder, STB_SPRINTF_MIN);
+    return (char*) builder->str + builder->size;
+}
+
+string_builder string_builder_begin(M_Arena* arena) {
+    string_builder builder = {0};
+    builder.arena = arena;
+    // Nothing gets reserved until the first push, this is only where the tip is
+    builder.str = arena_alloc(arena, 0);
+    return builder;
+}
+
+void string_builder_push(string_builder* builder, string_const str) {
+    string_builder_reserve(builder, str.size);
+    memcpy(builder->str + builder->size, str.str, str.size);
+    builder->size += str.size;
+}
+
+void string_builder_pushf(string_builder* builder, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    string_builder_pushfv(builder, format, args);
+    va_end(args);
+}
+
+void string_builder_pushfv(string_builder* builder, const char* format, va_list args) {
+    string_builder_reserve(builder, STB_SPRINTF_MIN);
+    str_stbsp_vsprintfcb(string_builder_format_callback, builder, (char*) builder->str + builder->size, format, args);
+}
+
+string_const string_builder_end(string_builder* builder) {
+    string_builder_reserve(builder, 1);
+    builder->str[builder->size] = '\0';
+    arena_extend(builder->arena, builder->str, builder->cap, builder->size + 1);
+    builder->cap = builder->size + 1;
+    return (string_const) { .str = builder->str, .size = builder->size };
+}
+
 void string_array_add(string_const_array* array, string data) {
     if (array->len + 1 > array->cap) {
         void* prev = array->elems;
         u32 new_cap = array->cap == 0 ? 8 : array->cap * 2;
-        array->elems = calloc(new_cap, sizeof(string));
+        array->elems = M_AllocZero(new_cap * sizeof(string));
         memmove(array->elems, prev, array->len * sizeof(string));
-        free(prev);
+        M_Free(prev);
     }
     array->elems[array->len++] = data;
 }
@@ -237,16 +429,11 @@ string string_array_remove(string_const_array* array, int idx) {
 void string_array_free(string_const_array* array) {
     array->cap = 0;
     array->len = 0;
-    free(array->elems);
+    M_Free(array->elems);
 }
 
 //~ Encoding stuff
 
-typedef struct str_decode {
-    u32 codepoint;
-    u32 size;
-} str_decode;
-
 string_utf16_const str16_cstring(u16 *cstr){
     u16 *ptr = cstr;
     for (;*ptr != 0; ptr += 1);
@@ -254,7 +441,7 @@ string_utf16_const str16_cstring(u16 *cstr){
     return result;
 }
 
-static str_decode str_decode_utf8(u8 *str, u32 cap){
+str_decode str_decode_utf8(u8 *str, u32 cap){
     u8 length[] = {
         1, 1, 1, 1, // 000xx
         1, 1, 1, 1,
@@ -4,6 +4,7 @@
 #define STR_H
 
 #include <string.h>
+#include <stdarg.h>
 #include "mem.h"
 
 typedef struct string_const {
@@ -47,6 +48,7 @@ string_const str_alloc(M_Arena* arena, u64 size); // NOTE(EVERYONE): this will t
 string_const str_copy(M_Arena* arena, string_const other);
 string_const str_cat(M_Arena* arena, string_const a, string_const b);
 string_const str_from_format(M_Arena* arena, const char* format, ...);
+string_const str_from_formatv(M_Arena* arena, const char* format, va_list args);
 string_const str_replace_all(M_Arena* arena, string_const to_fix, string_const needle, string_const replacement);
 u64 str_substr_count(string_const str, string_const needle);
 u64 str_find_first(string_const str, string_const needle, u32 offset);
@@ -63,6 +65,34 @@ b8   string_list_equals(string_const_list* a, string_const_list* b);
 b8   string_list_contains(string_const_list* a, string_const needle);
 string_const string_list_flatten(M_Arena* arena, string_const_list* list);
 
+//- Builder
+
+// NOTE(voxel): Builds a string in place at the tip of the arena, so appends don't copy
+// anything and formatting goes straight into the arena in one pass. Nothing else should
+// allocate from the arena until string_builder_end. If something does anyway the builder
+// moves itself to the new tip, which works but leaves the old copy behind.
+//
+// Formatting is stb_sprintf and not the C library, so %S takes a string directly.
+//
+//   string_builder builder = string_builder_begin(arena);
+//   string_builder_push(&builder, str_lit("V0-VF:"));
+//   for (u32 i = 0; i < 16; i++) string_builder_pushf(&builder, " %02X", ctx->V[i]);
+//   string line = string_builder_end(&builder);
+typedef struct string_builder {
+  M_Arena* arena;
+  u8* str;
+  u64 size;
+  // How much of the arena the builder is holding on to right now
+  u64 cap;
+} string_builder;
+
+string_builder string_builder_begin(M_Arena* arena);
+void string_builder_push(string_builder* builder, string_const str);
+void string_builder_pushf(string_builder* builder, const char* format, ...);
+void string_builder_pushfv(string_builder* builder, const char* format, va_list args);
+// Null terminates, and gives back whatever was reserved past the end
+string_const string_builder_end(string_builder* builder);
+
 //- Encoding Stuff
 
 typedef struct string_utf16_const {
@@ -71,6 +101,14 @@ typedef struct string_utf16_const {
 } string_utf16_const;
 typedef string_utf16_const string_utf16;
 
+typedef struct str_decode {
+  u32 codepoint;
+  u32 size;
+} str_decode;
+
+// Invalid sequences decode as '#', one byte long
+str_decode str_decode_utf8(u8 *str, u32 cap);
+
 string_utf16_const str16_cstring(u16 *cstr);
 string_utf16_const str16_from_str8(M_Arena *arena, string_const str);
 string_const str8_from_str16(M_Arena *arena, string_utf16_const str);
@@ -8,8 +8,12 @@ void tctx_init(ThreadContext* ctx) {
 }
 
 void tctx_free(ThreadContext* ctx) {
+	if (ctx->heap) {
+		heap_abandon(ctx->heap);
+		ctx->heap = nullptr;
+	}
 	arena_free(&ctx->arena);
-	OS_ThreadContextSet(ctx);
+	OS_ThreadContextSet(nullptr);
 }
 
 M_Scratch tctx_scratch_get(ThreadContext* ctx) {
@@ -22,6 +22,16 @@ typedef struct ThreadContext {
 	M_Arena arena;
 	u32 max_created;
 	scratch_free_list_node* free_list;
+	// The J_Worker this thread is, nullptr if it isn't part of a job system
+	void* job_worker;
+	// Taken on the first M_Alloc, see heap_alloc
+	struct M_Heap* heap;
+#if defined(M_TRACE)
+	// See the tracing section of mem.h
+	const char* trace_label;
+	struct M_TraceChunk* trace_chunk;
+	u32 trace_thread;
+#endif
 } ThreadContext;
 
 void tctx_init(ThreadContext* ctx);
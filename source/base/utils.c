@@ -120,6 +120,6 @@ M_Arena* U_GetFrameArena(void) {
 }
 
 void U_ResetFrameArena(void) {
-	arena_dealloc_to(&frame_arena, 0);
+	arena_clear(&frame_arena);
 }
 
@@ -28,13 +28,13 @@ static void Audio_Init(Chip_Exec_Context* ctx) {
   size_t buf_size = seconds * sample_rate;
   
   // allocate PCM audio buffer
-  short* samples = malloc(sizeof(short) * buf_size);
+  short* samples = M_Alloc(sizeof(short) * buf_size);
   for(int i=0; i<buf_size; ++i) {
     samples[i] = 32760 * sin( (2.f * my_pi * freq)/sample_rate * i );
   }
   
   alBufferData(ctx->beepbuffer, AL_FORMAT_MONO16, samples, buf_size, sample_rate);
-  free(samples);
+  M_Free(samples);
   
   alGenSources(1, &ctx->al_source);
   alSourcef(ctx->al_source, AL_GAIN, 0.05);
@@ -474,6 +474,7 @@ void Chip_Step(Chip_Exec_Context* ctx) {
   u16 instruction = ctx->memory[ctx->PC] << 8 | ctx->memory[ctx->PC + 1];
   //printf("%u    ", ctx->PC);
   Chip_Execute(ctx, instruction);
+  ctx->instructions_executed++;
   
   printf("PC: %x, %4x     ", ctx->PC, instruction);
   for (u32 i = 0; i <= 0xF; i++)
@@ -513,6 +514,7 @@ void Chip_Tick(Chip_Exec_Context* ctx, f32 dt) {
     // All instructions are 2 bytes long
     u16 instruction = ctx->memory[ctx->PC] << 8 | ctx->memory[ctx->PC + 1];
     Chip_Execute(ctx, instruction);
+    ctx->instructions_executed++;
     
     // Go to next instruction
     if (!ctx->jumped) ctx->PC += 2;
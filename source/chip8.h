@@ -37,6 +37,8 @@ typedef struct Chip_Exec_Context {
   f32 target_time;
   f32 dec_target_time;
   b8  jumped;
+  // Never reset, the perf HUD takes the difference between frames
+  u64 instructions_executed;
   
   ALCdevice* al_device;
   ALCcontext* al_context;
@@ -1,4 +1,5 @@
 #include "backend.h"
+#include "resources.h"
 
 #if defined(BACKEND_GL46)
 
@@ -24,4 +25,12 @@
 #    error The D3D11 Backend is not supported for linux
 #  endif // WINDOWS
 
+#elif defined(BACKEND_SOFT)
+
+#  if defined(PLATFORM_WIN)
+#    error The Soft Backend is not supported for windows yet
+#  elif defined(PLATFORM_LINUX)
+#    include "impl/linux_soft_backend.c"
+#  endif // WINDOWS
+
 #endif // Backends
@@ -8,9 +8,7 @@
 
 #include "d3d11_functions.h"
 
-static b8 i32_is_null(i32 value) { return value == 0;  }
-static b8 i32_is_tomb(i32 value) { return value == 69; }
-HashTable_Impl(string, i32, str_is_null, str_eq, str_hash, 69, i32_is_null, i32_is_tomb);
+SwissTable_Impl(string, i32, str_eq, str_hash);
 
 DArray_Impl(R_BufferAttribCountPack);
 DArray_Impl(R_UniformBufferHandle);
@@ -29,6 +27,171 @@ void __SetCurrentWindow(W32_Window* window) {
 	s_wnd = window;
 }
 
+//~ Frame Statistics
+
+// NOTE(voxel): Binds go straight to the context, there's no state cache to skip any, so
+// only draw_calls gets counted. state_changes_* stay 0 like on the soft backend
+static R_FrameStats s_frame_stats;
+static R_FrameStats s_last_frame_stats;
+
+R_FrameStats R_FrameStatsGet(void) {
+	return s_last_frame_stats;
+}
+
+void R_FrameStatsNext(void) {
+	s_last_frame_stats = s_frame_stats;
+	MemoryZero(&s_frame_stats, sizeof(R_FrameStats));
+}
+
+//~ GPU Timers
+
+// NOTE(voxel): Same ring scheme as gl_timers.c. D3D11 has no elapsed time query, so every
+// slot is a TIMESTAMP_DISJOINT query wrapped around a pair of TIMESTAMP queries. The
+// disjoint one gives the tick frequency and says whether the clock stayed valid in between,
+// samples where it didn't are thrown away.
+#define D3D11_TIMER_RING_SIZE 4
+#define D3D11_TIMER_NAME_SIZE 32
+
+typedef struct D3D11_TimerQueries {
+	ID3D11Query* disjoint;
+	ID3D11Query* begin;
+	ID3D11Query* end;
+} D3D11_TimerQueries;
+
+typedef struct D3D11_TimerScope {
+	u8  name_buffer[D3D11_TIMER_NAME_SIZE];
+	string name;
+	
+	D3D11_TimerQueries queries[D3D11_TIMER_RING_SIZE];
+	u32 write_index;
+	u32 read_index;
+	u32 pending;
+	
+	f64 history[R_GPU_TIMER_HISTORY];
+	f64 history_sum;
+	u32 history_index;
+	u32 history_count;
+	f64 last_ms;
+} D3D11_TimerScope;
+
+static D3D11_TimerScope s_timer_scopes[R_GPU_TIMER_MAX_SCOPES];
+static u32 s_timer_scope_count;
+static D3D11_TimerScope* s_timer_active;
+static b8 s_timer_active_skipped;
+
+// Scopes only keep the first D3D11_TIMER_NAME_SIZE bytes, so longer names are compared on those
+static string D3D11_TimerName(string name) {
+	return (string) { name.str, Min(name.size, D3D11_TIMER_NAME_SIZE) };
+}
+
+static D3D11_TimerScope* D3D11_TimerScopeGet(string name) {
+	name = D3D11_TimerName(name);
+	for (u32 i = 0; i < s_timer_scope_count; i++) {
+		if (str_eq(s_timer_scopes[i].name, name))
+			return &s_timer_scopes[i];
+	}
+	if (s_timer_scope_count == R_GPU_TIMER_MAX_SCOPES) {
+		LogError("[D3D11 Backend] Ran out of GPU timer scopes, '%.*s' will not be timed", str_expand(name));
+		return nullptr;
+	}
+	
+	D3D11_TimerScope* scope = &s_timer_scopes[s_timer_scope_count++];
+	MemoryZeroStruct(scope, D3D11_TimerScope);
+	MemoryCopy(scope->name_buffer, name.str, name.size);
+	scope->name = (string) { scope->name_buffer, name.size };
+	
+	D3D11_QUERY_DESC disjoint_desc = { .Query = D3D11_QUERY_TIMESTAMP_DISJOINT };
+	D3D11_QUERY_DESC timestamp_desc = { .Query = D3D11_QUERY_TIMESTAMP };
+	HRESULT hr;
+	for (u32 i = 0; i < D3D11_TIMER_RING_SIZE; i++) {
+		CHECK_HR(ID3D11Device_CreateQuery(s_wnd->device, &disjoint_desc, &scope->queries[i].disjoint));
+		CHECK_HR(ID3D11Device_CreateQuery(s_wnd->device, &timestamp_desc, &scope->queries[i].begin));
+		CHECK_HR(ID3D11Device_CreateQuery(s_wnd->device, &timestamp_desc, &scope->queries[i].end));
+	}
+	return scope;
+}
+
+static void D3D11_TimerScopeHarvest(D3D11_TimerScope* scope) {
+	while (scope->pending) {
+		D3D11_TimerQueries* queries = &scope->queries[scope->read_index];
+		// DONOTFLUSH, asking shouldn't make the driver submit anything
+		D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+		if (ID3D11DeviceContext_GetData(s_wnd->context, (ID3D11Asynchronous*) queries->disjoint, &disjoint,
+										sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+		u64 begin = 0, end = 0;
+		if (ID3D11DeviceContext_GetData(s_wnd->context, (ID3D11Asynchronous*) queries->begin, &begin,
+										sizeof(begin), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK ||
+			ID3D11DeviceContext_GetData(s_wnd->context, (ID3D11Asynchronous*) queries->end, &end,
+										sizeof(end), D3D11_ASYNC_GETDATA_DONOTFLUSH) != S_OK)
+			break;
+		
+		scope->read_index = (scope->read_index + 1) % D3D11_TIMER_RING_SIZE;
+		scope->pending--;
+		if (disjoint.Disjoint || !disjoint.Frequency) continue;
+		
+		f64 ms = (f64) (end - begin) * 1000.0 / (f64) disjoint.Frequency;
+		scope->last_ms = ms;
+		scope->history_sum -= scope->history[scope->history_index];
+		scope->history[scope->history_index] = ms;
+		scope->history_sum += ms;
+		scope->history_index = (scope->history_index + 1) % R_GPU_TIMER_HISTORY;
+		if (scope->history_count < R_GPU_TIMER_HISTORY) scope->history_count++;
+	}
+}
+
+void R_GPUTimerBegin(string name) {
+	if (s_timer_active) {
+		LogError("[D3D11 Backend] GPU timer '%.*s' started inside '%.*s'. Timer scopes can't nest",
+				 str_expand(name), str_expand(s_timer_active->name));
+		return;
+	}
+	D3D11_TimerScope* scope = D3D11_TimerScopeGet(name);
+	if (!scope) return;
+	
+	D3D11_TimerScopeHarvest(scope);
+	s_timer_active = scope;
+	s_timer_active_skipped = scope->pending == D3D11_TIMER_RING_SIZE;
+	if (!s_timer_active_skipped) {
+		D3D11_TimerQueries* queries = &scope->queries[scope->write_index];
+		ID3D11DeviceContext_Begin(s_wnd->context, (ID3D11Asynchronous*) queries->disjoint);
+		ID3D11DeviceContext_End(s_wnd->context, (ID3D11Asynchronous*) queries->begin);
+	}
+}
+
+void R_GPUTimerEnd(string name) {
+	if (!s_timer_active) return;
+	if (!str_eq(s_timer_active->name, D3D11_TimerName(name))) {
+		LogError("[D3D11 Backend] GPU timer '%.*s' ended while '%.*s' was running",
+				 str_expand(name), str_expand(s_timer_active->name));
+	}
+	
+	D3D11_TimerScope* scope = s_timer_active;
+	s_timer_active = nullptr;
+	if (s_timer_active_skipped) return;
+	
+	D3D11_TimerQueries* queries = &scope->queries[scope->write_index];
+	ID3D11DeviceContext_End(s_wnd->context, (ID3D11Asynchronous*) queries->end);
+	ID3D11DeviceContext_End(s_wnd->context, (ID3D11Asynchronous*) queries->disjoint);
+	scope->write_index = (scope->write_index + 1) % D3D11_TIMER_RING_SIZE;
+	scope->pending++;
+}
+
+u32 R_GPUTimerCount(void) {
+	return s_timer_scope_count;
+}
+
+R_GPUTimerStats R_GPUTimerGet(u32 index) {
+	if (index >= s_timer_scope_count) return (R_GPUTimerStats) {0};
+	D3D11_TimerScope* scope = &s_timer_scopes[index];
+	return (R_GPUTimerStats) {
+		.name = scope->name,
+		.last_ms = scope->last_ms,
+		.average_ms = scope->history_count ? scope->history_sum / scope->history_count : 0.0,
+		.sample_count = scope->history_count,
+	};
+}
+
 //~ Conversion Routines
 
 static u32 get_bind_flag_of(R_BufferFlags flags) {
@@ -48,7 +211,7 @@ static u32 get_primitive_topology_of(R_InputAssembly primitive) {
 }
 
 static u32 get_format_of(R_AttributeType type) {
-	AssertTrue(8 == AttributeType_MAX, "Non Exhaustive switch statement: get_component_count_of in gl33 backend");
+	AssertTrue(10 == AttributeType_MAX, "Non Exhaustive switch statement: get_component_count_of in gl33 backend");
 	switch (type) {
 		case AttributeType_Float1: return DXGI_FORMAT_R32_FLOAT;
 		case AttributeType_Float2: return DXGI_FORMAT_R32G32_FLOAT;
@@ -58,12 +221,14 @@ static u32 get_format_of(R_AttributeType type) {
 		case AttributeType_Integer2: return DXGI_FORMAT_R32G32_SINT;
 		case AttributeType_Integer3: return DXGI_FORMAT_R32G32B32_SINT;
 		case AttributeType_Integer4: return DXGI_FORMAT_R32G32B32A32_SINT;
+		case AttributeType_UByte4Norm: return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case AttributeType_UShort2: return DXGI_FORMAT_R16G16_UINT;
 	}
 	return 0;
 }
 
 static u32 get_size_of(R_AttributeType type) {
-	AssertTrue(8 == AttributeType_MAX, "Non Exhaustive switch statement: get_component_count_of in gl33 backend");
+	AssertTrue(10 == AttributeType_MAX, "Non Exhaustive switch statement: get_component_count_of in gl33 backend");
 	switch (type) {
 		case AttributeType_Float1: return sizeof(f32) * 1;
 		case AttributeType_Float2: return sizeof(f32) * 2;
@@ -73,6 +238,8 @@ static u32 get_size_of(R_AttributeType type) {
 		case AttributeType_Integer2: return sizeof(i32) * 2;
 		case AttributeType_Integer3: return sizeof(i32) * 3;
 		case AttributeType_Integer4: return sizeof(i32) * 4;
+		case AttributeType_UByte4Norm: return sizeof(u8) * 4;
+		case AttributeType_UShort2: return sizeof(u16) * 2;
 	}
 	return 0;
 }
@@ -282,7 +449,7 @@ void R_BufferFree(R_Buffer* buf) {
 
 void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member_names,
 						  R_ShaderPack* pack, R_ShaderType type) {
-	hash_table_init(string, i32, &buf->uniform_offsets);
+	swiss_table_init(string, i32, &buf->uniform_offsets);
 	buf->name = name;
 	buf->dirty = false;
 	buf->stage = type;
@@ -300,7 +467,7 @@ void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member
 	cb->lpVtbl->GetDesc(cb, &cbdesc);
 	
 	buf->size = cbdesc.Size;
-	buf->cpu_side_buffer = malloc(cbdesc.Size);
+	buf->cpu_side_buffer = M_Alloc(cbdesc.Size);
 	MemoryZero(buf->cpu_side_buffer, cbdesc.Size);
 	
 	Iterate(member_names, i) {
@@ -308,7 +475,7 @@ void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member
 			cb->lpVtbl->GetVariableByName(cb, (const char*) member_names.elems[i].str);
 		D3D11_SHADER_VARIABLE_DESC vardesc;
 		var->lpVtbl->GetDesc(var, &vardesc);
-		hash_table_set(string, i32, &buf->uniform_offsets, member_names.elems[i], (i32)vardesc.StartOffset);
+		swiss_table_set(string, i32, &buf->uniform_offsets, member_names.elems[i], (i32)vardesc.StartOffset);
 	}
 	
 	SAFE_RELEASE(ID3D11ShaderReflection, shader_reflection);
@@ -328,15 +495,15 @@ void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member
 }
 
 void R_UniformBufferFree(R_UniformBuffer* buf) {
-	hash_table_free(string, i32, &buf->uniform_offsets);
-	free(buf->cpu_side_buffer);
+	swiss_table_free(string, i32, &buf->uniform_offsets);
+	M_Free(buf->cpu_side_buffer);
 	SAFE_RELEASE(ID3D11Buffer, buf->handle);
 }
 
 
 void R_UniformBufferSetMat4(R_UniformBuffer* buf, string name, mat4 mat) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -346,7 +513,7 @@ void R_UniformBufferSetMat4(R_UniformBuffer* buf, string name, mat4 mat) {
 
 void R_UniformBufferSetInt(R_UniformBuffer* buf, string name, i32 val) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -356,7 +523,7 @@ void R_UniformBufferSetInt(R_UniformBuffer* buf, string name, i32 val) {
 
 void R_UniformBufferSetIntArray(R_UniformBuffer* buf, string name, i32* vals, u32 count) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -366,7 +533,7 @@ void R_UniformBufferSetIntArray(R_UniformBuffer* buf, string name, i32* vals, u3
 
 void R_UniformBufferSetFloat(R_UniformBuffer* buf, string name, f32 val) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -376,7 +543,7 @@ void R_UniformBufferSetFloat(R_UniformBuffer* buf, string name, f32 val) {
 
 void R_UniformBufferSetVec4(R_UniformBuffer* buf, string name, vec4 val) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -384,6 +551,21 @@ void R_UniformBufferSetVec4(R_UniformBuffer* buf, string name, vec4 val) {
 	buf->dirty = true;
 }
 
+// NOTE(voxel): HLSL packs float4 array elements into consecutive 16 byte registers
+void R_UniformBufferSetVec4Array(R_UniformBuffer* buf, string name, vec4* vals, u32 count) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[D3D11 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	if (offset + sizeof(vec4) * count > buf->size) {
+		LogError("[D3D11 Backend] Setting %u elements overflows uniform buffer '%.*s'", count, str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, vals, sizeof(vec4) * count);
+	buf->dirty = true;
+}
+
 //~ Shaders
 
 void R_ShaderAlloc(R_Shader* shader, string data, R_ShaderType type) {
@@ -669,8 +851,13 @@ void R_PipelineBind(R_Pipeline* in) {
 			elements[i].Format = get_format_of(in->attributes[i].type);
 			elements[i].InputSlot = curr_buf_idx;
 			elements[i].AlignedByteOffset = offset;
-			elements[i].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-			elements[i].InstanceDataStepRate = 0;
+			if (in->buffers.elems[curr_buf_idx].b->flags & BufferFlag_PerInstance) {
+				elements[i].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+				elements[i].InstanceDataStepRate = 1;
+			} else {
+				elements[i].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+				elements[i].InstanceDataStepRate = 0;
+			}
 			ticker += 1;
 			offset += get_size_of(in->attributes[i].type);
 			if (in->buffers.elems[curr_buf_idx].attrib_count == ticker) {
@@ -855,6 +1042,27 @@ void R_Texture2DData(R_Texture2D* texture, void* data) {
 	}
 }
 
+void R_Texture2DSubData(R_Texture2D* texture, u32 x, u32 y, u32 width, u32 height, void* data) {
+	// NOTE(voxel): Only DEFAULT usage textures can take partial updates, so Dynamic
+	// textures have to go through R_Texture2DData instead
+	if (texture->mut != TextureMutability_Uncommon) {
+		LogError("[D3D11 Backend] Partial texture updates need TextureMutability_Uncommon");
+		return;
+	}
+	
+	D3D11_BOX update_box = (D3D11_BOX) {
+		.left = x,
+		.right = x + width,
+		.top = y,
+		.bottom = y + height,
+		.front = 0,
+		.back = 1,
+	};
+	ID3D11DeviceContext_UpdateSubresource(s_wnd->context, (ID3D11Resource*) texture->handle, 0,
+										  &update_box, data,
+										  width * get_texture_datatype_size_of(texture->format), 0);
+}
+
 b8 R_Texture2DEquals(R_Texture2D* a, R_Texture2D* b) {
 	return a->handle == b->handle;
 }
@@ -915,5 +1123,11 @@ void R_Viewport(i32 x, i32 y, i32 w, i32 h) {
 }
 
 void R_Draw(R_Pipeline* pipeline, u32 start, u32 count) {
+	s_frame_stats.draw_calls++;
 	ID3D11DeviceContext_Draw(s_wnd->context, count, start);
 }
+
+void R_DrawInstanced(R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count) {
+	s_frame_stats.draw_calls++;
+	ID3D11DeviceContext_DrawInstanced(s_wnd->context, count, instance_count, start, 0);
+}
@@ -11,7 +11,7 @@
 #include <dxgi.h>
 #include <d3dcompiler.h>
 
-HashTable_Prototype(string, i32);
+SwissTable_Prototype(string, i32);
 
 typedef struct R_Buffer {
 	R_BufferFlags flags;
@@ -22,7 +22,7 @@ typedef struct R_Buffer {
 typedef struct R_UniformBuffer {
 	R_ShaderType stage;
 	string name;
-	hash_table(string, i32) uniform_offsets;
+	swiss_table(string, i32) uniform_offsets;
 	u8* cpu_side_buffer;
 	b8  dirty;
 	u32 size;
@@ -5,15 +5,13 @@
 
 #include "gl33_resources.h"
 
-static b8 i32_is_null(i32 value) { return value == 0;  }
-static b8 i32_is_tomb(i32 value) { return value == 69; }
-HashTable_Impl(string, i32, str_is_null, str_eq, str_hash, 69, i32_is_null, i32_is_tomb);
+SwissTable_Impl(string, i32, str_eq, str_hash);
 DArray_Impl(R_UniformBufferHandle);
 
 //~ Elpers
 
 static u32 get_size_of(R_AttributeType attrib) {
-	AssertTrue(8 == AttributeType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_size_of");
+	AssertTrue(10 == AttributeType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_size_of");
 	switch (attrib) {
 		case AttributeType_Float1: return 1 * sizeof(f32);
 		case AttributeType_Float2: return 2 * sizeof(f32);
@@ -23,12 +21,14 @@ static u32 get_size_of(R_AttributeType attrib) {
 		case AttributeType_Integer2: return 2 * sizeof(i32);
 		case AttributeType_Integer3: return 3 * sizeof(i32);
 		case AttributeType_Integer4: return 4 * sizeof(i32);
+		case AttributeType_UByte4Norm: return 4 * sizeof(u8);
+		case AttributeType_UShort2: return 2 * sizeof(u16);
 	}
 	return 0;
 }
 
 static u32 get_component_count_of(R_AttributeType attrib) {
-	AssertTrue(8 == AttributeType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_component_count_of");
+	AssertTrue(10 == AttributeType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_component_count_of");
 	switch (attrib) {
 		case AttributeType_Float1: return 1;
 		case AttributeType_Float2: return 2;
@@ -38,12 +38,14 @@ static u32 get_component_count_of(R_AttributeType attrib) {
 		case AttributeType_Integer2: return 2;
 		case AttributeType_Integer3: return 3;
 		case AttributeType_Integer4: return 4;
+		case AttributeType_UByte4Norm: return 4;
+		case AttributeType_UShort2: return 2;
 	}
 	return 0;
 }
 
 static u32 get_type_of(R_AttributeType attrib) {
-	AssertTrue(8 == AttributeType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_type_of");
+	AssertTrue(10 == AttributeType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_type_of");
 	switch (attrib) {
 		case AttributeType_Float1: return GL_FLOAT;
 		case AttributeType_Float2: return GL_FLOAT;
@@ -53,10 +55,16 @@ static u32 get_type_of(R_AttributeType attrib) {
 		case AttributeType_Integer2: return GL_INT;
 		case AttributeType_Integer3: return GL_INT;
 		case AttributeType_Integer4: return GL_INT;
+		case AttributeType_UByte4Norm: return GL_UNSIGNED_BYTE;
+		case AttributeType_UShort2: return GL_UNSIGNED_SHORT;
 	}
 	return GL_INVALID_ENUM;
 }
 
+static b8 get_is_normalized(R_AttributeType attrib) {
+	return attrib == AttributeType_UByte4Norm;
+}
+
 static u32 get_shader_type_of(R_ShaderType type) {
 	AssertTrue(4 == ShaderType_MAX, "[GL33 Backend] Non Exhaustive switch statement: get_shader_type_of");
 	switch (type) {
@@ -165,6 +173,118 @@ static u32 get_buffer_type_of(R_BufferFlags flags) {
 	return 0;
 }
 
+//~ State Cache
+
+// NOTE(voxel): Shadow copy of the bits of GL state that R_PipelineBind and
+// R_Texture2DBindTo touch, so binding the same pipeline or texture twice in a row
+// doesn't go to the driver. Zero matches the defaults of a freshly created context.
+// Everything that deletes a GL object has to forget it here, since names get reused.
+#define GL33_STATE_CACHE_UNIFORM_BUFFERS 16
+#define GL33_STATE_CACHE_TEXTURE_UNITS 32
+
+typedef struct GL33_StateCache {
+	u32 program;
+	u32 vertex_array;
+	u32 uniform_buffers[GL33_STATE_CACHE_UNIFORM_BUFFERS];
+	u32 active_texture_unit;
+	u32 textures[GL33_STATE_CACHE_TEXTURE_UNITS];
+	u32 blend_enabled;
+	u32 blend_src;
+	u32 blend_dst;
+} GL33_StateCache;
+
+static GL33_StateCache s_state;
+static R_FrameStats s_frame_stats;
+static R_FrameStats s_last_frame_stats;
+
+static b8 state_update(u32* cached, u32 value) {
+	if (*cached == value) {
+		s_frame_stats.state_changes_skipped++;
+		return false;
+	}
+	*cached = value;
+	s_frame_stats.state_changes_issued++;
+	return true;
+}
+
+static void state_use_program(u32 program) {
+	if (state_update(&s_state.program, program))
+		glUseProgram(program);
+}
+
+static void state_bind_vertex_array(u32 vertex_array) {
+	if (state_update(&s_state.vertex_array, vertex_array))
+		glBindVertexArray(vertex_array);
+}
+
+static void state_bind_uniform_buffer(u32 index, u32 handle) {
+	if (index >= GL33_STATE_CACHE_UNIFORM_BUFFERS) {
+		s_frame_stats.state_changes_issued++;
+		glBindBufferBase(GL_UNIFORM_BUFFER, index, handle);
+		return;
+	}
+	if (state_update(&s_state.uniform_buffers[index], handle))
+		glBindBufferBase(GL_UNIFORM_BUFFER, index, handle);
+}
+
+// NOTE(voxel): Binds to whichever unit is currently active. Used by the texture
+// functions that only need *a* binding to edit the texture
+static void state_bind_texture(u32 handle) {
+	if (s_state.active_texture_unit >= GL33_STATE_CACHE_TEXTURE_UNITS) {
+		s_frame_stats.state_changes_issued++;
+		glBindTexture(GL_TEXTURE_2D, handle);
+		return;
+	}
+	if (state_update(&s_state.textures[s_state.active_texture_unit], handle))
+		glBindTexture(GL_TEXTURE_2D, handle);
+}
+
+static void state_bind_texture_unit(u32 slot, u32 handle) {
+	if (slot < GL33_STATE_CACHE_TEXTURE_UNITS && s_state.textures[slot] == handle) {
+		s_frame_stats.state_changes_skipped++;
+		return;
+	}
+	if (state_update(&s_state.active_texture_unit, slot))
+		glActiveTexture(GL_TEXTURE0 + slot);
+	state_bind_texture(handle);
+}
+
+static void state_set_blend(b8 enabled, u32 src, u32 dst) {
+	if (state_update(&s_state.blend_enabled, enabled)) {
+		if (enabled) glEnable(GL_BLEND);
+		else glDisable(GL_BLEND);
+	}
+	if (!enabled) return;
+	
+	if (s_state.blend_src == src && s_state.blend_dst == dst) {
+		s_frame_stats.state_changes_skipped++;
+		return;
+	}
+	s_state.blend_src = src;
+	s_state.blend_dst = dst;
+	s_frame_stats.state_changes_issued++;
+	glBlendFunc(src, dst);
+}
+
+static void state_forget_buffer(u32 handle) {
+	for (u32 i = 0; i < GL33_STATE_CACHE_UNIFORM_BUFFERS; i++)
+		if (s_state.uniform_buffers[i] == handle) s_state.uniform_buffers[i] = 0;
+}
+
+static void state_forget_texture(u32 handle) {
+	for (u32 i = 0; i < GL33_STATE_CACHE_TEXTURE_UNITS; i++)
+		if (s_state.textures[i] == handle) s_state.textures[i] = 0;
+}
+
+R_FrameStats R_FrameStatsGet(void) {
+	return s_last_frame_stats;
+}
+
+void R_FrameStatsNext(void) {
+	s_last_frame_stats = s_frame_stats;
+	MemoryZero(&s_frame_stats, sizeof(R_FrameStats));
+}
+
 //~ Function Implementations
 
 void R_BufferAlloc(R_Buffer* buf, R_BufferFlags flags, u32 v_stride) {
@@ -184,6 +304,7 @@ void R_BufferUpdate(R_Buffer* buf, u64 offset, u64 size, void* data) {
 }
 
 void R_BufferFree(R_Buffer* buf) {
+	state_forget_buffer(buf->handle);
 	glDeleteBuffers(1, &buf->handle);
 }
 
@@ -196,10 +317,10 @@ void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member
 	
 	buf->bindpoint = glGetUniformBlockIndex(pack->handle, (const char*) name.str);
 	glGetActiveUniformBlockiv(pack->handle, buf->bindpoint, GL_UNIFORM_BLOCK_DATA_SIZE, (i32*) &buf->size);
-	hash_table_init(string, i32, &buf->uniform_offsets);
+	swiss_table_init(string, i32, &buf->uniform_offsets);
 	
 	// @unsure Maybe use an arena allocation here, instead of a malloc
-	buf->cpu_side_buffer = malloc(buf->size);
+	buf->cpu_side_buffer = M_Alloc(buf->size);
 	MemoryZero(buf->cpu_side_buffer, buf->size);
 	
 	M_Scratch scratch = scratch_get();
@@ -216,7 +337,7 @@ void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member
 	glGetActiveUniformsiv(pack->handle, member_names.len, indices, GL_UNIFORM_OFFSET, offsets);
 	
 	Iterate(member_names, i) {
-		hash_table_set(string, i32, &buf->uniform_offsets, member_names.elems[i], offsets[i]);
+		swiss_table_set(string, i32, &buf->uniform_offsets, member_names.elems[i], offsets[i]);
 	}
 	
 	scratch_return(&scratch);
@@ -227,15 +348,16 @@ void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member
 }
 
 void R_UniformBufferFree(R_UniformBuffer* buf) {
-	hash_table_free(string, i32, &buf->uniform_offsets);
-	free(buf->cpu_side_buffer);
+	swiss_table_free(string, i32, &buf->uniform_offsets);
+	M_Free(buf->cpu_side_buffer);
+	state_forget_buffer(buf->handle);
 	glDeleteBuffers(1, &buf->handle);
 }
 
 
 void R_UniformBufferSetMat4(R_UniformBuffer* buf, string name, mat4 mat) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -245,7 +367,7 @@ void R_UniformBufferSetMat4(R_UniformBuffer* buf, string name, mat4 mat) {
 
 void R_UniformBufferSetInt(R_UniformBuffer* buf, string name, i32 val) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -255,7 +377,7 @@ void R_UniformBufferSetInt(R_UniformBuffer* buf, string name, i32 val) {
 
 void R_UniformBufferSetIntArray(R_UniformBuffer* buf, string name, i32* vals, u32 count) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -265,7 +387,7 @@ void R_UniformBufferSetIntArray(R_UniformBuffer* buf, string name, i32* vals, u3
 
 void R_UniformBufferSetFloat(R_UniformBuffer* buf, string name, f32 val) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -275,7 +397,7 @@ void R_UniformBufferSetFloat(R_UniformBuffer* buf, string name, f32 val) {
 
 void R_UniformBufferSetVec4(R_UniformBuffer* buf, string name, vec4 val) {
 	i32 offset = -1;
-	if (!hash_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
 		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
 		return;
 	}
@@ -283,6 +405,21 @@ void R_UniformBufferSetVec4(R_UniformBuffer* buf, string name, vec4 val) {
 	buf->dirty = true;
 }
 
+// NOTE(voxel): std140 gives vec4 arrays a 16 byte stride, so they're just copied over
+void R_UniformBufferSetVec4Array(R_UniformBuffer* buf, string name, vec4* vals, u32 count) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[GL33 Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	if (offset + sizeof(vec4) * count > buf->size) {
+		LogError("[GL33 Backend] Setting %u elements overflows uniform buffer '%.*s'", count, str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, vals, sizeof(vec4) * count);
+	buf->dirty = true;
+}
+
 //~ Shaders
 
 void R_ShaderAlloc(R_Shader* shader, string data, R_ShaderType type) {
@@ -300,10 +437,10 @@ void R_ShaderAlloc(R_Shader* shader, string data, R_ShaderType type) {
 		
 		i32 length = 0;
 		glGetShaderiv(shader->handle, GL_INFO_LOG_LENGTH, &length);
-		GLchar *info = calloc(length, sizeof(GLchar));
+		GLchar *info = M_AllocZero(length * sizeof(GLchar));
 		glGetShaderInfoLog(shader->handle, length, NULL, info);
 		LogError("%s\n", info);
-		free(info);
+		M_Free(info);
 	}
 }
 
@@ -321,6 +458,7 @@ void R_ShaderPackAlloc(R_ShaderPack* pack, R_Shader* shaders, u32 shader_count)
 	for (u32 i = 0; i < shader_count; i++) {
 		glAttachShader(pack->handle, shaders[i].handle);
 	}
+	GL_ProgramCacheMarkRetrievable(pack->handle);
 	glLinkProgram(pack->handle);
 	
 	i32 ret = 0;
@@ -330,42 +468,65 @@ void R_ShaderPackAlloc(R_ShaderPack* pack, R_Shader* shaders, u32 shader_count)
 		
 		i32 length = 0;
 		glGetProgramiv(pack->handle, GL_INFO_LOG_LENGTH, &length);
-		GLchar *info = calloc(length, sizeof(GLchar));
+		GLchar *info = M_AllocZero(length * sizeof(GLchar));
 		glGetProgramInfoLog(pack->handle, length, NULL, info);
 		LogError("%s\n", info);
-		free(info);
+		M_Free(info);
 	}
 	
 	for (u32 i = 0; i < shader_count; i++) {
 		glDetachShader(pack->handle, shaders[i].handle);
 	}
 	
-	hash_table_init(string, i32, &pack->uniforms);
+	swiss_table_init(string, i32, &pack->uniforms);
 }
 
 void R_ShaderPackAllocLoad(R_ShaderPack* pack, string fp_prefix) {
-	M_Scratch scratch = scratch_get();
+	M_Arena arena;
+	arena_init(&arena);
 	
-	string vsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".vert.glsl"));
-	string fsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".frag.glsl"));
-	string gsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".geom.glsl"));
+	string vsfp = str_cat(&arena, fp_prefix, str_lit(".vert.glsl"));
+	string fsfp = str_cat(&arena, fp_prefix, str_lit(".frag.glsl"));
+	string gsfp = str_cat(&arena, fp_prefix, str_lit(".geom.glsl"));
 	
-	R_Shader* shader_buffer = arena_alloc(&scratch.arena, sizeof(R_Shader) * 3);
+	string sources[3];
+	R_ShaderType types[3];
 	u32 shader_count = 0;
 	
 	if (!OS_FileExists(vsfp))
 		LogError("[GL33 Backend] The Vertex Shader File '%s.vert.glsl' doesn't exist", fp_prefix.str);
 	else Log("[GL33 Backend] Loading Vertex Shader '%s.vert.glsl'", fp_prefix.str);
-	R_ShaderAllocLoad(&shader_buffer[shader_count++], vsfp, ShaderType_Vertex);
+	types[shader_count] = ShaderType_Vertex;
+	sources[shader_count++] = OS_FileRead(&arena, vsfp);
 	
 	if (!OS_FileExists(fsfp))
 		LogError("[GL33 Backend] The Fragment Shader File '%s.frag.glsl' doesn't exist", fp_prefix.str);
 	else Log("[GL33 Backend] Loading Fragment Shader '%s.frag.glsl'", fp_prefix.str);
-	R_ShaderAllocLoad(&shader_buffer[shader_count++], fsfp, ShaderType_Fragment);
+	types[shader_count] = ShaderType_Fragment;
+	sources[shader_count++] = OS_FileRead(&arena, fsfp);
 	
 	if (OS_FileExists(gsfp)) {
 		Log("[GL33 Backend] Loading Geometry Shader '%s.geom.glsl'", fp_prefix.str);
-		R_ShaderAllocLoad(&shader_buffer[shader_count++], gsfp, ShaderType_Geometry);
+		types[shader_count] = ShaderType_Geometry;
+		sources[shader_count++] = OS_FileRead(&arena, gsfp);
+	}
+	
+	u64 start = OS_TimeMicrosecondsNow();
+	u64 key = GL_ProgramCacheKey(sources, shader_count);
+	
+	pack->handle = glCreateProgram();
+	if (GL_ProgramCacheLoad(pack->handle, key)) {
+		swiss_table_init(string, i32, &pack->uniforms);
+		Log("[GL33 Backend] Loaded program '%.*s' from the binary cache in %.2f ms", str_expand(fp_prefix),
+			(OS_TimeMicrosecondsNow() - start) / 1000.0);
+		arena_free(&arena);
+		return;
+	}
+	glDeleteProgram(pack->handle);
+	
+	R_Shader shader_buffer[3];
+	for (u32 i = 0; i < shader_count; i++) {
+		R_ShaderAlloc(&shader_buffer[i], sources[i], types[i]);
 	}
 	
 	R_ShaderPackAlloc(pack, shader_buffer, shader_count);
@@ -374,56 +535,60 @@ void R_ShaderPackAllocLoad(R_ShaderPack* pack, string fp_prefix) {
 		R_ShaderFree(&shader_buffer[i]);
 	}
 	
-	scratch_return(&scratch);
+	GL_ProgramCacheStore(pack->handle, key);
+	Log("[GL33 Backend] Compiled program '%.*s' in %.2f ms", str_expand(fp_prefix),
+		(OS_TimeMicrosecondsNow() - start) / 1000.0);
+	arena_free(&arena);
 }
 
 void R_ShaderPackFree(R_ShaderPack* pack) {
-	hash_table_free(string, i32, &pack->uniforms);
+	swiss_table_free(string, i32, &pack->uniforms);
+	if (s_state.program == pack->handle) s_state.program = 0;
 	glDeleteProgram(pack->handle);
 }
 
 
 void R_ShaderPackUploadMat4(R_ShaderPack* pack, string name, mat4 mat) {
 	i32 loc;
-    if (!hash_table_get(string, i32, &pack->uniforms, name, &loc)) {
+    if (!swiss_table_get(string, i32, &pack->uniforms, name, &loc)) {
         loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        hash_table_set(string, i32, &pack->uniforms, name, loc);
+        swiss_table_set(string, i32, &pack->uniforms, name, loc);
     }
     glUniformMatrix4fv(loc, 1, GL_FALSE, mat.a);
 }
 
 void R_ShaderPackUploadInt(R_ShaderPack* pack, string name, i32 val) {
 	i32 loc;
-    if (!hash_table_get(string, i32, &pack->uniforms, name, &loc)) {
+    if (!swiss_table_get(string, i32, &pack->uniforms, name, &loc)) {
         loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        hash_table_set(string, i32, &pack->uniforms, name, loc);
+        swiss_table_set(string, i32, &pack->uniforms, name, loc);
     }
     glUniform1i(loc, val);
 }
 
 void R_ShaderPackUploadIntArray(R_ShaderPack* pack, string name, i32* vals, u32 count) {
 	i32 loc;
-    if (!hash_table_get(string, i32,&pack->uniforms, name, &loc)) {
+    if (!swiss_table_get(string, i32,&pack->uniforms, name, &loc)) {
         loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        hash_table_set(string, i32, &pack->uniforms, name, loc);
+        swiss_table_set(string, i32, &pack->uniforms, name, loc);
     }
     glUniform1iv(loc, count, vals);
 }
 
 void R_ShaderPackUploadFloat(R_ShaderPack* pack, string name, f32 val) {
 	i32 loc;
-    if (!hash_table_get(string, i32, &pack->uniforms, name, &loc)) {
+    if (!swiss_table_get(string, i32, &pack->uniforms, name, &loc)) {
         loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        hash_table_set(string, i32, &pack->uniforms, name, loc);
+        swiss_table_set(string, i32, &pack->uniforms, name, loc);
     }
     glUniform1f(loc, val);
 }
 
 void R_ShaderPackUploadVec4(R_ShaderPack* pack, string name, vec4 val) {
 	i32 loc;
-    if (!hash_table_get(string, i32, &pack->uniforms, name, &loc)) {
+    if (!swiss_table_get(string, i32, &pack->uniforms, name, &loc)) {
         loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        hash_table_set(string, i32, &pack->uniforms, name, loc);
+        swiss_table_set(string, i32, &pack->uniforms, name, loc);
     }
     glUniform4f(loc, val.x, val.y, val.z, val.w);
 }
@@ -442,7 +607,7 @@ void R_PipelineAlloc(R_Pipeline* in, R_InputAssembly assembly, R_Attribute* attr
 
 void R_PipelineAddBuffer(R_Pipeline* in, R_Buffer* buf, u32 attribute_count) {
 	if (buf->flags & BufferFlag_Type_Vertex) {
-		glBindVertexArray(in->handle);
+		state_bind_vertex_array(in->handle);
 		u32 stride = 0;
 		for (u32 i = in->attribpoint; i < in->attribpoint + attribute_count; i++) {
 			stride += get_size_of(in->attributes[i].type);
@@ -452,12 +617,15 @@ void R_PipelineAddBuffer(R_Pipeline* in, R_Buffer* buf, u32 attribute_count) {
 		u32 offset = 0;
 		for (u32 i = in->attribpoint; i < in->attribpoint + attribute_count; i++) {
 			glVertexAttribPointer(i, get_component_count_of(in->attributes[i].type),
-								  get_type_of(in->attributes[i].type), GL_FALSE, stride, (void*) offset);
+								  get_type_of(in->attributes[i].type), get_is_normalized(in->attributes[i].type),
+								  stride, (void*) offset);
 			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, buf->flags & BufferFlag_PerInstance ? 1 : 0);
 			offset += get_size_of(in->attributes[i].type);
 		}
+		in->attribpoint += attribute_count;
 	} else if (buf->flags & BufferFlag_Type_Index) {
-		glBindVertexArray(in->handle);
+		state_bind_vertex_array(in->handle);
 		glBindBuffer(get_buffer_type_of(buf->flags), buf->handle);
 	}
 }
@@ -467,37 +635,37 @@ void R_PipelineAddUniformBuffer(R_Pipeline* in, R_UniformBuffer* buf) {
 }
 
 void R_PipelineBind(R_Pipeline* in) {
-	glUseProgram(in->shader->handle);
-	glBindVertexArray(in->handle);
+	state_use_program(in->shader->handle);
+	state_bind_vertex_array(in->handle);
 	
 	Iterate(in->uniform_buffers, i) {
 		R_UniformBuffer* curr = in->uniform_buffers.elems[i];
-		glBindBuffer(GL_UNIFORM_BUFFER, curr->handle);
 		if (curr->dirty) {
+			glBindBuffer(GL_UNIFORM_BUFFER, curr->handle);
 			glBufferSubData(GL_UNIFORM_BUFFER, 0, curr->size, curr->cpu_side_buffer);
 			curr->dirty = false;
 		}
-		glBindBufferBase(GL_UNIFORM_BUFFER, i, curr->handle);
+		state_bind_uniform_buffer(i, curr->handle);
 	}
 	
 	switch (in->blend_mode) {
 		case BlendMode_None: {
-			glDisable(GL_BLEND);
+			state_set_blend(false, 0, 0);
 		} break;
 		
 		case BlendMode_Alpha: {
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			state_set_blend(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		} break;
 		
 		default: {
-			glDisable(GL_BLEND);
+			state_set_blend(false, 0, 0);
 		} break;
 	}
 }
 
 void R_PipelineFree(R_Pipeline* in) {
 	darray_free(R_UniformBufferHandle, &in->uniform_buffers);
+	if (s_state.vertex_array == in->handle) s_state.vertex_array = 0;
 	glDeleteVertexArrays(1, &in->handle);
 }
 
@@ -519,7 +687,7 @@ void R_Texture2DAlloc(R_Texture2D* texture, R_TextureFormat format, u32 width, u
 	texture->usage = usage;
 	
 	glGenTextures(1, &texture->handle);
-	glBindTexture(GL_TEXTURE_2D, texture->handle);
+	state_bind_texture(texture->handle);
 	
 	u32 datatype = format == TextureFormat_DepthStencil ? GL_UNSIGNED_INT_24_8 : GL_UNSIGNED_BYTE;
 	
@@ -557,27 +725,34 @@ void R_Texture2DSwizzle(R_Texture2D* texture, i32* swizzles) {
 		get_texture_channel_of(swizzles[2]),
 		get_texture_channel_of(swizzles[3]),
 	};
-	glBindTexture(GL_TEXTURE_2D, texture->handle);
+	state_bind_texture(texture->handle);
 	glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, fixed);
 }
 
 void R_Texture2DData(R_Texture2D* texture, void* data) {
 	u32 datatype =
 		texture->format == TextureFormat_DepthStencil ? GL_UNSIGNED_INT_24_8 : GL_UNSIGNED_BYTE;
-	glBindTexture(GL_TEXTURE_2D, texture->handle);
+	state_bind_texture(texture->handle);
 	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture->width, texture->height, get_texture_format_type_of(texture->format), datatype, data);
 }
 
+void R_Texture2DSubData(R_Texture2D* texture, u32 x, u32 y, u32 width, u32 height, void* data) {
+	u32 datatype =
+		texture->format == TextureFormat_DepthStencil ? GL_UNSIGNED_INT_24_8 : GL_UNSIGNED_BYTE;
+	state_bind_texture(texture->handle);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, get_texture_format_type_of(texture->format), datatype, data);
+}
+
 b8 R_Texture2DEquals(R_Texture2D* a, R_Texture2D* b) {
 	return a->handle == b->handle;
 }
 
 void R_Texture2DBindTo(R_Texture2D* texture, u32 slot) {
-	glActiveTexture(GL_TEXTURE0 + slot);
-	glBindTexture(GL_TEXTURE_2D, texture->handle);
+	state_bind_texture_unit(slot, texture->handle);
 }
 
 void R_Texture2DFree(R_Texture2D* texture) {
+	state_forget_texture(texture->handle);
 	glDeleteTextures(1, &texture->handle);
 }
 
@@ -590,7 +765,7 @@ void R_FramebufferCreate(R_Framebuffer* framebuffer, u32 width, u32 height, R_Te
 	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
 	framebuffer->width = width;
 	framebuffer->height = height;
-	framebuffer->color_attachments = malloc(sizeof(R_Texture2D) * color_attachment_count);
+	framebuffer->color_attachments = M_Alloc(sizeof(R_Texture2D) * color_attachment_count);
 	MemoryZero(framebuffer->color_attachments, sizeof(R_Texture2D) * color_attachment_count);
 	framebuffer->depth_attachment = depth_attachment;
 	framebuffer->color_attachment_count = color_attachment_count;
@@ -685,7 +860,7 @@ void R_FramebufferFree(R_Framebuffer* framebuffer) {
 	for (u32 i = 0; i < framebuffer->color_attachment_count; i++) {
 		R_Texture2DFree(&framebuffer->color_attachments[i]);
 	}
-	free(framebuffer->color_attachments);
+	M_Free(framebuffer->color_attachments);
 	if (framebuffer->depth_attachment.format != TextureFormat_Invalid)
 		R_Texture2DFree(&framebuffer->depth_attachment);
 	glDeleteFramebuffers(1, &framebuffer->handle);
@@ -711,5 +886,11 @@ void R_Viewport(i32 x, i32 y, i32 w, i32 h) {
 }
 
 void R_Draw(R_Pipeline* in, u32 start, u32 count) {
+	s_frame_stats.draw_calls++;
 	glDrawArrays(get_input_assembly_type_of(in->assembly), start, count);
 }
+
+void R_DrawInstanced(R_Pipeline* in, u32 start, u32 count, u32 instance_count) {
+	s_frame_stats.draw_calls++;
+	glDrawArraysInstanced(get_input_assembly_type_of(in->assembly), start, count, instance_count);
+}
@@ -3,7 +3,7 @@
 #ifndef GL46_RESOURCES_H
 #define GL46_RESOURCES_H
 
-HashTable_Prototype(string, i32);
+SwissTable_Prototype(string, i32);
 
 typedef struct R_Buffer {
 	R_BufferFlags flags;
@@ -17,7 +17,7 @@ typedef struct R_Buffer {
 typedef struct R_UniformBuffer {
 	R_ShaderType stage;
 	string name;
-	hash_table(string, i32) uniform_offsets;
+	swiss_table(string, i32) uniform_offsets;
 	u8* cpu_side_buffer;
 	b8  dirty;
 	u32 size;
@@ -31,7 +31,7 @@ typedef struct R_Shader {
 } R_Shader;
 
 typedef struct R_ShaderPack {
-	hash_table(string, i32) uniforms;
+	swiss_table(string, i32) uniforms;
 	u32 handle;
 } R_ShaderPack;
 
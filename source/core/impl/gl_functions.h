@@ -203,6 +203,17 @@ typedef void (*GLDEBUGPROC) (GLenum source,GLenum type,GLuint id,GLenum severity
 
 #define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
 
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_TIME_ELAPSED 0x88BF
+
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
 #if defined(BACKEND_GL33)
 
 #  define GL_FUNCTIONS \
@@ -235,8 +246,10 @@ X(glGenVertexArrays, void, (GLsizei count, GLuint* vao_handles))\
 X(glBindVertexArray, void, (GLuint vao_handle))\
 X(glVertexAttribPointer, void, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer))\
 X(glEnableVertexAttribArray, void, (GLuint index))\
+X(glVertexAttribDivisor, void, (GLuint index, GLuint divisor))\
 X(glDeleteVertexArrays, void, (GLsizei count, const GLuint* vao_handles))\
 X(glDrawArrays, void, (GLenum mode, GLint first, GLsizei count))\
+X(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instance_count))\
 X(glClear, void, (GLbitfield mask))\
 X(glClearColor, void, (GLfloat r, GLfloat g, GLfloat b, GLfloat a))\
 X(glGenTextures, void, (GLsizei count, GLuint* texture_handles))\
@@ -268,6 +281,17 @@ X(glGetActiveUniformsiv, void, (GLuint program, GLsizei uniformCount, const GLui
 X(glGetActiveUniformBlockiv, void, (GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params))\
 X(glBindBufferBase, void, (GLenum target, GLuint index, GLuint buffer_handle))\
 X(glGetActiveUniform, void, (GLuint program, GLuint index, GLsizei bufSize, GLsizei *length, GLint *size, GLenum *type, GLchar *name))\
+X(glGenQueries, void, (GLsizei count, GLuint* query_handles))\
+X(glDeleteQueries, void, (GLsizei count, const GLuint* query_handles))\
+X(glBeginQuery, void, (GLenum target, GLuint query_handle))\
+X(glEndQuery, void, (GLenum target))\
+X(glGetQueryObjectiv, void, (GLuint query_handle, GLenum pname, GLint* params))\
+X(glGetQueryObjectui64v, void, (GLuint query_handle, GLenum pname, GLuint64* params))\
+X(glGetString, const GLubyte*, (GLenum name))\
+X(glGetIntegerv, void, (GLenum pname, GLint* data))\
+X(glGetProgramBinary, void, (GLuint program_handle, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary))\
+X(glProgramBinary, void, (GLuint program_handle, GLenum binary_format, const void* binary, GLsizei length))\
+X(glProgramParameteri, void, (GLuint program_handle, GLenum pname, GLint value))\
 
 #  define GL_DEBUG_FUNCTIONS
 
@@ -305,8 +329,10 @@ X(glVertexArrayAttribBinding, void, (GLuint vao_handle, GLuint attribute_index,
 X(glVertexArrayVertexBuffer, void, (GLuint vao_handle, GLuint binding_index, GLuint buffer_handle, GLintptr offset, GLsizei stride))\
 X(glVertexArrayElementBuffer, void, (GLuint vaobj, GLuint buffer_handle))\
 X(glEnableVertexArrayAttrib, void, (GLuint vao_handle, GLuint index))\
+X(glVertexArrayBindingDivisor, void, (GLuint vao_handle, GLuint binding_index, GLuint divisor))\
 X(glDeleteVertexArrays, void, (GLsizei count, const GLuint* vao_handles))\
 X(glDrawArrays, void, (GLenum mode, GLint first, GLsizei count))\
+X(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instance_count))\
 X(glClear, void, (GLbitfield mask))\
 X(glClearColor, void, (GLfloat r, GLfloat g, GLfloat b, GLfloat a))\
 X(glCreateTextures, void, (GLenum type, GLsizei count, GLuint* texture_handles))\
@@ -338,6 +364,17 @@ X(glGetUniformIndices, void, (GLuint program, GLsizei uniformCount, const GLchar
 X(glGetActiveUniformsiv, void, (GLuint program, GLsizei uniformCount, const GLuint* uniformIndices, GLenum pname, GLint *params))\
 X(glGetActiveUniformBlockiv, void, (GLuint program, GLuint uniformBlockIndex, GLenum pname, GLint* params))\
 X(glBindBufferBase, void, (GLenum target, GLuint index, GLuint buffer_handle))\
+X(glGenQueries, void, (GLsizei count, GLuint* query_handles))\
+X(glDeleteQueries, void, (GLsizei count, const GLuint* query_handles))\
+X(glBeginQuery, void, (GLenum target, GLuint query_handle))\
+X(glEndQuery, void, (GLenum target))\
+X(glGetQueryObjectiv, void, (GLuint query_handle, GLenum pname, GLint* params))\
+X(glGetQueryObjectui64v, void, (GLuint query_handle, GLenum pname, GLuint64* params))\
+X(glGetString, const GLubyte*, (GLenum name))\
+X(glGetIntegerv, void, (GLenum pname, GLint* data))\
+X(glGetProgramBinary, void, (GLuint program_handle, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary))\
+X(glProgramBinary, void, (GLuint program_handle, GLenum binary_format, const void* binary, GLsizei length))\
+X(glProgramParameteri, void, (GLuint program_handle, GLenum pname, GLint value))\
 
 #if defined(_DEBUG)
 #  define GL_DEBUG_FUNCTIONS \
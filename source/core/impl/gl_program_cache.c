@@ -0,0 +1,130 @@
+//~ OpenGL Program Binary Cache (Shared between GL33 and GL46)
+#include "gl_functions.h"
+
+// NOTE(voxel): Linked programs are saved with glGetProgramBinary under the user data
+// folder, one file per program. The key hashes every shader source together with the
+// driver vendor, renderer and version strings, so a driver update or an edited shader
+// simply misses and recompiles. Drivers are also free to reject a binary they gave out
+// earlier, in which case glProgramBinary fails the link status and we recompile too.
+#define GL_PROGRAM_CACHE_MAGIC 0x42505343 // 'CSPB'
+#define GL_PROGRAM_CACHE_VERSION 2
+
+typedef struct GL_ProgramCacheHeader {
+	u32 magic;
+	u32 version;
+	u64 key;
+	u32 binary_format;
+	u32 binary_length;
+} GL_ProgramCacheHeader;
+
+// -1 until the first query, then whether the driver can hand out binaries at all
+static i32 s_program_cache_supported = -1;
+
+static b8 GL_ProgramCacheSupported(void) {
+	if (s_program_cache_supported == -1) {
+		i32 format_count = 0;
+		if (glGetIntegerv && glGetProgramBinary && glProgramBinary && glProgramParameteri)
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+		s_program_cache_supported = format_count > 0;
+		if (!s_program_cache_supported)
+			Log("[GL Backend] Driver has no program binary formats, shaders will always be compiled");
+	}
+	return s_program_cache_supported;
+}
+
+static string GL_ProgramCachePath(M_Arena* arena, u64 key) {
+	string dir = str_cat(arena, OS_Filepath(arena, SystemPath_UserData), str_lit("/.chip8-sim"));
+	if (!OS_FileExists(dir)) OS_FileCreateDir(dir);
+	dir = str_cat(arena, dir, str_lit("/shader_cache"));
+	if (!OS_FileExists(dir)) OS_FileCreateDir(dir);
+	return str_from_format(arena, "%.*s/%016llx.bin", str_expand(dir), key);
+}
+
+static u64 GL_ProgramCacheKey(string* sources, u32 source_count) {
+	GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	u64 key = GL_PROGRAM_CACHE_VERSION;
+	for (u32 i = 0; i < ArrayCount(driver_strings); i++) {
+		const GLubyte* driver_string = glGetString(driver_strings[i]);
+		string s = driver_string ? str_make((char*) driver_string) : str_lit("");
+		key ^= str_hash_64(s) + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+	}
+	for (u32 i = 0; i < source_count; i++) {
+		key ^= str_hash_64(sources[i]) + 0x9E3779B97F4A7C15ull + (key << 6) + (key >> 2);
+	}
+	return key;
+}
+
+// Has to happen before glLinkProgram for the binary to be retrievable afterwards
+static void GL_ProgramCacheMarkRetrievable(u32 program) {
+	if (GL_ProgramCacheSupported())
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+static b8 GL_ProgramCacheLoad(u32 program, u64 key) {
+	if (!GL_ProgramCacheSupported()) return false;
+
+	M_Arena arena;
+	arena_init(&arena);
+	string path = GL_ProgramCachePath(&arena, key);
+	b8 loaded = false;
+
+	if (OS_FileExists(path)) {
+		string file = OS_FileRead(&arena, path);
+		GL_ProgramCacheHeader header = {0};
+		if (file.size >= sizeof(header)) MemoryCopy(&header, file.str, sizeof(header));
+
+		if (header.magic == GL_PROGRAM_CACHE_MAGIC && header.version == GL_PROGRAM_CACHE_VERSION &&
+			header.key == key && header.binary_length == file.size - sizeof(header)) {
+			glProgramBinary(program, header.binary_format, file.str + sizeof(header), header.binary_length);
+			i32 ret = 0;
+			glGetProgramiv(program, GL_LINK_STATUS, &ret);
+			loaded = ret == GL_TRUE;
+		}
+		if (!loaded) {
+			Log("[GL Backend] Discarding stale program binary '%.*s'", str_expand(path));
+			OS_FileDelete(path);
+		}
+	}
+
+	arena_free(&arena);
+	return loaded;
+}
+
+static void GL_ProgramCacheStore(u32 program, u64 key) {
+	if (!GL_ProgramCacheSupported()) return;
+
+	i32 ret = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &ret);
+	if (ret != GL_TRUE) return;
+
+	i32 length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	M_Arena arena;
+	arena_init(&arena);
+	u8* file = arena_alloc(&arena, sizeof(GL_ProgramCacheHeader) + length);
+	GL_ProgramCacheHeader* header = (GL_ProgramCacheHeader*) file;
+	header->magic = GL_PROGRAM_CACHE_MAGIC;
+	header->version = GL_PROGRAM_CACHE_VERSION;
+	header->key = key;
+
+	GLsizei written = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &written, &format, file + sizeof(GL_ProgramCacheHeader));
+	header->binary_format = format;
+	header->binary_length = written;
+
+	// Written next to the final name and renamed, so a crash never leaves half a binary
+	if (written > 0) {
+		string path = GL_ProgramCachePath(&arena, key);
+		string temp_path = str_cat(&arena, path, str_lit(".tmp"));
+		string data = { file, sizeof(GL_ProgramCacheHeader) + written };
+		if (!OS_FileCreateWrite(temp_path, data) || !OS_FileRename(temp_path, path)) {
+			LogError("[GL Backend] Couldn't write program binary '%.*s'", str_expand(path));
+			OS_FileDelete(temp_path);
+		}
+	}
+
+	arena_free(&arena);
+}
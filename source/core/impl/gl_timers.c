@@ -0,0 +1,121 @@
+//~ OpenGL GPU Timers (Shared between GL33 and GL46)
+
+// NOTE(voxel): Every scope owns a small ring of GL_TIME_ELAPSED queries. Begin first
+// harvests whichever old queries have finished, and if the GPU is so far behind that
+// the whole ring is still in flight, that frame just doesn't get timed.
+#define GL_TIMER_RING_SIZE 4
+#define GL_TIMER_NAME_SIZE 32
+
+typedef struct GL_TimerScope {
+	u8  name_buffer[GL_TIMER_NAME_SIZE];
+	string name;
+	
+	u32 queries[GL_TIMER_RING_SIZE];
+	u32 write_index;
+	u32 read_index;
+	u32 pending;
+	
+	f64 history[R_GPU_TIMER_HISTORY];
+	f64 history_sum;
+	u32 history_index;
+	u32 history_count;
+	f64 last_ms;
+} GL_TimerScope;
+
+static GL_TimerScope s_timer_scopes[R_GPU_TIMER_MAX_SCOPES];
+static u32 s_timer_scope_count;
+static GL_TimerScope* s_timer_active;
+static b8 s_timer_active_skipped;
+
+// Scopes only keep the first GL_TIMER_NAME_SIZE bytes, so longer names are compared on those
+static string GL_TimerName(string name) {
+	return (string) { name.str, Min(name.size, GL_TIMER_NAME_SIZE) };
+}
+
+static GL_TimerScope* GL_TimerScopeGet(string name) {
+	name = GL_TimerName(name);
+	for (u32 i = 0; i < s_timer_scope_count; i++) {
+		if (str_eq(s_timer_scopes[i].name, name))
+			return &s_timer_scopes[i];
+	}
+	if (s_timer_scope_count == R_GPU_TIMER_MAX_SCOPES) {
+		LogError("[GL Backend] Ran out of GPU timer scopes, '%.*s' will not be timed", str_expand(name));
+		return nullptr;
+	}
+	
+	GL_TimerScope* scope = &s_timer_scopes[s_timer_scope_count++];
+	MemoryZeroStruct(scope, GL_TimerScope);
+	MemoryCopy(scope->name_buffer, name.str, name.size);
+	scope->name = (string) { scope->name_buffer, name.size };
+	glGenQueries(GL_TIMER_RING_SIZE, scope->queries);
+	return scope;
+}
+
+static void GL_TimerScopeHarvest(GL_TimerScope* scope) {
+	while (scope->pending) {
+		u32 query = scope->queries[scope->read_index];
+		i32 available = 0;
+		glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+		
+		GLuint64 elapsed_ns = 0;
+		glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+		scope->read_index = (scope->read_index + 1) % GL_TIMER_RING_SIZE;
+		scope->pending--;
+		
+		f64 ms = (f64) elapsed_ns / 1000000.0;
+		scope->last_ms = ms;
+		scope->history_sum -= scope->history[scope->history_index];
+		scope->history[scope->history_index] = ms;
+		scope->history_sum += ms;
+		scope->history_index = (scope->history_index + 1) % R_GPU_TIMER_HISTORY;
+		if (scope->history_count < R_GPU_TIMER_HISTORY) scope->history_count++;
+	}
+}
+
+void R_GPUTimerBegin(string name) {
+	if (s_timer_active) {
+		LogError("[GL Backend] GPU timer '%.*s' started inside '%.*s'. Timer scopes can't nest",
+				 str_expand(name), str_expand(s_timer_active->name));
+		return;
+	}
+	GL_TimerScope* scope = GL_TimerScopeGet(name);
+	if (!scope) return;
+	
+	GL_TimerScopeHarvest(scope);
+	s_timer_active = scope;
+	s_timer_active_skipped = scope->pending == GL_TIMER_RING_SIZE;
+	if (!s_timer_active_skipped)
+		glBeginQuery(GL_TIME_ELAPSED, scope->queries[scope->write_index]);
+}
+
+void R_GPUTimerEnd(string name) {
+	if (!s_timer_active) return;
+	if (!str_eq(s_timer_active->name, GL_TimerName(name))) {
+		LogError("[GL Backend] GPU timer '%.*s' ended while '%.*s' was running",
+				 str_expand(name), str_expand(s_timer_active->name));
+	}
+	
+	GL_TimerScope* scope = s_timer_active;
+	s_timer_active = nullptr;
+	if (s_timer_active_skipped) return;
+	
+	glEndQuery(GL_TIME_ELAPSED);
+	scope->write_index = (scope->write_index + 1) % GL_TIMER_RING_SIZE;
+	scope->pending++;
+}
+
+u32 R_GPUTimerCount(void) {
+	return s_timer_scope_count;
+}
+
+R_GPUTimerStats R_GPUTimerGet(u32 index) {
+	if (index >= s_timer_scope_count) return (R_GPUTimerStats) {0};
+	GL_TimerScope* scope = &s_timer_scopes[index];
+	return (R_GPUTimerStats) {
+		.name = scope->name,
+		.last_ms = scope->last_ms,
+		.average_ms = scope->history_count ? scope->history_sum / scope->history_count : 0.0,
+		.sample_count = scope->history_count,
+	};
+}
@@ -205,7 +205,10 @@ void B_BackendSelectRenderWindow(OS_Window* _window) {
 
 void B_BackendSwapchainNext(OS_Window* _window) {
 	X11_Window* window = (X11_Window*) _window;
+	R_GPUTimerBegin(str_lit("B_BackendSwapchainNext"));
 	v_glXSwapBuffers(window->display, window->handle);
+	R_GPUTimerEnd(str_lit("B_BackendSwapchainNext"));
+	R_FrameStatsNext();
 }
 
 void B_BackendFree(OS_Window* _window) {
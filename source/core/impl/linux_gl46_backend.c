@@ -92,6 +92,10 @@ static Linux_glXDestroyContext* v_glXDestroyContext = 0;
 
 //~
 
+static int X11_IgnoreContextError(Display* display, XErrorEvent* event) {
+	return 0;
+}
+
 long_func* error_loader(const char* name) {
 	LogError("[X11 GL33 Backend] Failed to load %s", name);
 	return (long_func*) nullptr;
@@ -193,7 +197,21 @@ void B_BackendInitShared(OS_Window* _window, OS_Window* _share) {
 			None
 		};
 		
+		// NOTE(voxel): Mesa's llvmpipe stops at 4.5, which has every DSA entry point this
+		// backend uses. A failed attempt raises an X error, so swallow those meanwhile
+		XErrorHandler old_handler = XSetErrorHandler(X11_IgnoreContextError);
 		window->gl_context = v_glXCreateContextAttribsARB(window->display, fbc[0], NULL, true, context_attribs);
+		XSync(window->display, False);
+		if (!window->gl_context) {
+			context_attribs[3] = 5;
+			window->gl_context = v_glXCreateContextAttribsARB(window->display, fbc[0], NULL, true, context_attribs);
+			XSync(window->display, False);
+			if (window->gl_context) Log("[GL46 Backend] OpenGL 4.6 unavailable, running on a 4.5 context");
+		}
+		XSetErrorHandler(old_handler);
+		if (!window->gl_context) {
+			LogReturn(, "[GL46 Backend] Failed to create an OpenGL 4.5+ context");
+		}
 		
 		__LoadGLFunctions(glXGetProcAddress, error_loader);
 	}
@@ -215,7 +233,10 @@ void B_BackendSelectRenderWindow(OS_Window* _window) {
 
 void B_BackendSwapchainNext(OS_Window* _window) {
 	X11_Window* window = (X11_Window*) _window;
+	R_GPUTimerBegin(str_lit("B_BackendSwapchainNext"));
 	v_glXSwapBuffers(window->display, window->handle);
+	R_GPUTimerEnd(str_lit("B_BackendSwapchainNext"));
+	R_FrameStatsNext();
 }
 
 void B_BackendFree(OS_Window* _window) {
@@ -0,0 +1,97 @@
+#include "os/impl/x11_window.h"
+#include "base/log.h"
+#include <X11/Xutil.h>
+
+// NOTE(voxel): Implemented in soft_resources.c
+void __SoftScreenResize(u32 width, u32 height);
+void __SoftScreenGet(u32** pixels, u32* width, u32* height);
+void __SoftScreenFree(void);
+
+//~ Presentation
+
+static void X11_SoftImageRecreate(X11_Window* window, u32 width, u32 height) {
+	// XDestroyImage frees the pixel data too
+	if (window->image) XDestroyImage(window->image);
+
+	i32 screen = DefaultScreen(window->display);
+	char* data = malloc(width * height * sizeof(u32));
+	window->image = XCreateImage(window->display, DefaultVisual(window->display, screen),
+								 DefaultDepth(window->display, screen), ZPixmap, 0, data,
+								 width, height, 32, 0);
+	if (!window->image) {
+		free(data);
+		LogError("[Soft Backend] XCreateImage failed, nothing will be presented");
+	}
+}
+
+//~ Backend
+
+void B_BackendInitShared(OS_Window* _window, OS_Window* _share) {
+	X11_Window* window = (X11_Window*) _window;
+	__SoftScreenResize(window->width, window->height);
+	R_Viewport(0, 0, window->width, window->height);
+
+	if (!window->display) {
+		Log("[Soft Backend] No X11 display, rendering offscreen");
+		return;
+	}
+
+	i32 screen = DefaultScreen(window->display);
+	Visual* visual = DefaultVisual(window->display, screen);
+	i32 depth = DefaultDepth(window->display, screen);
+	if ((depth != 24 && depth != 32) || visual->red_mask != 0xFF0000 ||
+		visual->green_mask != 0x00FF00 || visual->blue_mask != 0x0000FF) {
+		LogReturn(, "[Soft Backend] Only 0xRRGGBB TrueColor visuals are supported, rendering offscreen");
+	}
+
+	window->gc = XCreateGC(window->display, window->handle, 0, nullptr);
+}
+
+void B_BackendInit(OS_Window* _window) {
+	B_BackendInitShared(_window, 0);
+}
+
+void B_BackendSelectRenderWindow(OS_Window* _window) {
+
+}
+
+void B_BackendSwapchainNext(OS_Window* _window) {
+	X11_Window* window = (X11_Window*) _window;
+	R_GPUTimerBegin(str_lit("B_BackendSwapchainNext"));
+
+	u32* pixels; u32 width, height;
+	__SoftScreenGet(&pixels, &width, &height);
+	if (window->gc && pixels) {
+		if (!window->image || window->image->width != width || window->image->height != height)
+			X11_SoftImageRecreate(window, width, height);
+
+		if (window->image) {
+			// 0xAABBGGRR bottom-up to 0x00RRGGBB top-down
+			u32 pitch = window->image->bytes_per_line / sizeof(u32);
+			u32* dst = (u32*) window->image->data;
+			for (u32 j = 0; j < height; j++) {
+				u32* src_row = pixels + (height - 1 - j) * width;
+				u32* dst_row = dst + j * pitch;
+				for (u32 i = 0; i < width; i++) {
+					u32 p = src_row[i];
+					dst_row[i] = ((p & 0xFF) << 16) | (p & 0xFF00) | ((p >> 16) & 0xFF);
+				}
+			}
+
+			XPutImage(window->display, window->handle, window->gc, window->image, 0, 0, 0, 0, width, height);
+			XSync(window->display, False);
+		}
+	}
+
+	R_GPUTimerEnd(str_lit("B_BackendSwapchainNext"));
+	R_FrameStatsNext();
+}
+
+void B_BackendFree(OS_Window* _window) {
+	X11_Window* window = (X11_Window*) _window;
+	if (window->image) XDestroyImage(window->image);
+	if (window->gc) XFreeGC(window->display, window->gc);
+	window->image = nullptr;
+	window->gc = nullptr;
+	__SoftScreenFree();
+}
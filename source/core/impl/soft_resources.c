@@ -0,0 +1,1384 @@
+//~ Software Rasterizer Resources
+#include <stb/stb_image.h>
+#include <math.h>
+
+#include "soft_resources.h"
+
+SwissTable_Impl(string, i32, str_eq, str_hash);
+DArray_Impl(R_UniformBufferHandle);
+
+// NOTE(voxel): Everything here mirrors what the GL backends do, just on the CPU.
+// Render targets are u32 0xAABBGGRR pixels stored bottom-up like GL, so the
+// projection matrices and framebuffer coordinates of the other layers stay valid.
+// Uniform buffer members get a fixed size slot each since there is no std140 layout
+// to query. It only has to be big enough for a mat4, arrays that don't fit get moved
+// to the end of the buffer the first time they're set.
+#define SOFT_UNIFORM_SLOT_SIZE 64
+#define SOFT_MAX_VARYINGS 8
+#define SOFT_MAX_ATTRIBUTE_FLOATS 32
+
+//~ Elpers
+
+static u32 get_size_of(R_AttributeType attrib) {
+	AssertTrue(10 == AttributeType_MAX, "Non Exhaustive switch statement: get_size_of in soft backend");
+	switch (attrib) {
+		case AttributeType_Float1: return 1 * sizeof(f32);
+		case AttributeType_Float2: return 2 * sizeof(f32);
+		case AttributeType_Float3: return 3 * sizeof(f32);
+		case AttributeType_Float4: return 4 * sizeof(f32);
+		case AttributeType_Integer1: return 1 * sizeof(i32);
+		case AttributeType_Integer2: return 2 * sizeof(i32);
+		case AttributeType_Integer3: return 3 * sizeof(i32);
+		case AttributeType_Integer4: return 4 * sizeof(i32);
+		case AttributeType_UByte4Norm: return 4 * sizeof(u8);
+		case AttributeType_UShort2: return 2 * sizeof(u16);
+	}
+	return 0;
+}
+
+static u32 get_component_count_of(R_AttributeType attrib) {
+	AssertTrue(10 == AttributeType_MAX, "Non Exhaustive switch statement: get_component_count_of in soft backend");
+	switch (attrib) {
+		case AttributeType_Float1: return 1;
+		case AttributeType_Float2: return 2;
+		case AttributeType_Float3: return 3;
+		case AttributeType_Float4: return 4;
+		case AttributeType_Integer1: return 1;
+		case AttributeType_Integer2: return 2;
+		case AttributeType_Integer3: return 3;
+		case AttributeType_Integer4: return 4;
+		case AttributeType_UByte4Norm: return 4;
+		case AttributeType_UShort2: return 2;
+	}
+	return 0;
+}
+
+static b8 get_is_integer(R_AttributeType attrib) {
+	return attrib >= AttributeType_Integer1 && attrib <= AttributeType_Integer4;
+}
+
+static u32 get_texture_bytes_per_pixel_of(R_TextureFormat format) {
+	AssertTrue(7 == TextureFormat_MAX,
+			   "Non Exhaustive switch statement: get_texture_bytes_per_pixel_of in soft backend");
+	switch (format) {
+		case TextureFormat_RInteger: return 4;
+		case TextureFormat_R: return 1;
+		case TextureFormat_RG: return 2;
+		case TextureFormat_RGB: return 3;
+		case TextureFormat_RGBA: return 4;
+		case TextureFormat_DepthStencil: return 4;
+	}
+	return 0;
+}
+
+//~ Lanes
+
+// NOTE(voxel): Four pixels of a row get shaded at once. Masks are all-ones or
+// all-zeroes per lane, same as what the SSE compares produce.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+
+typedef __m128 Soft_F32x4;
+
+static inline Soft_F32x4 lane_set1(f32 a) { return _mm_set1_ps(a); }
+static inline Soft_F32x4 lane_set(f32 a, f32 b, f32 c, f32 d) { return _mm_setr_ps(a, b, c, d); }
+static inline Soft_F32x4 lane_load(f32* a) { return _mm_loadu_ps(a); }
+static inline void       lane_store(f32* a, Soft_F32x4 v) { _mm_storeu_ps(a, v); }
+static inline Soft_F32x4 lane_add(Soft_F32x4 a, Soft_F32x4 b) { return _mm_add_ps(a, b); }
+static inline Soft_F32x4 lane_sub(Soft_F32x4 a, Soft_F32x4 b) { return _mm_sub_ps(a, b); }
+static inline Soft_F32x4 lane_mul(Soft_F32x4 a, Soft_F32x4 b) { return _mm_mul_ps(a, b); }
+static inline Soft_F32x4 lane_div(Soft_F32x4 a, Soft_F32x4 b) { return _mm_div_ps(a, b); }
+static inline Soft_F32x4 lane_min(Soft_F32x4 a, Soft_F32x4 b) { return _mm_min_ps(a, b); }
+static inline Soft_F32x4 lane_max(Soft_F32x4 a, Soft_F32x4 b) { return _mm_max_ps(a, b); }
+static inline Soft_F32x4 lane_sqrt(Soft_F32x4 a) { return _mm_sqrt_ps(a); }
+static inline Soft_F32x4 lane_abs(Soft_F32x4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+static inline Soft_F32x4 lane_gt(Soft_F32x4 a, Soft_F32x4 b) { return _mm_cmpgt_ps(a, b); }
+static inline Soft_F32x4 lane_le(Soft_F32x4 a, Soft_F32x4 b) { return _mm_cmple_ps(a, b); }
+static inline Soft_F32x4 lane_lt(Soft_F32x4 a, Soft_F32x4 b) { return _mm_cmplt_ps(a, b); }
+static inline Soft_F32x4 lane_eq(Soft_F32x4 a, Soft_F32x4 b) { return _mm_cmpeq_ps(a, b); }
+static inline Soft_F32x4 lane_and(Soft_F32x4 a, Soft_F32x4 b) { return _mm_and_ps(a, b); }
+static inline Soft_F32x4 lane_or(Soft_F32x4 a, Soft_F32x4 b) { return _mm_or_ps(a, b); }
+static inline u32        lane_bits(Soft_F32x4 mask) { return (u32) _mm_movemask_ps(mask); }
+
+static inline void lane_unpack_rgba8(u32* pixels, Soft_F32x4* out) {
+	__m128i p = _mm_loadu_si128((__m128i*) pixels);
+	__m128i m = _mm_set1_epi32(0xFF);
+	Soft_F32x4 scale = _mm_set1_ps(1.f / 255.f);
+	out[0] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(p, m)), scale);
+	out[1] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), m)), scale);
+	out[2] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), m)), scale);
+	out[3] = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(p, 24)), scale);
+}
+
+static inline void lane_pack_rgba8(u32* pixels, Soft_F32x4* in, Soft_F32x4 mask) {
+	Soft_F32x4 zero = _mm_setzero_ps();
+	Soft_F32x4 one = _mm_set1_ps(1.f);
+	Soft_F32x4 scale = _mm_set1_ps(255.f);
+	__m128i c[4];
+	for (u32 i = 0; i < 4; i++)
+		c[i] = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(in[i], zero), one), scale));
+	__m128i packed = _mm_or_si128(_mm_or_si128(c[0], _mm_slli_epi32(c[1], 8)),
+								  _mm_or_si128(_mm_slli_epi32(c[2], 16), _mm_slli_epi32(c[3], 24)));
+	__m128i m = _mm_castps_si128(mask);
+	__m128i old = _mm_loadu_si128((__m128i*) pixels);
+	_mm_storeu_si128((__m128i*) pixels, _mm_or_si128(_mm_and_si128(m, packed), _mm_andnot_si128(m, old)));
+}
+
+#else
+
+typedef union Soft_F32x4 { f32 f[4]; u32 u[4]; } Soft_F32x4;
+
+#define Soft_LaneOp(expr) Soft_F32x4 r; for (u32 i = 0; i < 4; i++) { expr; } return r
+#define Soft_LaneCmp(cmp) Soft_LaneOp(r.u[i] = (cmp) ? 0xFFFFFFFF : 0)
+
+static inline Soft_F32x4 lane_set1(f32 a) { Soft_LaneOp(r.f[i] = a); }
+static inline Soft_F32x4 lane_set(f32 a, f32 b, f32 c, f32 d) { return (Soft_F32x4) { .f = { a, b, c, d } }; }
+static inline Soft_F32x4 lane_load(f32* a) { Soft_LaneOp(r.f[i] = a[i]); }
+static inline void       lane_store(f32* a, Soft_F32x4 v) { for (u32 i = 0; i < 4; i++) a[i] = v.f[i]; }
+static inline Soft_F32x4 lane_add(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.f[i] = a.f[i] + b.f[i]); }
+static inline Soft_F32x4 lane_sub(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.f[i] = a.f[i] - b.f[i]); }
+static inline Soft_F32x4 lane_mul(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.f[i] = a.f[i] * b.f[i]); }
+static inline Soft_F32x4 lane_div(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.f[i] = a.f[i] / b.f[i]); }
+static inline Soft_F32x4 lane_min(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.f[i] = a.f[i] < b.f[i] ? a.f[i] : b.f[i]); }
+static inline Soft_F32x4 lane_max(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.f[i] = a.f[i] > b.f[i] ? a.f[i] : b.f[i]); }
+static inline Soft_F32x4 lane_sqrt(Soft_F32x4 a) { Soft_LaneOp(r.f[i] = sqrtf(a.f[i])); }
+static inline Soft_F32x4 lane_abs(Soft_F32x4 a) { Soft_LaneOp(r.f[i] = fabsf(a.f[i])); }
+static inline Soft_F32x4 lane_gt(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneCmp(a.f[i] > b.f[i]); }
+static inline Soft_F32x4 lane_le(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneCmp(a.f[i] <= b.f[i]); }
+static inline Soft_F32x4 lane_lt(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneCmp(a.f[i] < b.f[i]); }
+static inline Soft_F32x4 lane_eq(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneCmp(a.f[i] == b.f[i]); }
+static inline Soft_F32x4 lane_and(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.u[i] = a.u[i] & b.u[i]); }
+static inline Soft_F32x4 lane_or(Soft_F32x4 a, Soft_F32x4 b) { Soft_LaneOp(r.u[i] = a.u[i] | b.u[i]); }
+static inline u32 lane_bits(Soft_F32x4 mask) {
+	return (mask.u[0] >> 31) | ((mask.u[1] >> 31) << 1) | ((mask.u[2] >> 31) << 2) | ((mask.u[3] >> 31) << 3);
+}
+
+static inline void lane_unpack_rgba8(u32* pixels, Soft_F32x4* out) {
+	for (u32 i = 0; i < 4; i++) {
+		out[0].f[i] = ((pixels[i] >>  0) & 0xFF) / 255.f;
+		out[1].f[i] = ((pixels[i] >>  8) & 0xFF) / 255.f;
+		out[2].f[i] = ((pixels[i] >> 16) & 0xFF) / 255.f;
+		out[3].f[i] = ((pixels[i] >> 24) & 0xFF) / 255.f;
+	}
+}
+
+static inline void lane_pack_rgba8(u32* pixels, Soft_F32x4* in, Soft_F32x4 mask) {
+	for (u32 i = 0; i < 4; i++) {
+		if (!mask.u[i]) continue;
+		u32 packed = 0;
+		for (u32 c = 0; c < 4; c++)
+			packed |= (u32) (Clamp(0.f, in[c].f[i], 1.f) * 255.f + 0.5f) << (c * 8);
+		pixels[i] = packed;
+	}
+}
+
+#undef Soft_LaneCmp
+#undef Soft_LaneOp
+
+#endif
+
+static inline Soft_F32x4 lane_smoothstep(f32 edge0, f32 edge1, Soft_F32x4 x) {
+	Soft_F32x4 t = lane_div(lane_sub(x, lane_set1(edge0)), lane_set1(edge1 - edge0));
+	t = lane_min(lane_max(t, lane_set1(0.f)), lane_set1(1.f));
+	return lane_mul(lane_mul(t, t), lane_sub(lane_set1(3.f), lane_mul(lane_set1(2.f), t)));
+}
+
+//~ State
+
+typedef struct Soft_Target {
+	u32* pixels;
+	u32 width;
+	u32 height;
+} Soft_Target;
+
+typedef struct Soft_State {
+	Soft_Target screen;
+	Soft_Target target;
+
+	i32 viewport_x;
+	i32 viewport_y;
+	i32 viewport_w;
+	i32 viewport_h;
+	u32 clear_color;
+
+	R_Texture2D textures[SOFT_MAX_TEXTURE_UNITS];
+	u32 next_texture_handle;
+} Soft_State;
+
+static Soft_State s_soft;
+static R_FrameStats s_frame_stats;
+static R_FrameStats s_last_frame_stats;
+
+// NOTE(voxel): Hooks for the backend. The screen target is what gets presented.
+void __SoftScreenResize(u32 width, u32 height) {
+	if (!width) width = 1;
+	if (!height) height = 1;
+	b8 was_bound = s_soft.target.pixels == s_soft.screen.pixels;
+	if (width != s_soft.screen.width || height != s_soft.screen.height) {
+		M_Free(s_soft.screen.pixels);
+		s_soft.screen.pixels = M_AllocZero(width * height * sizeof(u32));
+		s_soft.screen.width = width;
+		s_soft.screen.height = height;
+	}
+	if (was_bound) s_soft.target = s_soft.screen;
+}
+
+void __SoftScreenGet(u32** pixels, u32* width, u32* height) {
+	*pixels = s_soft.screen.pixels;
+	*width = s_soft.screen.width;
+	*height = s_soft.screen.height;
+}
+
+void __SoftScreenFree(void) {
+	M_Free(s_soft.screen.pixels);
+	MemoryZeroStruct(&s_soft.screen, Soft_Target);
+	MemoryZeroStruct(&s_soft.target, Soft_Target);
+}
+
+R_FrameStats R_FrameStatsGet(void) {
+	return s_last_frame_stats;
+}
+
+void R_FrameStatsNext(void) {
+	s_last_frame_stats = s_frame_stats;
+	MemoryZero(&s_frame_stats, sizeof(R_FrameStats));
+}
+
+//~ Function Implementations
+
+void R_BufferAlloc(R_Buffer* buf, R_BufferFlags flags, u32 v_stride) {
+	buf->flags = flags;
+	buf->v_stride = v_stride;
+	buf->data = nullptr;
+	buf->size = 0;
+}
+
+void R_BufferData(R_Buffer* buf, u64 size, void* data) {
+	M_Free(buf->data);
+	buf->data = M_AllocZero(size);
+	buf->size = size;
+	if (data) MemoryCopy(buf->data, data, size);
+}
+
+void R_BufferUpdate(R_Buffer* buf, u64 offset, u64 size, void* data) {
+	if (offset + size > buf->size) {
+		LogError("[Soft Backend] Buffer update of %llu bytes at %llu overflows a buffer of %llu bytes", size, offset, buf->size);
+		return;
+	}
+	MemoryCopy(buf->data + offset, data, size);
+}
+
+void R_BufferFree(R_Buffer* buf) {
+	M_Free(buf->data);
+	buf->data = nullptr;
+	buf->size = 0;
+}
+
+
+
+void R_UniformBufferAlloc(R_UniformBuffer* buf, string name, string_array member_names,
+						  R_ShaderPack* pack, R_ShaderType type) {
+	buf->dirty = false;
+	buf->stage = type;
+	buf->name = name;
+	buf->size = member_names.len * SOFT_UNIFORM_SLOT_SIZE;
+	swiss_table_init(string, i32, &buf->uniform_offsets);
+	swiss_table_init(string, i32, &buf->uniform_sizes);
+
+	// @unsure Maybe use an arena allocation here, instead of a malloc
+	buf->cpu_side_buffer = M_Alloc(buf->size);
+	MemoryZero(buf->cpu_side_buffer, buf->size);
+
+	Iterate(member_names, i) {
+		swiss_table_set(string, i32, &buf->uniform_offsets, member_names.elems[i], i * SOFT_UNIFORM_SLOT_SIZE);
+	}
+}
+
+void R_UniformBufferFree(R_UniformBuffer* buf) {
+	swiss_table_free(string, i32, &buf->uniform_offsets);
+	swiss_table_free(string, i32, &buf->uniform_sizes);
+	M_Free(buf->cpu_side_buffer);
+}
+
+void R_UniformBufferSetMat4(R_UniformBuffer* buf, string name, mat4 mat) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[Soft Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, &mat, sizeof(mat4));
+	buf->dirty = true;
+}
+
+void R_UniformBufferSetInt(R_UniformBuffer* buf, string name, i32 val) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[Soft Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, &val, sizeof(i32));
+	buf->dirty = true;
+}
+
+void R_UniformBufferSetIntArray(R_UniformBuffer* buf, string name, i32* vals, u32 count) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[Soft Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, vals, sizeof(i32) * Min(count, SOFT_UNIFORM_SLOT_SIZE / sizeof(i32)));
+	buf->dirty = true;
+}
+
+void R_UniformBufferSetFloat(R_UniformBuffer* buf, string name, f32 val) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[Soft Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, &val, sizeof(f32));
+	buf->dirty = true;
+}
+
+void R_UniformBufferSetVec4(R_UniformBuffer* buf, string name, vec4 val) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[Soft Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	memmove(buf->cpu_side_buffer + offset, &val, sizeof(vec4));
+	buf->dirty = true;
+}
+
+void R_UniformBufferSetVec4Array(R_UniformBuffer* buf, string name, vec4* vals, u32 count) {
+	i32 offset = -1;
+	if (!swiss_table_get(string, i32, &buf->uniform_offsets, name, &offset)) {
+		LogError("[Soft Backend] Tried to set member '%.*s' of uniform buffer '%.*s' that doesn't exist", str_expand(name), str_expand(buf->name));
+		return;
+	}
+	
+	i32 capacity = SOFT_UNIFORM_SLOT_SIZE;
+	swiss_table_get(string, i32, &buf->uniform_sizes, name, &capacity);
+	u32 size = sizeof(vec4) * count;
+	if (size > capacity) {
+		offset = buf->size;
+		buf->size += size;
+		buf->cpu_side_buffer = M_Realloc(buf->cpu_side_buffer, buf->size);
+		swiss_table_set(string, i32, &buf->uniform_offsets, name, offset);
+		swiss_table_set(string, i32, &buf->uniform_sizes, name, size);
+	}
+	memmove(buf->cpu_side_buffer + offset, vals, size);
+	buf->dirty = true;
+}
+
+
+//~ Shaders
+
+void R_ShaderAlloc(R_Shader* shader, string data, R_ShaderType type) {
+	shader->type = type;
+	shader->kind = SoftShader_Unknown;
+
+	// The vertex inputs are the most distinctive part of each shader
+	if (type == ShaderType_Vertex) {
+		if (str_find_first(data, str_lit("a_boxcenter"), 0) != data.size)
+			shader->kind = SoftShader_UI;
+		else if (str_find_first(data, str_lit("a_texindex"), 0) != data.size)
+			shader->kind = SoftShader_Render2D;
+	}
+}
+
+void R_ShaderAllocLoad(R_Shader* shader, string fp, R_ShaderType type) {
+	M_Arena arena;
+	arena_init(&arena);
+	string source_code = OS_FileRead(&arena, fp);
+	R_ShaderAlloc(shader, source_code, type);
+	arena_free(&arena);
+}
+
+void R_ShaderFree(R_Shader* shader) {}
+
+void R_ShaderPackAlloc(R_ShaderPack* pack, R_Shader* shaders, u32 shader_count) {
+	pack->kind = SoftShader_Unknown;
+	for (u32 i = 0; i < shader_count; i++) {
+		if (shaders[i].kind != SoftShader_Unknown) {
+			pack->kind = shaders[i].kind;
+			break;
+		}
+	}
+	for (u32 i = 0; i < 8; i++) pack->sampler_units[i] = i;
+
+	if (pack->kind == SoftShader_Unknown)
+		LogError("[Soft Backend] Shader pack doesn't match any shader the soft backend knows, drawing with it does nothing");
+}
+
+void R_ShaderPackAllocLoad(R_ShaderPack* pack, string fp_prefix) {
+	M_Scratch scratch = scratch_get();
+
+	string vsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".vert.glsl"));
+	string fsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".frag.glsl"));
+
+	R_Shader* shader_buffer = arena_alloc(&scratch.arena, sizeof(R_Shader) * 2);
+	u32 shader_count = 0;
+
+	if (!OS_FileExists(vsfp))
+		LogError("[Soft Backend] The Vertex Shader File '%s.vert.glsl' doesn't exist", fp_prefix.str);
+	else Log("[Soft Backend] Loading Vertex Shader '%s.vert.glsl'", fp_prefix.str);
+	R_ShaderAllocLoad(&shader_buffer[shader_count++], vsfp, ShaderType_Vertex);
+
+	if (!OS_FileExists(fsfp))
+		LogError("[Soft Backend] The Fragment Shader File '%s.frag.glsl' doesn't exist", fp_prefix.str);
+	R_ShaderAllocLoad(&shader_buffer[shader_count++], fsfp, ShaderType_Fragment);
+
+	R_ShaderPackAlloc(pack, shader_buffer, shader_count);
+
+	for (u32 i = 0; i < shader_count; i++) {
+		R_ShaderFree(&shader_buffer[i]);
+	}
+
+	scratch_return(&scratch);
+}
+
+void R_ShaderPackFree(R_ShaderPack* pack) {}
+
+// NOTE(voxel): Like in the GL backends, loose uniforms that live in a uniform buffer
+// are silently ignored. Only the sampler array means anything here.
+void R_ShaderPackUploadMat4(R_ShaderPack* pack, string name, mat4 mat) {}
+void R_ShaderPackUploadInt(R_ShaderPack* pack, string name, i32 val) {}
+void R_ShaderPackUploadFloat(R_ShaderPack* pack, string name, f32 val) {}
+void R_ShaderPackUploadVec4(R_ShaderPack* pack, string name, vec4 val) {}
+
+void R_ShaderPackUploadIntArray(R_ShaderPack* pack, string name, i32* vals, u32 count) {
+	if (!str_eq(name, str_lit("u_tex"))) return;
+	for (u32 i = 0; i < Min(count, 8); i++) {
+		pack->sampler_units[i] = Clamp(0, vals[i], SOFT_MAX_TEXTURE_UNITS - 1);
+	}
+}
+
+
+//~ Vertex Input
+
+void R_PipelineAlloc(R_Pipeline* in, R_InputAssembly assembly, R_Attribute* attributes, u32 attribute_count, R_ShaderPack* shader, R_BlendMode blending) {
+	in->assembly = assembly;
+	in->attributes = attributes;
+	in->shader = shader;
+	in->attribute_count = attribute_count;
+	in->blend_mode = blending;
+	AssertTrue(attribute_count <= SOFT_MAX_ATTRIBUTES, "Too many attributes for the soft backend");
+}
+
+void R_PipelineAddBuffer(R_Pipeline* in, R_Buffer* buf, u32 attribute_count) {
+	if (!(buf->flags & BufferFlag_Type_Vertex)) return;
+	if (in->bindpoint == SOFT_MAX_VERTEX_BUFFERS) {
+		LogError("[Soft Backend] A pipeline can only have %d vertex buffers", SOFT_MAX_VERTEX_BUFFERS);
+		return;
+	}
+
+	u32 offset = 0;
+	for (u32 i = in->attribpoint; i < in->attribpoint + attribute_count; i++) {
+		in->attribute_buffers[i] = in->bindpoint;
+		in->attribute_offsets[i] = offset;
+		offset += get_size_of(in->attributes[i].type);
+	}
+
+	in->buffers[in->bindpoint] = buf;
+	in->buffer_strides[in->bindpoint] = offset;
+	in->attribpoint += attribute_count;
+	in->bindpoint++;
+}
+
+void R_PipelineAddUniformBuffer(R_Pipeline* in, R_UniformBuffer* buf) {
+	darray_add(R_UniformBufferHandle, &in->uniform_buffers, buf);
+}
+
+void R_PipelineBind(R_Pipeline* in) {
+	Iterate(in->uniform_buffers, i) {
+		in->uniform_buffers.elems[i]->dirty = false;
+	}
+}
+
+void R_PipelineFree(R_Pipeline* in) {
+	darray_free(R_UniformBufferHandle, &in->uniform_buffers);
+}
+
+//~ Textures
+
+static u32 Soft_TexelExpand(R_Texture2D* texture, u8* src) {
+	u8 in[6] = { 0, 255, 0, 0, 0, 255 };
+	switch (texture->format) {
+		case TextureFormat_RInteger: {
+			i32 v = 0;
+			MemoryCopy(&v, src, sizeof(i32));
+			in[TextureChannel_R] = Clamp(0, v, 255);
+		} break;
+		case TextureFormat_R: in[TextureChannel_R] = src[0]; break;
+		case TextureFormat_RG: {
+			in[TextureChannel_R] = src[0];
+			in[TextureChannel_G] = src[1];
+		} break;
+		case TextureFormat_RGB: {
+			in[TextureChannel_R] = src[0];
+			in[TextureChannel_G] = src[1];
+			in[TextureChannel_B] = src[2];
+		} break;
+		case TextureFormat_RGBA: {
+			in[TextureChannel_R] = src[0];
+			in[TextureChannel_G] = src[1];
+			in[TextureChannel_B] = src[2];
+			in[TextureChannel_A] = src[3];
+		} break;
+	}
+	return ((u32) in[texture->swizzle[0]])       | ((u32) in[texture->swizzle[1]] << 8) |
+		((u32) in[texture->swizzle[2]] << 16) | ((u32) in[texture->swizzle[3]] << 24);
+}
+
+static void Soft_TextureExpandRegion(R_Texture2D* texture, u32 x, u32 y, u32 width, u32 height) {
+	u32 bpp = get_texture_bytes_per_pixel_of(texture->format);
+	for (u32 j = y; j < y + height; j++) {
+		u8* src = texture->data + (j * texture->width + x) * bpp;
+		u32* dst = texture->texels + j * texture->width + x;
+		for (u32 i = 0; i < width; i++, src += bpp) {
+			dst[i] = Soft_TexelExpand(texture, src);
+		}
+	}
+}
+
+void R_Texture2DAlloc(R_Texture2D* texture, R_TextureFormat format, u32 width, u32 height,
+					  R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s,
+					  R_TextureWrapParam wrap_t, R_TextureMutability mut,
+					  R_TextureUsage usage, void* initial_data) {
+	texture->width = width;
+	texture->height = height;
+	texture->min = min;
+	texture->mag = mag;
+	texture->wrap_s = wrap_s;
+	texture->wrap_t = wrap_t;
+	texture->format = format;
+	texture->mut = mut;
+	texture->usage = usage;
+	texture->handle = ++s_soft.next_texture_handle;
+	texture->swizzle[0] = TextureChannel_R;
+	texture->swizzle[1] = TextureChannel_G;
+	texture->swizzle[2] = TextureChannel_B;
+	texture->swizzle[3] = TextureChannel_A;
+
+	u32 bpp = get_texture_bytes_per_pixel_of(format);
+	texture->data = M_AllocZero(width * height * bpp);
+	texture->texels = M_AllocZero(width * height * sizeof(u32));
+	if (initial_data) MemoryCopy(texture->data, initial_data, width * height * bpp);
+	Soft_TextureExpandRegion(texture, 0, 0, width, height);
+
+	AssertTrue(mag == TextureResize_Nearest || mag == TextureResize_Linear, "Magnification Filter for texture can only be Nearest or Linear");
+}
+
+void R_Texture2DAllocLoad(R_Texture2D* texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t, R_TextureMutability mut, R_TextureUsage usage) {
+	i32 width, height, channels;
+	stbi_set_flip_vertically_on_load(true);
+	u8* data = stbi_load((const char*)filepath.str, &width, &height, &channels, 0);
+
+	if (channels == 3) {
+		R_Texture2DAlloc(texture, TextureFormat_RGB, width, height, min, mag, wrap_s, wrap_t, mut, usage, data);
+	} else if (channels == 4) {
+		R_Texture2DAlloc(texture, TextureFormat_RGBA, width, height, min, mag, wrap_s, wrap_t, mut, usage, data);
+	}
+
+	stbi_image_free(data);
+}
+
+void R_Texture2DSwizzle(R_Texture2D* texture, i32* swizzles) {
+	for (u32 i = 0; i < 4; i++)
+		texture->swizzle[i] = Clamp(TextureChannel_Zero, swizzles[i], TextureChannel_A);
+	Soft_TextureExpandRegion(texture, 0, 0, texture->width, texture->height);
+}
+
+void R_Texture2DData(R_Texture2D* texture, void* data) {
+	u32 bpp = get_texture_bytes_per_pixel_of(texture->format);
+	MemoryCopy(texture->data, data, texture->width * texture->height * bpp);
+	Soft_TextureExpandRegion(texture, 0, 0, texture->width, texture->height);
+}
+
+void R_Texture2DSubData(R_Texture2D* texture, u32 x, u32 y, u32 width, u32 height, void* data) {
+	if (x + width > texture->width || y + height > texture->height) {
+		LogError("[Soft Backend] Texture sub data region goes outside of the texture");
+		return;
+	}
+	u32 bpp = get_texture_bytes_per_pixel_of(texture->format);
+	for (u32 j = 0; j < height; j++) {
+		MemoryCopy(texture->data + ((y + j) * texture->width + x) * bpp,
+				   (u8*) data + j * width * bpp, width * bpp);
+	}
+	Soft_TextureExpandRegion(texture, x, y, width, height);
+}
+
+b8 R_Texture2DEquals(R_Texture2D* a, R_Texture2D* b) {
+	return a->handle == b->handle;
+}
+
+void R_Texture2DBindTo(R_Texture2D* texture, u32 slot) {
+	if (slot >= SOFT_MAX_TEXTURE_UNITS) return;
+	s_soft.textures[slot] = *texture;
+}
+
+void R_Texture2DFree(R_Texture2D* texture) {
+	for (u32 i = 0; i < SOFT_MAX_TEXTURE_UNITS; i++) {
+		if (s_soft.textures[i].handle == texture->handle)
+			MemoryZeroStruct(&s_soft.textures[i], R_Texture2D);
+	}
+	M_Free(texture->data);
+	M_Free(texture->texels);
+	texture->data = nullptr;
+	texture->texels = nullptr;
+}
+
+//~ Framebuffers
+
+void R_FramebufferCreate(R_Framebuffer* framebuffer, u32 width, u32 height, R_Texture2D* color_attachments, u32 color_attachment_count, R_Texture2D depth_attachment) {
+	if (!width) width = 1;
+	if (!height) height = 1;
+	framebuffer->width = width;
+	framebuffer->height = height;
+	framebuffer->color_attachments = M_Alloc(sizeof(R_Texture2D) * color_attachment_count);
+	framebuffer->color_attachment_count = color_attachment_count;
+	framebuffer->depth_attachment = depth_attachment;
+	for (u32 i = 0; i < color_attachment_count; i++) {
+		framebuffer->color_attachments[i] = color_attachments[i];
+	}
+
+	if (color_attachment_count > 1)
+		LogError("[Soft Backend] Only the first color attachment of a framebuffer is drawn to");
+
+	R_FramebufferBind(framebuffer);
+}
+
+void R_FramebufferBind(R_Framebuffer* framebuffer) {
+	if (!framebuffer->color_attachment_count) return;
+	R_Texture2D* attachment = &framebuffer->color_attachments[0];
+	s_soft.target = (Soft_Target) { attachment->texels, attachment->width, attachment->height };
+}
+
+void R_FramebufferBindScreen(void) {
+	s_soft.target = s_soft.screen;
+}
+
+void R_FramebufferBlitToScreen(OS_Window* window, R_Framebuffer* framebuffer) {
+	if (!framebuffer->color_attachment_count || !s_soft.screen.pixels) return;
+	if (!window->width || !window->height) return;
+	R_Texture2D* src = &framebuffer->color_attachments[0];
+	u32 width = Min(window->width, s_soft.screen.width);
+	u32 height = Min(window->height, s_soft.screen.height);
+	for (u32 j = 0; j < height; j++) {
+		u32* src_row = src->texels + (j * src->height / window->height) * src->width;
+		u32* dst_row = s_soft.screen.pixels + j * s_soft.screen.width;
+		for (u32 i = 0; i < width; i++) {
+			dst_row[i] = src_row[i * src->width / window->width];
+		}
+	}
+}
+
+void R_FramebufferReadPixel(R_Framebuffer* framebuffer, u32 attachment, u32 x, u32 y,
+							void* data) {
+	R_Texture2D* texture = &framebuffer->color_attachments[attachment];
+	if (x >= texture->width || y >= texture->height) return;
+	if (texture->format == TextureFormat_RInteger) {
+		u32 bpp = get_texture_bytes_per_pixel_of(texture->format);
+		MemoryCopy(data, texture->data + (y * texture->width + x) * bpp, bpp);
+	} else {
+		MemoryCopy(data, &texture->texels[y * texture->width + x], sizeof(u32));
+	}
+}
+
+void R_FramebufferResize(R_Framebuffer* framebuffer, u32 new_width, u32 new_height) {
+	if (!new_width) new_width = 1;
+	if (!new_height) new_height = 1;
+	b8 was_bound = framebuffer->color_attachment_count &&
+		s_soft.target.pixels == framebuffer->color_attachments[0].texels;
+	framebuffer->width = new_width;
+	framebuffer->height = new_height;
+
+	for (u32 i = 0; i < framebuffer->color_attachment_count; i++) {
+		R_Texture2D old_spec = framebuffer->color_attachments[i];
+		R_Texture2DFree(&framebuffer->color_attachments[i]);
+		R_Texture2DAlloc(&framebuffer->color_attachments[i], old_spec.format, new_width, new_height, old_spec.min, old_spec.mag, old_spec.wrap_s, old_spec.wrap_t, old_spec.mut, old_spec.usage, nullptr);
+	}
+
+	if (framebuffer->depth_attachment.format != TextureFormat_Invalid) {
+		R_Texture2D old_spec = framebuffer->depth_attachment;
+		R_Texture2DFree(&framebuffer->depth_attachment);
+		R_Texture2DAlloc(&framebuffer->depth_attachment, old_spec.format, new_width, new_height, old_spec.min, old_spec.mag, old_spec.wrap_s, old_spec.wrap_t, old_spec.mut, old_spec.usage, nullptr);
+	}
+
+	if (was_bound) R_FramebufferBind(framebuffer);
+}
+
+void R_FramebufferFree(R_Framebuffer* framebuffer) {
+	if (framebuffer->color_attachment_count &&
+		s_soft.target.pixels == framebuffer->color_attachments[0].texels)
+		s_soft.target = s_soft.screen;
+	for (u32 i = 0; i < framebuffer->color_attachment_count; i++) {
+		R_Texture2DFree(&framebuffer->color_attachments[i]);
+	}
+	M_Free(framebuffer->color_attachments);
+	if (framebuffer->depth_attachment.format != TextureFormat_Invalid)
+		R_Texture2DFree(&framebuffer->depth_attachment);
+}
+
+//~ Rasterizer
+
+typedef struct Soft_Vertex {
+	f32 x;
+	f32 y;
+	f32 varyings[SOFT_MAX_VARYINGS];
+} Soft_Vertex;
+
+// Inputs that are the same for all the vertices of a quad, so they're just taken
+// from the first vertex of the primitive instead of being interpolated
+typedef struct Soft_Flat {
+	i32  tex_index;
+	vec2 box_half_size;
+	vec2 box_center;
+	vec4 clip_quad;
+	vec3 rounding_softness_and_edge_size;
+} Soft_Flat;
+
+typedef struct Soft_Primitive {
+	f32 plane_c[SOFT_MAX_VARYINGS];
+	f32 plane_dx[SOFT_MAX_VARYINGS];
+	f32 plane_dy[SOFT_MAX_VARYINGS];
+	Soft_Flat flat;
+
+	// Set when every texel the primitive can touch is the same, which is what solid
+	// color quads look like (they sample the white texture or a tiny atlas region)
+	b8  texel_is_constant;
+	f32 texel[4];
+} Soft_Primitive;
+
+typedef struct Soft_DrawContext {
+	R_Pipeline* pipeline;
+	R_SoftShaderKind kind;
+	u32 varying_count;
+	mat4 projection;
+	vec4* clip_rects;
+	u32 clip_rect_count;
+	R_Texture2D* samplers[8];
+	b8 blend;
+
+	u32* pixels;
+	u32 stride;
+	i32 clip_x0;
+	i32 clip_y0;
+	i32 clip_x1;
+	i32 clip_y1;
+} Soft_DrawContext;
+
+static b8 Soft_DrawContextInit(Soft_DrawContext* ctx, R_Pipeline* in) {
+	MemoryZeroStruct(ctx, Soft_DrawContext);
+	ctx->pipeline = in;
+	ctx->kind = in->shader->kind;
+	ctx->varying_count = ctx->kind == SoftShader_UI ? 8 : 6;
+	ctx->blend = in->blend_mode == BlendMode_Alpha;
+	ctx->pixels = s_soft.target.pixels;
+	ctx->stride = s_soft.target.width;
+	ctx->clip_x0 = Max(s_soft.viewport_x, 0);
+	ctx->clip_y0 = Max(s_soft.viewport_y, 0);
+	ctx->clip_x1 = Min(s_soft.viewport_x + s_soft.viewport_w, (i32) s_soft.target.width);
+	ctx->clip_y1 = Min(s_soft.viewport_y + s_soft.viewport_h, (i32) s_soft.target.height);
+	if (!ctx->pixels || ctx->clip_x0 >= ctx->clip_x1 || ctx->clip_y0 >= ctx->clip_y1) return false;
+
+	b8 found_projection = false;
+	Iterate(in->uniform_buffers, i) {
+		R_UniformBuffer* buf = in->uniform_buffers.elems[i];
+		i32 offset = -1;
+		if (swiss_table_get(string, i32, &buf->uniform_offsets, str_lit("u_projection"), &offset)) {
+			MemoryCopy(&ctx->projection, buf->cpu_side_buffer + offset, sizeof(mat4));
+			found_projection = true;
+		}
+		if (swiss_table_get(string, i32, &buf->uniform_offsets, str_lit("u_clip_rects"), &offset)) {
+			i32 size = SOFT_UNIFORM_SLOT_SIZE;
+			swiss_table_get(string, i32, &buf->uniform_sizes, str_lit("u_clip_rects"), &size);
+			ctx->clip_rects = (vec4*) (buf->cpu_side_buffer + offset);
+			ctx->clip_rect_count = size / sizeof(vec4);
+		}
+	}
+	if (!found_projection) return false;
+
+	for (u32 i = 0; i < 8; i++) {
+		ctx->samplers[i] = &s_soft.textures[in->shader->sampler_units[i]];
+	}
+	return true;
+}
+
+static void Soft_FetchAttributes(R_Pipeline* in, u32 vertex, u32 instance, f32* out) {
+	u32 k = 0;
+	for (u32 a = 0; a < in->attribute_count; a++) {
+		R_AttributeType type = in->attributes[a].type;
+		u32 components = get_component_count_of(type);
+		R_Buffer* buf = in->buffers[in->attribute_buffers[a]];
+		u32 element = buf && (buf->flags & BufferFlag_PerInstance) ? instance : vertex;
+		u64 at = (u64) element * in->buffer_strides[in->attribute_buffers[a]] + in->attribute_offsets[a];
+		if (!buf || !buf->data || at + get_size_of(type) > buf->size || k + components > SOFT_MAX_ATTRIBUTE_FLOATS) {
+			for (u32 c = 0; c < components && k < SOFT_MAX_ATTRIBUTE_FLOATS; c++) out[k++] = 0.f;
+			continue;
+		}
+
+		u8* src = buf->data + at;
+		if (type == AttributeType_UByte4Norm) {
+			for (u32 c = 0; c < components; c++) out[k++] = src[c] / 255.f;
+		} else if (type == AttributeType_UShort2) {
+			u16 v[2];
+			MemoryCopy(v, src, sizeof(v));
+			out[k++] = (f32) v[0];
+			out[k++] = (f32) v[1];
+		} else {
+			for (u32 c = 0; c < components; c++, src += 4) {
+				if (get_is_integer(type)) {
+					i32 v;
+					MemoryCopy(&v, src, sizeof(i32));
+					out[k++] = (f32) v;
+				} else {
+					MemoryCopy(&out[k++], src, sizeof(f32));
+				}
+			}
+		}
+	}
+}
+
+static const vec2 soft_ui_vertex_multipliers[6] = {
+	{ -.5f, -.5f }, { +.5f, -.5f }, { +.5f, +.5f },
+	{ -.5f, -.5f }, { +.5f, +.5f }, { -.5f, +.5f },
+};
+static const u32 soft_ui_corner_indices[6] = { 0, 1, 2, 0, 2, 3 };
+
+// C versions of res/shaders/render_2d.vert.glsl and res/shaders/ui.vert.glsl,
+// followed by the perspective divide and viewport transform
+static b8 Soft_VertexStage(Soft_DrawContext* ctx, u32 vertex, u32 instance, Soft_Vertex* out, Soft_Flat* flat) {
+	f32 a[SOFT_MAX_ATTRIBUTE_FLOATS] = {0};
+	Soft_FetchAttributes(ctx->pipeline, vertex, instance, a);
+
+	vec2 pos = {0};
+	switch (ctx->kind) {
+		case SoftShader_Render2D: {
+			pos = (vec2) { a[0], a[1] };
+			out->varyings[0] = a[2];
+			out->varyings[1] = a[3];
+			MemoryCopy(&out->varyings[2], &a[5], sizeof(f32) * 4);
+			flat->tex_index = (i32) a[4];
+		} break;
+
+		case SoftShader_UI: {
+			// size, center, uv rect, 4 corner colors, rounding/softness/edge, tex and clip index
+			vec2 mult = soft_ui_vertex_multipliers[vertex % 6];
+			pos = (vec2) { a[2] + a[0] * mult.x, a[3] + a[1] * mult.y };
+			out->varyings[0] = a[4] + a[6] * (mult.x + .5f);
+			out->varyings[1] = a[5] + a[7] * (mult.y + .5f);
+			MemoryCopy(&out->varyings[2], &a[8 + 4 * soft_ui_corner_indices[vertex % 6]], sizeof(f32) * 4);
+			out->varyings[6] = pos.x;
+			out->varyings[7] = pos.y;
+			flat->tex_index = (i32) a[27];
+			flat->box_half_size = (vec2) { a[0] / 2.f, a[1] / 2.f };
+			flat->box_center = (vec2) { a[2], a[3] };
+			u32 clip_index = (u32) a[28];
+			flat->clip_quad = clip_index < ctx->clip_rect_count ? ctx->clip_rects[clip_index] : (vec4) {0};
+			flat->rounding_softness_and_edge_size = (vec3) { a[24], a[25], a[26] };
+		} break;
+	}
+
+	f32* m = ctx->projection.a;
+	f32 cx = m[0] * pos.x + m[4] * pos.y + m[12];
+	f32 cy = m[1] * pos.x + m[5] * pos.y + m[13];
+	f32 cw = m[3] * pos.x + m[7] * pos.y + m[15];
+	if (!(cw > 0.f)) return false;
+
+	out->x = s_soft.viewport_x + (cx / cw + 1.f) * 0.5f * s_soft.viewport_w;
+	out->y = s_soft.viewport_y + (cy / cw + 1.f) * 0.5f * s_soft.viewport_h;
+	return true;
+}
+
+static b8 Soft_PrimitiveSetup(Soft_DrawContext* ctx, Soft_Primitive* prim, Soft_Vertex* v0, Soft_Vertex* v1, Soft_Vertex* v2) {
+	f32 e1x = v1->x - v0->x, e1y = v1->y - v0->y;
+	f32 e2x = v2->x - v0->x, e2y = v2->y - v0->y;
+	f32 area = e1x * e2y - e2x * e1y;
+	if (!(fabsf(area) > 1e-8f)) return false;
+
+	f32 inv_area = 1.f / area;
+	f32 l1dx =  e2y * inv_area, l1dy = -e2x * inv_area;
+	f32 l2dx = -e1y * inv_area, l2dy =  e1x * inv_area;
+	for (u32 k = 0; k < ctx->varying_count; k++) {
+		f32 d1 = v1->varyings[k] - v0->varyings[k];
+		f32 d2 = v2->varyings[k] - v0->varyings[k];
+		prim->plane_dx[k] = d1 * l1dx + d2 * l2dx;
+		prim->plane_dy[k] = d1 * l1dy + d2 * l2dy;
+		prim->plane_c[k]  = v0->varyings[k] - prim->plane_dx[k] * v0->x - prim->plane_dy[k] * v0->y;
+	}
+	return true;
+}
+
+static i32 Soft_TexelWrap(i32 c, i32 size, R_TextureWrapParam wrap) {
+	switch (wrap) {
+		case TextureWrap_Repeat: {
+			c %= size;
+			return c < 0 ? c + size : c;
+		}
+		case TextureWrap_MirroredRepeat: {
+			i32 period = size * 2;
+			c %= period;
+			if (c < 0) c += period;
+			return c < size ? c : period - 1 - c;
+		}
+	}
+	return Clamp(0, c, size - 1);
+}
+
+static void Soft_SampleLanes(R_Texture2D* texture, Soft_F32x4 u, Soft_F32x4 v, u32 lanes, Soft_F32x4* out) {
+	f32 us[4], vs[4];
+	f32 rgba[4][4] = {0};
+	lane_store(us, u);
+	lane_store(vs, v);
+
+	if (!texture->texels) {
+		for (u32 l = 0; l < 4; l++) rgba[3][l] = 1.f;
+		for (u32 c = 0; c < 4; c++) out[c] = lane_load(rgba[c]);
+		return;
+	}
+
+	i32 w = texture->width, h = texture->height;
+	for (u32 l = 0; l < 4; l++) {
+		if (!(lanes & (1 << l))) continue;
+
+		if (texture->mag == TextureResize_Nearest) {
+			i32 x = Soft_TexelWrap((i32) floorf(us[l] * w), w, texture->wrap_s);
+			i32 y = Soft_TexelWrap((i32) floorf(vs[l] * h), h, texture->wrap_t);
+			u32 t = texture->texels[y * w + x];
+			for (u32 c = 0; c < 4; c++) rgba[c][l] = ((t >> (c * 8)) & 0xFF) * (1.f / 255.f);
+			continue;
+		}
+
+		f32 fx = us[l] * w - 0.5f, fy = vs[l] * h - 0.5f;
+		f32 bx = floorf(fx), by = floorf(fy);
+		f32 tx = fx - bx, ty = fy - by;
+		i32 x0 = Soft_TexelWrap((i32) bx, w, texture->wrap_s), x1 = Soft_TexelWrap((i32) bx + 1, w, texture->wrap_s);
+		i32 y0 = Soft_TexelWrap((i32) by, h, texture->wrap_t), y1 = Soft_TexelWrap((i32) by + 1, h, texture->wrap_t);
+		u32 t00 = texture->texels[y0 * w + x0], t10 = texture->texels[y0 * w + x1];
+		u32 t01 = texture->texels[y1 * w + x0], t11 = texture->texels[y1 * w + x1];
+		for (u32 c = 0; c < 4; c++) {
+			u32 s = c * 8;
+			f32 top    = ((t00 >> s) & 0xFF) + (((f32) ((t10 >> s) & 0xFF)) - ((t00 >> s) & 0xFF)) * tx;
+			f32 bottom = ((t01 >> s) & 0xFF) + (((f32) ((t11 >> s) & 0xFF)) - ((t01 >> s) & 0xFF)) * tx;
+			rgba[c][l] = (top + (bottom - top) * ty) * (1.f / 255.f);
+		}
+	}
+	for (u32 c = 0; c < 4; c++) out[c] = lane_load(rgba[c]);
+}
+
+#define SOFT_CONSTANT_TEXEL_MAX_SPAN 4
+
+static void Soft_PrimitiveFindConstantTexel(Soft_DrawContext* ctx, Soft_Primitive* prim, Soft_Vertex* v, u32 vertex_count) {
+	prim->texel_is_constant = false;
+	if (prim->flat.tex_index < 0 || prim->flat.tex_index > 7) return;
+	R_Texture2D* texture = ctx->samplers[prim->flat.tex_index];
+	if (!texture->texels) return;
+
+	f32 min_u = v[0].varyings[0], max_u = min_u;
+	f32 min_v = v[0].varyings[1], max_v = min_v;
+	for (u32 i = 1; i < vertex_count; i++) {
+		min_u = Min(min_u, v[i].varyings[0]); max_u = Max(max_u, v[i].varyings[0]);
+		min_v = Min(min_v, v[i].varyings[1]); max_v = Max(max_v, v[i].varyings[1]);
+	}
+
+	// Every texel nearest or bilinear filtering could read inside those uvs
+	i32 w = texture->width, h = texture->height;
+	i32 x0 = (i32) floorf(min_u * w - 0.5f), x1 = (i32) floorf(max_u * w - 0.5f) + 1;
+	i32 y0 = (i32) floorf(min_v * h - 0.5f), y1 = (i32) floorf(max_v * h - 0.5f) + 1;
+	if (x1 - x0 >= SOFT_CONSTANT_TEXEL_MAX_SPAN || y1 - y0 >= SOFT_CONSTANT_TEXEL_MAX_SPAN) return;
+
+	u32 first = texture->texels[Soft_TexelWrap(y0, h, texture->wrap_t) * w + Soft_TexelWrap(x0, w, texture->wrap_s)];
+	for (i32 y = y0; y <= y1; y++) {
+		for (i32 x = x0; x <= x1; x++) {
+			u32 t = texture->texels[Soft_TexelWrap(y, h, texture->wrap_t) * w + Soft_TexelWrap(x, w, texture->wrap_s)];
+			if (t != first) return;
+		}
+	}
+
+	prim->texel_is_constant = true;
+	for (u32 c = 0; c < 4; c++) prim->texel[c] = ((first >> (c * 8)) & 0xFF) * (1.f / 255.f);
+}
+
+static inline Soft_F32x4 Soft_RoundedRectSDF(Soft_F32x4 px, Soft_F32x4 py, vec2 center, vec2 half_size, f32 r) {
+	Soft_F32x4 dx = lane_add(lane_sub(lane_abs(lane_sub(lane_set1(center.x), px)), lane_set1(half_size.x)), lane_set1(r));
+	Soft_F32x4 dy = lane_add(lane_sub(lane_abs(lane_sub(lane_set1(center.y), py)), lane_set1(half_size.y)), lane_set1(r));
+	Soft_F32x4 zero = lane_set1(0.f);
+	Soft_F32x4 ox = lane_max(dx, zero), oy = lane_max(dy, zero);
+	Soft_F32x4 inside = lane_min(lane_max(dx, dy), zero);
+	return lane_sub(lane_add(inside, lane_sqrt(lane_add(lane_mul(ox, ox), lane_mul(oy, oy)))), lane_set1(r));
+}
+
+// C versions of res/shaders/render_2d.frag.glsl and res/shaders/ui.frag.glsl for
+// four horizontally adjacent pixels, followed by blending and the masked store
+static void Soft_ShadePixels(Soft_DrawContext* ctx, Soft_Primitive* prim, i32 x, i32 y, Soft_F32x4 mask) {
+	Soft_Flat* flat = &prim->flat;
+	if (flat->tex_index < 0 || flat->tex_index > 7) return;
+
+	Soft_F32x4 px = lane_add(lane_set1((f32) x), lane_set(0.5f, 1.5f, 2.5f, 3.5f));
+	Soft_F32x4 py = lane_set1((f32) y + 0.5f);
+	Soft_F32x4 varyings[SOFT_MAX_VARYINGS];
+	for (u32 k = 0; k < ctx->varying_count; k++) {
+		varyings[k] = lane_add(lane_set1(prim->plane_c[k]),
+							   lane_add(lane_mul(lane_set1(prim->plane_dx[k]), px),
+										lane_mul(lane_set1(prim->plane_dy[k]), py)));
+	}
+
+	if (ctx->kind == SoftShader_UI) {
+		vec4 clip = flat->clip_quad;
+		Soft_F32x4 lx = varyings[6], ly = varyings[7];
+		mask = lane_and(mask, lane_and(lane_le(lane_set1(clip.x), lx), lane_le(lane_set1(clip.y), ly)));
+		mask = lane_and(mask, lane_and(lane_le(lx, lane_set1(clip.x + clip.z)), lane_le(ly, lane_set1(clip.y + clip.w))));
+	}
+	u32 lanes = lane_bits(mask);
+	if (!lanes) return;
+
+	Soft_F32x4 color[4];
+	if (prim->texel_is_constant) {
+		for (u32 c = 0; c < 4; c++) color[c] = lane_mul(lane_set1(prim->texel[c]), varyings[2 + c]);
+	} else {
+		Soft_SampleLanes(ctx->samplers[flat->tex_index], varyings[0], varyings[1], lanes, color);
+		for (u32 c = 0; c < 4; c++) color[c] = lane_mul(color[c], varyings[2 + c]);
+	}
+
+	if (ctx->kind == SoftShader_UI) {
+		vec2 half_size = flat->box_half_size;
+		f32 rounding = flat->rounding_softness_and_edge_size.x;
+		f32 softness = flat->rounding_softness_and_edge_size.y;
+		f32 edge_size = flat->rounding_softness_and_edge_size.z;
+		f32 padding = Max(0.f, softness * 2.f - 1.f);
+		Soft_F32x4 lx = varyings[6], ly = varyings[7];
+
+		Soft_F32x4 dist = Soft_RoundedRectSDF(lx, ly, flat->box_center,
+											  (vec2) { half_size.x - padding, half_size.y - padding }, rounding);
+		Soft_F32x4 factor = lane_sub(lane_set1(1.f), lane_smoothstep(0.f, 2.f * softness, dist));
+
+		if (edge_size != 0.f) {
+			vec2 interior_half_size = { half_size.x - edge_size, half_size.y - edge_size };
+			f32 reduce = Min(interior_half_size.x / half_size.x, interior_half_size.y / half_size.y);
+			f32 interior_radius = rounding * reduce * reduce;
+			Soft_F32x4 inside_d = Soft_RoundedRectSDF(lx, ly, flat->box_center,
+													  (vec2) { interior_half_size.x - padding, interior_half_size.y - padding },
+													  interior_radius);
+			factor = lane_mul(factor, lane_smoothstep(0.f, 2.f * softness, inside_d));
+		}
+		for (u32 c = 0; c < 4; c++) color[c] = lane_mul(color[c], factor);
+	}
+
+	// Row ends that aren't a multiple of four go through a small copy so the
+	// four wide loads and stores never leave the target
+	u32* dst = ctx->pixels + y * ctx->stride + x;
+	u32 tail[4] = {0};
+	u32 valid = Min(4, ctx->stride - x);
+	if (valid < 4) {
+		MemoryCopy(tail, dst, valid * sizeof(u32));
+		dst = tail;
+	}
+
+	if (ctx->blend) {
+		Soft_F32x4 old[4];
+		lane_unpack_rgba8(dst, old);
+		Soft_F32x4 inv_alpha = lane_sub(lane_set1(1.f), color[3]);
+		Soft_F32x4 alpha = color[3];
+		for (u32 c = 0; c < 4; c++)
+			color[c] = lane_add(lane_mul(color[c], alpha), lane_mul(old[c], inv_alpha));
+	}
+	lane_pack_rgba8(dst, color, mask);
+
+	if (valid < 4) MemoryCopy(ctx->pixels + y * ctx->stride + x, tail, valid * sizeof(u32));
+}
+
+static Soft_F32x4 Soft_ColumnMask(Soft_DrawContext* ctx, i32 x, i32 x_end) {
+	Soft_F32x4 column = lane_add(lane_set1((f32) x), lane_set(0.f, 1.f, 2.f, 3.f));
+	return lane_lt(column, lane_set1((f32) Min(x_end, ctx->clip_x1)));
+}
+
+// Rects that are axis aligned in window space get filled span by span with no edge tests.
+// Covers pixels whose centers are in [min, max) on both axes, like the triangle path does.
+static void Soft_RasterRect(Soft_DrawContext* ctx, Soft_Primitive* prim, f32 min_x, f32 min_y, f32 max_x, f32 max_y) {
+	i32 x0 = Max((i32) ceilf(min_x - 0.5f), ctx->clip_x0);
+	i32 y0 = Max((i32) ceilf(min_y - 0.5f), ctx->clip_y0);
+	i32 x1 = Min((i32) ceilf(max_x - 0.5f), ctx->clip_x1);
+	i32 y1 = Min((i32) ceilf(max_y - 0.5f), ctx->clip_y1);
+
+	for (i32 y = y0; y < y1; y++) {
+		for (i32 x = x0; x < x1; x += 4) {
+			Soft_ShadePixels(ctx, prim, x, y, Soft_ColumnMask(ctx, x, x1));
+		}
+	}
+}
+
+typedef struct Soft_Edge {
+	f32 ax, ay;
+	f32 a, b;
+	Soft_F32x4 sign;
+	b8 inclusive;
+} Soft_Edge;
+
+// NOTE(voxel): Edges are always evaluated from their lexicographically smaller endpoint,
+// so two triangles sharing an edge compute bit-identical values for it and the top-left
+// rule decides which one owns the pixels exactly on it. No double blended diagonals.
+static Soft_Edge Soft_EdgeSetup(Soft_Vertex* from, Soft_Vertex* to, b8 ccw) {
+	Soft_Vertex* a = from;
+	Soft_Vertex* b = to;
+	b8 swapped = false;
+	if (b->x < a->x || (b->x == a->x && b->y < a->y)) {
+		a = to; b = from;
+		swapped = true;
+	}
+
+	Soft_Edge edge = {0};
+	edge.ax = a->x;
+	edge.ay = a->y;
+	edge.a = -(b->y - a->y);
+	edge.b = b->x - a->x;
+	edge.sign = lane_set1(swapped == ccw ? -1.f : 1.f);
+
+	// Direction of the edge when walking the triangle counter clockwise
+	f32 dx = ccw ? to->x - from->x : from->x - to->x;
+	f32 dy = ccw ? to->y - from->y : from->y - to->y;
+	edge.inclusive = dy < 0.f || (dy == 0.f && dx < 0.f);
+	return edge;
+}
+
+static void Soft_RasterTriangle(Soft_DrawContext* ctx, Soft_Primitive* prim, Soft_Vertex* v0, Soft_Vertex* v1, Soft_Vertex* v2) {
+	f32 area = (v1->x - v0->x) * (v2->y - v0->y) - (v2->x - v0->x) * (v1->y - v0->y);
+	b8 ccw = area > 0.f;
+	Soft_Edge edges[3] = {
+		Soft_EdgeSetup(v1, v2, ccw),
+		Soft_EdgeSetup(v2, v0, ccw),
+		Soft_EdgeSetup(v0, v1, ccw),
+	};
+
+	f32 min_x = Min(v0->x, Min(v1->x, v2->x)), max_x = Max(v0->x, Max(v1->x, v2->x));
+	f32 min_y = Min(v0->y, Min(v1->y, v2->y)), max_y = Max(v0->y, Max(v1->y, v2->y));
+	i32 x0 = Max((i32) floorf(min_x), ctx->clip_x0);
+	i32 y0 = Max((i32) floorf(min_y), ctx->clip_y0);
+	i32 x1 = Min((i32) ceilf(max_x), ctx->clip_x1);
+	i32 y1 = Min((i32) ceilf(max_y), ctx->clip_y1);
+
+	Soft_F32x4 zero = lane_set1(0.f);
+	for (i32 y = y0; y < y1; y++) {
+		Soft_F32x4 py = lane_set1((f32) y + 0.5f);
+		for (i32 x = x0; x < x1; x += 4) {
+			Soft_F32x4 px = lane_add(lane_set1((f32) x), lane_set(0.5f, 1.5f, 2.5f, 3.5f));
+			Soft_F32x4 mask = Soft_ColumnMask(ctx, x, x1);
+			for (u32 e = 0; e < 3; e++) {
+				Soft_Edge* edge = &edges[e];
+				Soft_F32x4 w = lane_add(lane_mul(lane_set1(edge->b), lane_sub(py, lane_set1(edge->ay))),
+										lane_mul(lane_set1(edge->a), lane_sub(px, lane_set1(edge->ax))));
+				w = lane_mul(w, edge->sign);
+				Soft_F32x4 inside = lane_gt(w, zero);
+				if (edge->inclusive) inside = lane_or(inside, lane_eq(w, zero));
+				mask = lane_and(mask, inside);
+			}
+			if (lane_bits(mask)) Soft_ShadePixels(ctx, prim, x, y, mask);
+		}
+	}
+}
+
+static b8 Soft_VaryingsMatchPlane(Soft_DrawContext* ctx, Soft_Primitive* prim, Soft_Vertex* v) {
+	for (u32 k = 0; k < ctx->varying_count; k++) {
+		f32 predicted = prim->plane_c[k] + prim->plane_dx[k] * v->x + prim->plane_dy[k] * v->y;
+		if (fabsf(predicted - v->varyings[k]) > 1e-4f * (1.f + fabsf(v->varyings[k])))
+			return false;
+	}
+	return true;
+}
+
+static void Soft_RasterQuad(Soft_DrawContext* ctx, Soft_Vertex* v, Soft_Flat* flat) {
+	Soft_Primitive prim = { .flat = *flat };
+	b8 first_ok = Soft_PrimitiveSetup(ctx, &prim, &v[0], &v[1], &v[2]);
+	Soft_PrimitiveFindConstantTexel(ctx, &prim, v, 6);
+
+	// Both triangles of the quads render_2d and ui emit, in window space
+	b8 is_rect = first_ok &&
+		v[3].x == v[0].x && v[3].y == v[0].y && v[4].x == v[2].x && v[4].y == v[2].y &&
+		v[1].y == v[0].y && v[2].x == v[1].x && v[5].x == v[0].x && v[5].y == v[2].y;
+	if (is_rect && Soft_VaryingsMatchPlane(ctx, &prim, &v[5])) {
+		Soft_RasterRect(ctx, &prim, Min(v[0].x, v[2].x), Min(v[0].y, v[2].y), Max(v[0].x, v[2].x), Max(v[0].y, v[2].y));
+		return;
+	}
+
+	if (first_ok) Soft_RasterTriangle(ctx, &prim, &v[0], &v[1], &v[2]);
+	if (Soft_PrimitiveSetup(ctx, &prim, &v[3], &v[4], &v[5]))
+		Soft_RasterTriangle(ctx, &prim, &v[3], &v[4], &v[5]);
+}
+
+static void Soft_RasterLine(Soft_DrawContext* ctx, Soft_Vertex* v0, Soft_Vertex* v1, Soft_Flat* flat) {
+	Soft_Primitive prim = { .flat = *flat };
+	Soft_Vertex ends[2] = { *v0, *v1 };
+	Soft_PrimitiveFindConstantTexel(ctx, &prim, ends, 2);
+
+	f32 dx = v1->x - v0->x, dy = v1->y - v0->y;
+	u32 steps = (u32) Max(fabsf(dx), fabsf(dy));
+	Soft_F32x4 first_lane = lane_lt(lane_set(0.f, 1.f, 2.f, 3.f), lane_set1(1.f));
+	for (u32 i = 0; i < steps; i++) {
+		f32 t = (i + 0.5f) / steps;
+		i32 x = (i32) floorf(v0->x + dx * t), y = (i32) floorf(v0->y + dy * t);
+		if (x < ctx->clip_x0 || x >= ctx->clip_x1 || y < ctx->clip_y0 || y >= ctx->clip_y1) continue;
+
+		// The planes are flat, so lane 0 just gets the inputs interpolated along the line
+		for (u32 k = 0; k < ctx->varying_count; k++) prim.plane_c[k] = v0->varyings[k] + (v1->varyings[k] - v0->varyings[k]) * t;
+		Soft_ShadePixels(ctx, &prim, x, y, first_lane);
+	}
+}
+
+//~ Other
+
+void R_Clear(R_BufferMask buffer_mask) {
+	if (!(buffer_mask & BufferMask_Color) || !s_soft.target.pixels) return;
+	u32 count = s_soft.target.width * s_soft.target.height;
+	for (u32 i = 0; i < count; i++) s_soft.target.pixels[i] = s_soft.clear_color;
+}
+
+void R_ClearColor(f32 r, f32 g, f32 b, f32 a) {
+	u32 c[4] = {
+		(u32) (Clamp(0.f, r, 1.f) * 255.f + 0.5f), (u32) (Clamp(0.f, g, 1.f) * 255.f + 0.5f),
+		(u32) (Clamp(0.f, b, 1.f) * 255.f + 0.5f), (u32) (Clamp(0.f, a, 1.f) * 255.f + 0.5f),
+	};
+	s_soft.clear_color = c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24);
+}
+
+void R_Viewport(i32 x, i32 y, i32 w, i32 h) {
+	s_soft.viewport_x = x;
+	s_soft.viewport_y = y;
+	s_soft.viewport_w = w;
+	s_soft.viewport_h = h;
+	// The default framebuffer follows the window, which is what the viewport tracks
+	if (s_soft.target.pixels == s_soft.screen.pixels)
+		__SoftScreenResize(x + w, y + h);
+}
+
+static void Soft_DrawInstance(Soft_DrawContext* ctx, R_Pipeline* in, u32 start, u32 count, u32 instance) {
+	Soft_Vertex v[6];
+	Soft_Flat flat = {0};
+
+	if (in->assembly == InputAssembly_Lines) {
+		for (u32 i = 0; i + 2 <= count; i += 2) {
+			Soft_Flat unused;
+			if (!Soft_VertexStage(ctx, start + i, instance, &v[0], &flat)) continue;
+			if (!Soft_VertexStage(ctx, start + i + 1, instance, &v[1], &unused)) continue;
+			Soft_RasterLine(ctx, &v[0], &v[1], &flat);
+		}
+		return;
+	}
+
+	u32 i = 0;
+	while (i + 6 <= count) {
+		b8 ok = true;
+		Soft_Flat second;
+		for (u32 k = 0; k < 6; k++)
+			ok = Soft_VertexStage(ctx, start + i + k, instance, &v[k], k < 3 ? &flat : &second) && ok;
+
+		if (ok) {
+			Soft_RasterQuad(ctx, v, &flat);
+		} else {
+			LogError("[Soft Backend] Primitives crossing the w = 0 plane aren't clipped, dropping them");
+		}
+		i += 6;
+	}
+	for (; i + 3 <= count; i += 3) {
+		Soft_Primitive prim = {0};
+		if (!Soft_VertexStage(ctx, start + i, instance, &v[0], &prim.flat)) continue;
+		if (!Soft_VertexStage(ctx, start + i + 1, instance, &v[1], &flat)) continue;
+		if (!Soft_VertexStage(ctx, start + i + 2, instance, &v[2], &flat)) continue;
+		if (!Soft_PrimitiveSetup(ctx, &prim, &v[0], &v[1], &v[2])) continue;
+		Soft_PrimitiveFindConstantTexel(ctx, &prim, v, 3);
+		Soft_RasterTriangle(ctx, &prim, &v[0], &v[1], &v[2]);
+	}
+}
+
+void R_Draw(R_Pipeline* in, u32 start, u32 count) {
+	s_frame_stats.draw_calls++;
+	if (in->shader->kind == SoftShader_Unknown) return;
+	Soft_DrawContext ctx;
+	if (!Soft_DrawContextInit(&ctx, in)) return;
+	Soft_DrawInstance(&ctx, in, start, count, 0);
+}
+
+void R_DrawInstanced(R_Pipeline* in, u32 start, u32 count, u32 instance_count) {
+	s_frame_stats.draw_calls++;
+	if (in->shader->kind == SoftShader_Unknown) return;
+	Soft_DrawContext ctx;
+	if (!Soft_DrawContextInit(&ctx, in)) return;
+	for (u32 i = 0; i < instance_count; i++)
+		Soft_DrawInstance(&ctx, in, start, count, i);
+}
+
+//~ GPU Timers
+
+// NOTE(voxel): Rasterization happens right inside the R_ calls, so the "GPU" time of a
+// scope is just the CPU time spent in it.
+typedef struct Soft_TimerScope {
+	u8  name_buffer[32];
+	string name;
+	u64 begin;
+
+	f64 history[R_GPU_TIMER_HISTORY];
+	f64 history_sum;
+	u32 history_index;
+	u32 history_count;
+	f64 last_ms;
+} Soft_TimerScope;
+
+static Soft_TimerScope s_timer_scopes[R_GPU_TIMER_MAX_SCOPES];
+static u32 s_timer_scope_count;
+static Soft_TimerScope* s_timer_active;
+
+void R_GPUTimerBegin(string name) {
+	if (s_timer_active) {
+		LogError("[Soft Backend] GPU timer '%.*s' started inside '%.*s'. Timer scopes can't nest",
+				 str_expand(name), str_expand(s_timer_active->name));
+		return;
+	}
+
+	Soft_TimerScope* scope = nullptr;
+	for (u32 i = 0; i < s_timer_scope_count; i++) {
+		if (str_eq(s_timer_scopes[i].name, name)) {
+			scope = &s_timer_scopes[i];
+			break;
+		}
+	}
+	if (!scope) {
+		if (s_timer_scope_count == R_GPU_TIMER_MAX_SCOPES) return;
+		scope = &s_timer_scopes[s_timer_scope_count++];
+		MemoryZeroStruct(scope, Soft_TimerScope);
+		u64 size = Min(name.size, sizeof(scope->name_buffer));
+		MemoryCopy(scope->name_buffer, name.str, size);
+		scope->name = (string) { scope->name_buffer, size };
+	}
+
+	s_timer_active = scope;
+	scope->begin = OS_TimeMicrosecondsNow();
+}
+
+void R_GPUTimerEnd(string name) {
+	if (!s_timer_active) return;
+	Soft_TimerScope* scope = s_timer_active;
+	s_timer_active = nullptr;
+
+	f64 ms = (f64) (OS_TimeMicrosecondsNow() - scope->begin) / 1000.0;
+	scope->last_ms = ms;
+	scope->history_sum -= scope->history[scope->history_index];
+	scope->history[scope->history_index] = ms;
+	scope->history_sum += ms;
+	scope->history_index = (scope->history_index + 1) % R_GPU_TIMER_HISTORY;
+	if (scope->history_count < R_GPU_TIMER_HISTORY) scope->history_count++;
+}
+
+u32 R_GPUTimerCount(void) {
+	return s_timer_scope_count;
+}
+
+R_GPUTimerStats R_GPUTimerGet(u32 index) {
+	if (index >= s_timer_scope_count) return (R_GPUTimerStats) {0};
+	Soft_TimerScope* scope = &s_timer_scopes[index];
+	return (R_GPUTimerStats) {
+		.name = scope->name,
+		.last_ms = scope->last_ms,
+		.average_ms = scope->history_count ? scope->history_sum / scope->history_count : 0.0,
+		.sample_count = scope->history_count,
+	};
+}
@@ -0,0 +1,103 @@
+/* date = October 19th 2026 10:12 am */
+
+#ifndef SOFT_RESOURCES_H
+#define SOFT_RESOURCES_H
+
+SwissTable_Prototype(string, i32);
+
+#define SOFT_MAX_VERTEX_BUFFERS 4
+#define SOFT_MAX_ATTRIBUTES 16
+#define SOFT_MAX_TEXTURE_UNITS 32
+
+// NOTE(voxel): There is no shader compiler here. A shader pack gets matched against
+// the shaders this codebase ships with, and R_Draw runs the C equivalent of that one.
+typedef u32 R_SoftShaderKind;
+enum {
+	SoftShader_Unknown,
+	SoftShader_Render2D,
+	SoftShader_UI,
+
+	SoftShader_MAX,
+};
+
+typedef struct R_Buffer {
+	R_BufferFlags flags;
+	u32 v_stride;
+	u8* data;
+	u64 size;
+} R_Buffer;
+
+typedef struct R_UniformBuffer {
+	R_ShaderType stage;
+	string name;
+	swiss_table(string, i32) uniform_offsets;
+	// Only has entries for the arrays that outgrew their slot
+	swiss_table(string, i32) uniform_sizes;
+	u8* cpu_side_buffer;
+	b8  dirty;
+	u32 size;
+} R_UniformBuffer;
+
+typedef struct R_Shader {
+	R_ShaderType type;
+	R_SoftShaderKind kind;
+} R_Shader;
+
+typedef struct R_ShaderPack {
+	R_SoftShaderKind kind;
+	i32 sampler_units[8];
+} R_ShaderPack;
+
+typedef R_UniformBuffer* R_UniformBufferHandle;
+DArray_Prototype(R_UniformBufferHandle);
+
+typedef struct R_Pipeline {
+	R_InputAssembly assembly;
+	R_Attribute* attributes;
+	R_ShaderPack* shader;
+	R_BlendMode blend_mode;
+	u32 attribute_count;
+
+	darray(R_UniformBufferHandle) uniform_buffers;
+
+	R_Buffer* buffers[SOFT_MAX_VERTEX_BUFFERS];
+	u32 buffer_strides[SOFT_MAX_VERTEX_BUFFERS];
+	u32 attribute_buffers[SOFT_MAX_ATTRIBUTES];
+	u32 attribute_offsets[SOFT_MAX_ATTRIBUTES];
+
+	u32 bindpoint;
+	u32 attribpoint;
+} R_Pipeline;
+
+typedef struct R_Texture2D {
+	u32 width;
+	u32 height;
+
+	R_TextureFormat format;
+	R_TextureResizeParam min;
+	R_TextureResizeParam mag;
+	R_TextureWrapParam wrap_s;
+	R_TextureWrapParam wrap_t;
+	R_TextureMutability mut;
+	R_TextureUsage usage;
+
+	// data is in the format the texture was created with, texels is the same image
+	// expanded to RGBA8 (0xAABBGGRR) with the swizzle already applied
+	u8*  data;
+	u32* texels;
+	i32  swizzle[4];
+
+	u32 handle;
+} R_Texture2D;
+
+typedef struct R_Framebuffer {
+	u32 width;
+	u32 height;
+
+	R_Texture2D* color_attachments;
+	u32 color_attachment_count;
+	R_Texture2D depth_attachment;
+} R_Framebuffer;
+
+
+#endif //SOFT_RESOURCES_H
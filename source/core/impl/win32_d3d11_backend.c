@@ -136,9 +136,12 @@ void B_BackendSelectRenderWindow(OS_Window* _window) {
 
 void B_BackendSwapchainNext(OS_Window* _window) {
 	W32_Window* window = (W32_Window*)_window;
+	R_GPUTimerBegin(str_lit("B_BackendSwapchainNext"));
 	
 	// NOTE(voxel): sync interval (2nd param) is set to 0 for uncapped fps
 	IDXGISwapChain_Present(window->swapchain, 0, 0);
+	R_GPUTimerEnd(str_lit("B_BackendSwapchainNext"));
+	R_FrameStatsNext();
 }
 
 void B_BackendFree(OS_Window* _window) {
@@ -280,10 +280,13 @@ void B_BackendSelectRenderWindow(OS_Window* _window) {
 
 void B_BackendSwapchainNext(OS_Window* _window) {
 	W32_Window* window = (W32_Window*) _window;
+	R_GPUTimerBegin(str_lit("B_BackendSwapchainNext"));
 	HDC dc = GetDC(window->handle);
 	SwapBuffers(dc);
 	ReleaseDC(window->handle, dc);
 	glFlush();
+	R_GPUTimerEnd(str_lit("B_BackendSwapchainNext"));
+	R_FrameStatsNext();
 }
 
 void B_BackendFree(OS_Window* _window) {
@@ -4,14 +4,21 @@
 
 
 #if defined(BACKEND_GL46)
+#  include "impl/gl_program_cache.c"
 #  include "impl/gl46_resources.c"
+#  include "impl/gl_timers.c"
 
 #elif defined(BACKEND_GL33)
+#  include "impl/gl_program_cache.c"
 #  include "impl/gl33_resources.c"
+#  include "impl/gl_timers.c"
 
 #elif defined(BACKEND_D3D11)
 #  include "impl/d3d11_resources.c"
 
+#elif defined(BACKEND_SOFT)
+#  include "impl/soft_resources.c"
+
 #endif
 
 void R_Texture2DWhite(R_Texture2D* texture) {
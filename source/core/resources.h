@@ -18,6 +18,9 @@ enum {
 	// Enable only one of these
 	BufferFlag_Type_Vertex = 0x2,
 	BufferFlag_Type_Index = 0x4,
+	
+	// Vertex buffers only. Advances once per instance instead of once per vertex
+	BufferFlag_PerInstance = 0x8,
 };
 
 typedef u32 R_ShaderType;
@@ -49,6 +52,10 @@ enum {
 	AttributeType_Integer2,
 	AttributeType_Integer3,
 	AttributeType_Integer4,
+	// Four u8s read as floats in [0, 1], for packed colors
+	AttributeType_UByte4Norm,
+	// Two u16s. GLSL reads them as floats and HLSL as uint2, since D3D11 can't convert
+	AttributeType_UShort2,
 	
 	AttributeType_MAX,
 };
@@ -143,6 +150,8 @@ enum {
 #  include "impl/gl46_resources.h"
 #elif defined(BACKEND_D3D11)
 #  include "impl/d3d11_resources.h"
+#elif defined(BACKEND_SOFT)
+#  include "impl/soft_resources.h"
 #endif
 
 
@@ -161,6 +170,7 @@ void R_UniformBufferSetInt(R_UniformBuffer* buf, string name, i32 val);
 void R_UniformBufferSetIntArray(R_UniformBuffer* buf, string name, i32* vals, u32 count);
 void R_UniformBufferSetFloat(R_UniformBuffer* buf, string name, f32 val);
 void R_UniformBufferSetVec4(R_UniformBuffer* buf, string name, vec4 val);
+void R_UniformBufferSetVec4Array(R_UniformBuffer* buf, string name, vec4* vals, u32 count);
 
 //~ Shaders
 void R_ShaderAlloc(R_Shader* shader, string data, R_ShaderType type);
@@ -191,6 +201,7 @@ void R_PipelineFree(R_Pipeline* in);
 void R_Texture2DAlloc(R_Texture2D* texture, R_TextureFormat format, u32 width, u32 height, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t, R_TextureMutability mut, R_TextureUsage usage, void* initial_data);
 void R_Texture2DAllocLoad(R_Texture2D* texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t, R_TextureMutability mut, R_TextureUsage usage);
 void R_Texture2DData(R_Texture2D* texture, void* data);
+void R_Texture2DSubData(R_Texture2D* texture, u32 x, u32 y, u32 width, u32 height, void* data);
 void R_Texture2DWhite(R_Texture2D* texture);
 b8   R_Texture2DEquals(R_Texture2D* a, R_Texture2D* b);
 void R_Texture2DSwizzle(R_Texture2D* texture, i32* swizzles);
@@ -213,5 +224,36 @@ void R_Clear(R_BufferMask buffer_mask);
 void R_ClearColor(f32 r, f32 g, f32 b, f32 a);
 void R_Viewport(i32 x, i32 y, i32 w, i32 h);
 void R_Draw(R_Pipeline* pipeline, u32 start, u32 count);
+void R_DrawInstanced(R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count);
+
+//~ Frame Statistics
+typedef struct R_FrameStats {
+	u32 state_changes_issued;
+	u32 state_changes_skipped;
+	u32 draw_calls;
+} R_FrameStats;
+
+// NOTE(voxel): Returns the counters of the last completed frame.
+// Frames are delimited by R_FrameStatsNext, which B_BackendSwapchainNext calls
+R_FrameStats R_FrameStatsGet(void);
+void R_FrameStatsNext(void);
+
+//~ GPU Timers
+#define R_GPU_TIMER_MAX_SCOPES 16
+#define R_GPU_TIMER_HISTORY 64
+
+typedef struct R_GPUTimerStats {
+	string name;
+	f64 last_ms;
+	f64 average_ms;
+	u32 sample_count;
+} R_GPUTimerStats;
+
+// NOTE(voxel): Scopes are identified by name and can't nest. Results are read back a
+// few frames late instead of stalling, so averages lag behind by that much
+void R_GPUTimerBegin(string name);
+void R_GPUTimerEnd(string name);
+u32  R_GPUTimerCount(void);
+R_GPUTimerStats R_GPUTimerGet(u32 index);
 
 #endif //RESOURCES_H
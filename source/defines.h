@@ -98,6 +98,11 @@ flush;\
 #  error dll_export not defined for this compiler
 #endif
 
+// For whatever different threads write, so two of them don't end up on one cache line.
+// _Alignas is C11, which is why cl gets /std:c11
+#define CACHE_LINE_SIZE 64
+#define cache_line_aligned _Alignas(CACHE_LINE_SIZE)
+
 #ifdef IS_PLUGIN
 #  define dll_plugin_api
 #else
@@ -1,6 +1,12 @@
+#include "base/mem.h"
+
+#define STBI_MALLOC(sz) M_Alloc(sz)
+#define STBI_REALLOC(p, newsz) M_Realloc(p, newsz)
+#define STBI_FREE(p) M_Free(p)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
 
+#define STBTT_malloc(x, u) ((void)(u), M_Alloc(x))
+#define STBTT_free(x, u) ((void)(u), M_Free(x))
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb/stb_truetype.h>
-
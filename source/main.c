@@ -6,13 +6,23 @@
 #include "core/backend.h"
 #include "core/resources.h"
 #include "opt/render_2d.h"
+#if defined(USE_PERF_HUD)
+#include "opt/perf_hud.h"
+#endif
 
 #include "chip8.h"
 
+#if defined(USE_PERF_HUD)
+static PH_HUD* hud;
+#endif
+
 void MyResizeCallback(OS_Window* window, i32 w, i32 h) {
   // TODO(voxel): @awkward Add a "first resize" to Win32Window so that This if isn't required
   if (window->user_data) {
     R_Viewport(0, 0, w, h);
+#if defined(USE_PERF_HUD)
+    if (hud) PH_Resize(hud, w, h);
+#endif
   }
 }
 
@@ -31,7 +41,16 @@ int main(int argc, char **argv) {
   R2D_Renderer renderer = {0};
   R2D_Init(window, &renderer);
   
-  srand((u32) OS_TimeMicrosecondsNow());
+#if defined(USE_PERF_HUD)
+  PH_StatsRing* stats = arena_alloc_zero(&global_arena, sizeof(PH_StatsRing));
+  hud = arena_alloc(&global_arena, sizeof(PH_HUD));
+  PH_Init(hud, window, stats);
+  PH_WatchArena(hud, str_lit("Global"), &global_arena);
+  PH_WatchArena(hud, str_lit("Frame"), U_GetFrameArena());
+  PH_WatchArena(hud, str_lit("Thread"), &context.arena);
+#endif
+  
+  srand((u32) OS_TimeNanosecondsNow());
   
   Chip_Exec_Context* ctx = arena_alloc(&global_arena, sizeof(Chip_Exec_Context));
   Chip_Initialize(ctx);
@@ -46,14 +65,14 @@ int main(int argc, char **argv) {
   string rom = OS_FileRead(&global_arena, fp);
   memmove(&ctx->memory[0x200], rom.str, rom.size);
   
-  f32 start = 0.f; f32 end = 0.016f;
-  f32 delta = 0.016f;
+  // NOTE(voxel): Timestamps stay u64 nanoseconds, only the per-frame delta is small
+  // enough to go through a float
+  OS_FramePacer pacer = {0};
+  OS_FramePacerInit(&pacer, 1000000000ull / 60);
+  f32 delta = 1.f / 60.f;
   b8 step_mode = true;
   
   while (OS_WindowIsOpen(window)) {
-    delta = end - start;
-    start = OS_TimeMicrosecondsNow();
-    delta /= 1e6;
     
     U_ResetFrameArena();
     OS_PollEvents();
@@ -65,6 +84,11 @@ int main(int argc, char **argv) {
     }
     
     R_Clear(BufferMask_Color);
+#if defined(USE_PERF_HUD)
+    PH_FrameSample sample = {0};
+    u64 instructions_before = ctx->instructions_executed;
+    u64 begin = OS_TimeNanosecondsNow();
+#endif
     if (step_mode) {
       if (OS_InputButtonPressed(Input_MouseButton_Left)) {
         Chip_Step(ctx);
@@ -72,6 +96,9 @@ int main(int argc, char **argv) {
     } else {
       Chip_Tick(ctx, delta);
     }
+#if defined(USE_PERF_HUD)
+    sample.tick_ns = OS_TimeNanosecondsNow() - begin;
+#endif
     
     R2D_BeginDraw(&renderer);
     for (u32 i = 0; i < 64; i++) {
@@ -81,15 +108,34 @@ int main(int argc, char **argv) {
         }
       }
     }
+#if defined(USE_PERF_HUD)
+    begin = OS_TimeNanosecondsNow();
     R2D_EndDraw(&renderer);
+    sample.draw_ns = OS_TimeNanosecondsNow() - begin;
+    
+    PH_Update(hud, window, delta);
     
+    begin = OS_TimeNanosecondsNow();
     B_BackendSwapchainNext(window);
+    sample.present_ns = OS_TimeNanosecondsNow() - begin;
     
-    end = OS_TimeMicrosecondsNow();
+    sample.frame_ns = OS_FramePacerWait(&pacer);
+    sample.instructions = ctx->instructions_executed - instructions_before;
+    sample.draw_calls = R_FrameStatsGet().draw_calls;
+    PH_StatsPush(stats, &sample);
+    delta = (f32) (sample.frame_ns / 1e9);
+#else
+    R2D_EndDraw(&renderer);
+    B_BackendSwapchainNext(window);
+    delta = (f32) (OS_FramePacerWait(&pacer) / 1e9);
+#endif
   }
   
   
   Chip_Free(ctx);
+#if defined(USE_PERF_HUD)
+  PH_Free(hud);
+#endif
   R2D_Free(&renderer);
   B_BackendFree(window);
   OS_WindowClose(window);
@@ -0,0 +1,197 @@
+#include "perf_hud.h"
+
+#include <stdarg.h>
+#include "os/input.h"
+
+//~ Stats Ring
+
+void PH_StatsPush(PH_StatsRing* ring, PH_FrameSample* sample) {
+	u64 index = ring->write_index;
+	ring->samples[index & (PH_RING_SIZE - 1)] = *sample;
+	OS_AtomicStore(&ring->write_index, index + 1, MemoryOrder_Release);
+}
+
+u32 PH_StatsRead(PH_StatsRing* ring, PH_FrameSample* out, u32 max) {
+	u64 end = OS_AtomicLoad(&ring->write_index, MemoryOrder_Acquire);
+	u64 count = Min(Min(end, (u64) PH_RING_SIZE), (u64) max);
+	u64 begin = end - count;
+	for (u64 i = begin; i < end; i++) {
+		out[i - begin] = ring->samples[i & (PH_RING_SIZE - 1)];
+	}
+
+	// NOTE(voxel): The slot of index i gets reused by the push of i + PH_RING_SIZE, which
+	// might have started as soon as write_index reached that. Anything older than that
+	// could have been torn while being copied
+	OS_AtomicFence(MemoryOrder_Acquire);
+	u64 now = OS_AtomicLoad(&ring->write_index, MemoryOrder_Relaxed);
+	u64 first_intact = now >= PH_RING_SIZE ? now - PH_RING_SIZE + 1 : 0;
+	if (first_intact <= begin) return (u32) count;
+	if (first_intact >= end) return 0;
+
+	u64 dropped = first_intact - begin;
+	memmove(out, out + dropped, (count - dropped) * sizeof(PH_FrameSample));
+	return (u32) (count - dropped);
+}
+
+//~ HUD
+
+#define PH_HUD_WIDTH 400
+#define PH_GRAPH_HEIGHT 64
+
+// The graph's custom renderer has no other way to get at the samples
+static PH_HUD* s_drawing_hud;
+
+static int PH_CompareU64(const void* a, const void* b) {
+	u64 x = *(const u64*) a;
+	u64 y = *(const u64*) b;
+	return (x > y) - (x < y);
+}
+
+// Nearest rank, sorted has to be in ascending order
+static u64 PH_Percentile(u64* sorted, u32 count, u32 percent) {
+	if (!count) return 0;
+	u32 rank = (count * percent + 99) / 100;
+	return sorted[rank ? rank - 1 : 0];
+}
+
+static void PH_GraphRenderFunction(UI_Cache* ui_cache, UI_Box* box) {
+	PH_HUD* hud = s_drawing_hud;
+	UI_PushQuad(ui_cache, box->bounds, rect_init(0, 0, 1, 1), &ui_cache->white_texture,
+				UI_ColorToVec4Set(0x050505FF), 0.f, 0.f, 0.f);
+	if (!hud->sample_count || !hud->frame_max) return;
+
+	// Newest sample on the right, one bar per slot of the ring
+	f32 bar_width = box->bounds.w / PH_RING_SIZE;
+	f32 scale = box->bounds.h / (f32) hud->frame_max;
+	f32 x = box->bounds.x + box->bounds.w - hud->sample_count * bar_width;
+	for (u32 i = 0; i < hud->sample_count; i++) {
+		u64 frame_ns = hud->samples[i].frame_ns;
+		f32 height = frame_ns * scale;
+		u32 color = frame_ns > hud->frame_p99 ? 0xE0504AFF : 0x5EBD7AFF;
+		UI_PushQuad(ui_cache, rect_init(x, box->bounds.y + box->bounds.h - height, bar_width, height),
+					rect_init(0, 0, 1, 1), &ui_cache->white_texture, UI_ColorToVec4Set(color), 0.f, 0.f, 0.f);
+		x += bar_width;
+	}
+
+	f32 p50_y = box->bounds.y + box->bounds.h - hud->frame_p50 * scale;
+	f32 p99_y = box->bounds.y + box->bounds.h - hud->frame_p99 * scale;
+	UI_PushQuad(ui_cache, rect_init(box->bounds.x, p50_y, box->bounds.w, 1), rect_init(0, 0, 1, 1),
+				&ui_cache->white_texture, UI_ColorToVec4Set(0xFFFFFF90), 0.f, 0.f, 0.f);
+	UI_PushQuad(ui_cache, rect_init(box->bounds.x, p99_y, box->bounds.w, 1), rect_init(0, 0, 1, 1),
+				&ui_cache->white_texture, UI_ColorToVec4Set(0xE0504AC0), 0.f, 0.f, 0.f);
+}
+
+// Keyed on where it is in the panel. Cached boxes keep what they were made with, so the
+// text is set every frame
+static void PH_Label(UI_Cache* ui, const char* fmt, ...) {
+	va_list args;
+	va_start(args, fmt);
+	string text = str_from_formatv(U_GetFrameArena(), fmt, args);
+	va_end(args);
+	UI_Box* box = UI_BoxMakeF(ui, BoxFlag_DrawText, "###ph_label%u", ui->box_count);
+	box->identifier = text;
+}
+
+static void PH_TimingLabel(UI_Cache* ui, const char* name, u64 total_ns, u64 frame_total_ns, u32 count) {
+	f64 ms = count ? total_ns / (f64) count / 1e6 : 0;
+	f64 share = frame_total_ns ? 100.0 * total_ns / (f64) frame_total_ns : 0;
+	PH_Label(ui, "%-22s %6.2f ms %3.0f%%", name, ms, share);
+}
+
+static void PH_ArenaLabel(UI_Cache* ui, string name, M_Arena* arena) {
+	M_ArenaStats stats = arena_get_stats(arena);
+	PH_Label(ui, "%-10.*s peak %9.1f KB  commit %9.1f KB", str_expand(name),
+			 stats.peak / (f64) Kilobytes(1), stats.committed / (f64) Kilobytes(1));
+}
+
+void PH_Init(PH_HUD* hud, OS_Window* window, PH_StatsRing* ring) {
+	MemoryZeroStruct(hud, PH_HUD);
+	hud->ring = ring;
+	UI_Init(window, &hud->ui);
+	UI_LoadFont(&hud->font, str_lit("res/Inconsolata.ttf"), 16);
+}
+
+void PH_Free(PH_HUD* hud) {
+	UI_FreeFont(&hud->font);
+	UI_Free(&hud->ui);
+}
+
+void PH_Resize(PH_HUD* hud, i32 w, i32 h) {
+	UI_Resize(&hud->ui, w, h);
+}
+
+void PH_WatchArena(PH_HUD* hud, string name, M_Arena* arena) {
+	if (hud->arena_count >= PH_MAX_ARENAS) {
+		LogError("[Perf HUD] Can only watch %u arenas, %.*s is left out", PH_MAX_ARENAS, str_expand(name));
+		return;
+	}
+	hud->arena_names[hud->arena_count] = name;
+	hud->arenas[hud->arena_count] = arena;
+	hud->arena_count++;
+}
+
+void PH_Update(PH_HUD* hud, OS_Window* window, f32 delta_time) {
+	if (OS_InputKeyPressed(PH_TOGGLE_KEY)) hud->visible = !hud->visible;
+	if (!hud->visible) return;
+
+	//- Summary of the samples in the ring
+	hud->sample_count = PH_StatsRead(hud->ring, hud->samples, PH_RING_SIZE);
+
+	u64 sorted[PH_RING_SIZE];
+	u64 frame_total = 0, tick_total = 0, draw_total = 0, present_total = 0, instructions = 0;
+	for (u32 i = 0; i < hud->sample_count; i++) {
+		PH_FrameSample* sample = &hud->samples[i];
+		sorted[i] = sample->frame_ns;
+		frame_total += sample->frame_ns;
+		tick_total += sample->tick_ns;
+		draw_total += sample->draw_ns;
+		present_total += sample->present_ns;
+		instructions += sample->instructions;
+	}
+	qsort(sorted, hud->sample_count, sizeof(u64), PH_CompareU64);
+	hud->frame_p50 = PH_Percentile(sorted, hud->sample_count, 50);
+	hud->frame_p99 = PH_Percentile(sorted, hud->sample_count, 99);
+	hud->frame_max = hud->sample_count ? sorted[hud->sample_count - 1] : 0;
+
+	f64 ips = frame_total ? instructions / (frame_total / 1e9) : 0;
+	u32 draw_calls = hud->sample_count ? hud->samples[hud->sample_count - 1].draw_calls : 0;
+
+	//- Overlay
+	UI_Cache* ui = &hud->ui;
+	UI_BeginFrame(window, ui);
+
+	UI_Font(ui, &hud->font)
+		UI_BoxColor(ui, 0x111111D8)
+		UI_PrefWidth(ui, UI_Pixels(PH_HUD_WIDTH))
+		UI_PrefHeight(ui, UI_ChildrenSum()) {
+		UI_Box* panel = UI_BoxMake(ui, BoxFlag_DrawBackground | BoxFlag_DrawBorder | BoxFlag_Clip, str_lit("ph_panel"));
+
+		UI_Parent(ui, panel)
+			UI_PrefWidth(ui, UI_TextContent(6))
+			UI_PrefHeight(ui, UI_TextContent(1)) {
+			PH_Label(ui, "Emulated  %10.0f instr/s", ips);
+			PH_Label(ui, "Frame     p50 %6.2f ms  p99 %6.2f ms", hud->frame_p50 / 1e6, hud->frame_p99 / 1e6);
+
+			// The bars come from the samples, which the box knows nothing about
+			UI_CustomRenderFunctionSetNext(ui, PH_GraphRenderFunction);
+			UI_PrefWidth(ui, UI_Percentage(100)) UI_PrefHeight(ui, UI_Pixels(PH_GRAPH_HEIGHT)) {
+				UI_Box* graph = UI_BoxMake(ui, BoxFlag_CustomRenderer, str_lit("##ph_graph"));
+				graph->custom_render_hash = str_hash_64((string_const) { (u8*) hud->samples, hud->sample_count * sizeof(PH_FrameSample) });
+			}
+
+			PH_TimingLabel(ui, "Chip_Tick", tick_total, frame_total, hud->sample_count);
+			PH_TimingLabel(ui, "R2D_EndDraw", draw_total, frame_total, hud->sample_count);
+			PH_TimingLabel(ui, "B_BackendSwapchainNext", present_total, frame_total, hud->sample_count);
+			PH_Label(ui, "Draw calls %u", draw_calls);
+			for (u32 i = 0; i < hud->arena_count; i++) {
+				PH_ArenaLabel(ui, hud->arena_names[i], hud->arenas[i]);
+			}
+			// ChildrenSum leaves out the border the children got pushed down by
+			UI_PrefWidth(ui, UI_Pixels(0)) UI_Spacer(ui, UI_Pixels(panel->edge_size * 2));
+		}
+	}
+
+	s_drawing_hud = hud;
+	UI_EndFrame(ui, delta_time);
+	s_drawing_hud = nullptr;
+}
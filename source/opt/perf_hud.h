@@ -0,0 +1,81 @@
+//~
+//
+//                                 PERF_HUD Optional Layer.
+// NOTE(voxel): Needs the UI layer. Overlay with the numbers needed to make sense of a hitch
+//              on a machine that doesn't have a profiler on it.
+//
+//
+//~
+
+/* date = October 19th 2026 3:40 pm */
+
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/window.h"
+#include "opt/ui.h"
+
+//~ Stats Ring
+
+// One per host frame. Timings are CPU side, in nanoseconds
+typedef struct PH_FrameSample {
+	u64 frame_ns;     // The whole frame, pacing included
+	u64 tick_ns;      // Chip_Tick (or Chip_Step)
+	u64 draw_ns;      // R2D_EndDraw
+	u64 present_ns;   // B_BackendSwapchainNext
+	u64 instructions; // Emulated during the frame
+	u32 draw_calls;
+} PH_FrameSample;
+
+// Has to be a power of two
+#define PH_RING_SIZE 256
+
+// NOTE(voxel): One writer, any number of readers, no locks. The writer fills in a slot and
+// then publishes it by bumping write_index, which is all a push costs. Readers copy what
+// they want and look at write_index again afterwards, dropping whatever the writer could
+// have lapped in the meantime.
+typedef struct PH_StatsRing {
+	PH_FrameSample samples[PH_RING_SIZE];
+	u64 write_index;
+} PH_StatsRing;
+
+void PH_StatsPush(PH_StatsRing* ring, PH_FrameSample* sample);
+// Copies up to max of the newest samples into out, oldest first. Returns how many
+u32  PH_StatsRead(PH_StatsRing* ring, PH_FrameSample* out, u32 max);
+
+//~ HUD
+
+#define PH_TOGGLE_KEY Input_Key_F3
+#define PH_MAX_ARENAS 4
+
+typedef struct PH_HUD {
+	UI_Cache ui;
+	UI_FontInfo font;
+	PH_StatsRing* ring;
+	b8 visible;
+
+	string arena_names[PH_MAX_ARENAS];
+	M_Arena* arenas[PH_MAX_ARENAS];
+	u32 arena_count;
+
+	// Copied out of the ring at the start of every frame the HUD is up
+	PH_FrameSample samples[PH_RING_SIZE];
+	u32 sample_count;
+	u64 frame_p50;
+	u64 frame_p99;
+	u64 frame_max;
+} PH_HUD;
+
+void PH_Init(PH_HUD* hud, OS_Window* window, PH_StatsRing* ring);
+void PH_Free(PH_HUD* hud);
+void PH_Resize(PH_HUD* hud, i32 w, i32 h);
+
+// Peak and committed sizes of watched arenas are listed under the timings
+void PH_WatchArena(PH_HUD* hud, string name, M_Arena* arena);
+
+// Toggles on PH_TOGGLE_KEY. Draws on top of whatever is already in the backbuffer
+void PH_Update(PH_HUD* hud, OS_Window* window, f32 delta_time);
+
+#endif //PERF_HUD_H
@@ -2,8 +2,11 @@
 
 #include "base/ds.h"
 
-DArray_Prototype(vec2);
-DArray_Impl(vec2);
+// GJK needs at most 3 points and EPA rarely gets anywhere near 32, so the simplex
+// stays on the stack
+SmallArray_Prototype(vec2, 32);
+SmallArray_Impl(vec2, 32);
+typedef small_array(vec2, 32) P2D_Simplex;
 
 Slice_Prototype(vec2);
 
@@ -43,7 +46,7 @@ static vec2 P2D_GJK_Support(P2D_Collider* a, P2D_Collider* b, vec2 d) {
 					);
 }
 
-static b8 P2D_GJK_HandleSimplex(darray(vec2)* simplex, vec2* d) {
+static b8 P2D_GJK_HandleSimplex(P2D_Simplex* simplex, vec2* d) {
 	if (simplex->len == 2) {
 		// Line case
 		vec2 b = simplex->elems[0], a = simplex->elems[1];
@@ -58,12 +61,12 @@ static b8 P2D_GJK_HandleSimplex(darray(vec2)* simplex, vec2* d) {
 		vec2 ab_perp = vec2_normalize(vec2_triple_product(ac, ab, ab));
 		vec2 ac_perp = vec2_normalize(vec2_triple_product(ab, ac, ac));
 		if (vec2_dot(ab_perp, ao) < 0) {
-			darray_remove(vec2, simplex, 0);
+			small_array_remove(vec2, 32, simplex, 0);
 			*d = ab_perp;
 			return false;
 		} else if (vec2_dot(ac_perp, ao) < 0) {
 			// erase B from simplex
-			darray_remove(vec2, simplex, 1);
+			small_array_remove(vec2, 32, simplex, 1);
 			*d = ac_perp;
 			return false;
 		} else return true;
@@ -71,7 +74,7 @@ static b8 P2D_GJK_HandleSimplex(darray(vec2)* simplex, vec2* d) {
 	return false;
 }
 
-static b8 P2D_EPA_IsWindingCounterClockwise(darray(vec2)* simplex) {
+static b8 P2D_EPA_IsWindingCounterClockwise(P2D_Simplex* simplex) {
 	f32 smn = 0;
 	IteratePtr(simplex, i) {
 		int j = i + 1 == simplex->len ? 0 : i + 1;
@@ -83,7 +86,7 @@ static b8 P2D_EPA_IsWindingCounterClockwise(darray(vec2)* simplex) {
 	return smn > 0.f;
 }
 
-static P2D_EPA_Edge P2D_EPA_FindClosestEdge(darray(vec2)* simplex) {
+static P2D_EPA_Edge P2D_EPA_FindClosestEdge(P2D_Simplex* simplex) {
 	P2D_EPA_Edge res = {0};
 	res.distance = FLOAT_MAX;
 	IteratePtr(simplex, i) {
@@ -113,26 +116,26 @@ b8 P2D_CheckCollision(P2D_Collider* a, P2D_Collider* b) {
 	if (d.x || d.y) d = vec2_normalize(d);
 	else d = (vec2) { 1, 0 };
 	
-	darray(vec2) simplex = {0};
-	darray_reserve(vec2, &simplex, 3);
-	darray_add(vec2, &simplex, P2D_GJK_Support(a, b, d));
+	P2D_Simplex simplex;
+	small_array_init(vec2, 32, &simplex);
+	small_array_add(vec2, 32, &simplex, P2D_GJK_Support(a, b, d));
 	
 	d = vec2_normalize(vec2_neg(simplex.elems[0]));
 	
 	while (true) {
 		vec2 A = P2D_GJK_Support(a, b, d);
 		if (vec2_dot(A, d) <= 0) {
-			darray_free(vec2, &simplex);
+			small_array_free(vec2, 32, &simplex);
 			return false;
 		}
-		darray_add(vec2, &simplex, A);
+		small_array_add(vec2, 32, &simplex, A);
 		if (P2D_GJK_HandleSimplex(&simplex, &d)) {
-			darray_free(vec2, &simplex);
+			small_array_free(vec2, 32, &simplex);
 			return true;
 		}
 	}
 	
-	darray_free(vec2, &simplex);
+	small_array_free(vec2, 32, &simplex);
 	return false;
 }
 
@@ -146,9 +149,9 @@ P2D_Collision P2D_GetCollision(P2D_Collider* a, P2D_Collider* b) {
 	if (d.x || d.y) d = vec2_normalize(d);
 	else d = (vec2) { 1, 0 };
 	
-	darray(vec2) simplex = {0};
-	darray_reserve(vec2, &simplex, 3);
-	darray_add(vec2, &simplex, P2D_GJK_Support(a, b, d));
+	P2D_Simplex simplex;
+	small_array_init(vec2, 32, &simplex);
+	small_array_add(vec2, 32, &simplex, P2D_GJK_Support(a, b, d));
 	
 	d = vec2_normalize(vec2_neg(simplex.elems[0]));
 	
@@ -158,7 +161,7 @@ P2D_Collision P2D_GetCollision(P2D_Collider* a, P2D_Collider* b) {
 			colliding = false;
 			break;
 		}
-		darray_add(vec2, &simplex, A);
+		small_array_add(vec2, 32, &simplex, A);
 		if (P2D_GJK_HandleSimplex(&simplex, &d)) {
 			colliding = true;
 			break;
@@ -179,13 +182,13 @@ P2D_Collision P2D_GetCollision(P2D_Collider* a, P2D_Collider* b) {
 				min_distance = d;
 				break;
 			} else {
-				darray_add_at(vec2, &simplex, p, e.index);
+				small_array_add_at(vec2, 32, &simplex, p, e.index);
 			}
 		}
 		resolution = vec2_scale(min_normal, min_distance + EPSILON);
 	}
 	
-	darray_free(vec2, &simplex);
+	small_array_free(vec2, 32, &simplex);
 	
 	return (P2D_Collision) {
 		.is_colliding = colliding,
@@ -1,12 +1,29 @@
 #include "render_2d.h"
+#include <stb/stb_image.h>
 
-DArray_Impl(R2D_Batch);
+ArenaArray_Impl(R2D_Batch);
+
+static b8  R2D_TextureKeyIsEqual(R2D_TextureKey a, R2D_TextureKey b) { return a == b; }
+static u64 R2D_TextureKeyHash(R2D_TextureKey key) {
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdull;
+  key ^= key >> 33;
+  return key;
+}
+SwissTable_Impl(R2D_TextureKey, R2D_AtlasRegion, R2D_TextureKeyIsEqual, R2D_TextureKeyHash);
+
+// The handle is u32 or a pointer depending on the backend, so it goes through a copy
+static R2D_TextureKey R2D_TextureKeyOf(R_Texture2D* texture) {
+  R2D_TextureKey key = 0;
+  MemoryCopy(&key, &texture->handle, sizeof(texture->handle));
+  return key;
+}
 
 static R2D_Batch* R2D_NextBatch(R2D_Renderer* renderer) {
   R2D_Batch* next = &renderer->batches.elems[++renderer->current_batch];
   
   if (renderer->current_batch >= renderer->batches.len) {
-		darray_add(R2D_Batch, &renderer->batches, (R2D_Batch) {0});
+		arena_array_add(R2D_Batch, &renderer->batches, (R2D_Batch) {0});
 		next = &renderer->batches.elems[renderer->current_batch];
     next->cache = R2D_VertexCacheCreate(&renderer->arena, R2D_MAX_INTERNAL_CACHE_VCOUNT);
   }
@@ -60,6 +77,179 @@ b8 R2D_VertexCachePush(R2D_VertexCache* cache, R2D_Vertex* vertices, u32 vertex_
   return true;
 }
 
+//~ Texture Atlas
+
+static b8 R2D_AtlasPagePack(R2D_AtlasPage* page, u32 width, u32 height, u32* x, u32* y) {
+  // Best fit among the open shelves, so short entries don't eat up tall shelves
+  R2D_AtlasShelf* best = nullptr;
+  for (u32 i = 0; i < page->shelf_count; i++) {
+    R2D_AtlasShelf* shelf = &page->shelves[i];
+    if (shelf->height < height || R2D_ATLAS_PAGE_SIZE - shelf->cursor_x < width) continue;
+    if (!best || shelf->height < best->height) best = shelf;
+  }
+  
+  // Open a new shelf if nothing fits or the best one would waste more than half its height
+  if (!best || best->height > height * 2) {
+    if (page->shelf_count < R2D_ATLAS_MAX_SHELVES && page->shelf_top + height <= R2D_ATLAS_PAGE_SIZE) {
+      best = &page->shelves[page->shelf_count++];
+      best->y = page->shelf_top;
+      best->height = height;
+      best->cursor_x = 0;
+      page->shelf_top += height;
+    }
+  }
+  if (!best) return false;
+  
+  *x = best->cursor_x;
+  *y = best->y;
+  best->cursor_x += width;
+  return true;
+}
+
+static R2D_AtlasPage* R2D_AtlasPageAlloc(R2D_Atlas* atlas, R_TextureResizeParam min, R_TextureResizeParam mag) {
+  if (atlas->page_count >= R2D_ATLAS_MAX_PAGES) return nullptr;
+  R2D_AtlasPage* page = &atlas->pages[atlas->page_count++];
+  MemoryZeroStruct(page, R2D_AtlasPage);
+  page->min = min;
+  page->mag = mag;
+  R_Texture2DAlloc(&page->texture, TextureFormat_RGBA, R2D_ATLAS_PAGE_SIZE, R2D_ATLAS_PAGE_SIZE,
+                   min, mag, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge,
+                   TextureMutability_Uncommon, TextureUsage_ShaderResource, nullptr);
+  return page;
+}
+
+// Expands R (coverage, eg. glyph bitmaps), RGB and RGBA data into RGBA with a border of
+// `padding` texels that repeats the edge, so linear filtering never picks up a neighbour.
+// Anything past about 64x64 is too big for a scratch arena (M_SCRATCH_SIZE), so the copy
+// goes in an arena of the caller's, which it frees once it's uploaded
+static u8* R2D_AtlasExpand(M_Arena* arena, R_TextureFormat format, u32 width, u32 height, u32 padding, u8* data) {
+  u32 padded_width = width + padding * 2;
+  u32 padded_height = height + padding * 2;
+  u32 channels = format == TextureFormat_R ? 1 : format == TextureFormat_RGB ? 3 : 4;
+  u8* pixels = arena_alloc(arena, padded_width * padded_height * 4);
+  
+  for (u32 y = 0; y < padded_height; y++) {
+    u32 src_y = Clamp(0, (i32) y - (i32) padding, (i32) height - 1);
+    for (u32 x = 0; x < padded_width; x++) {
+      u32 src_x = Clamp(0, (i32) x - (i32) padding, (i32) width - 1);
+      u8* src = data + (src_y * width + src_x) * channels;
+      u8* dst = pixels + (y * padded_width + x) * 4;
+      if (channels == 1) {
+        dst[0] = 255; dst[1] = 255; dst[2] = 255; dst[3] = src[0];
+      } else {
+        dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2];
+        dst[3] = channels == 4 ? src[3] : 255;
+      }
+    }
+  }
+  return pixels;
+}
+
+static b8 R2D_AtlasInsert(R2D_Renderer* renderer, R_Texture2D* texture, R_TextureFormat format, u32 width, u32 height, R_TextureResizeParam min, R_TextureResizeParam mag, u8* data) {
+  R2D_Atlas* atlas = &renderer->atlas;
+  u32 padded_width = width + R2D_ATLAS_PADDING * 2;
+  u32 padded_height = height + R2D_ATLAS_PADDING * 2;
+  
+  u32 x = 0, y = 0;
+  R2D_AtlasPage* page = nullptr;
+  for (u32 i = 0; i < atlas->page_count; i++) {
+    R2D_AtlasPage* curr = &atlas->pages[i];
+    if (curr->min != min || curr->mag != mag) continue;
+    if (R2D_AtlasPagePack(curr, padded_width, padded_height, &x, &y)) {
+      page = curr;
+      break;
+    }
+  }
+  if (!page) {
+    page = R2D_AtlasPageAlloc(atlas, min, mag);
+    if (!page || !R2D_AtlasPagePack(page, padded_width, padded_height, &x, &y))
+      return false;
+  }
+  
+  M_Arena arena;
+  arena_init(&arena);
+  u8* pixels = R2D_AtlasExpand(&arena, format, width, height, R2D_ATLAS_PADDING, data);
+  R_Texture2DSubData(&page->texture, x, y, padded_width, padded_height, pixels);
+  arena_free(&arena);
+  
+  R2D_AtlasRegion region = {
+    .page = page,
+    .uvs = rect_init((f32) (x + R2D_ATLAS_PADDING) / R2D_ATLAS_PAGE_SIZE,
+                     (f32) (y + R2D_ATLAS_PADDING) / R2D_ATLAS_PAGE_SIZE,
+                     (f32) width / R2D_ATLAS_PAGE_SIZE,
+                     (f32) height / R2D_ATLAS_PAGE_SIZE),
+  };
+  
+  // NOTE(voxel): Everything but the handle is the page's. The handle is an id counting down
+  // from the top of its range, which no backend hands out (GL and soft count up from 1,
+  // D3D11's are user space pointers), so copies of the struct still find the region
+  *texture = page->texture;
+  texture->width = width;
+  texture->height = height;
+  u64 id = ~0ull - atlas->next_id++;
+  MemoryCopy(&texture->handle, &id, sizeof(texture->handle));
+  swiss_table_set(R2D_TextureKey, R2D_AtlasRegion, &atlas->regions, R2D_TextureKeyOf(texture), region);
+  return true;
+}
+
+static void R2D_AtlasRemap(R2D_Renderer* renderer, R_Texture2D** texture, rect* uvs) {
+  R2D_AtlasRegion region;
+  if (!swiss_table_get(R2D_TextureKey, R2D_AtlasRegion, &renderer->atlas.regions, R2D_TextureKeyOf(*texture), &region))
+    return;
+  *texture = &region.page->texture;
+  uvs->x = region.uvs.x + uvs->x * region.uvs.w;
+  uvs->y = region.uvs.y + uvs->y * region.uvs.h;
+  uvs->w *= region.uvs.w;
+  uvs->h *= region.uvs.h;
+}
+
+void R2D_TextureAlloc(R2D_Renderer* renderer, R_Texture2D* texture, R_TextureFormat format, u32 width, u32 height, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t, void* data) {
+  b8 supported_format = format == TextureFormat_R || format == TextureFormat_RGB || format == TextureFormat_RGBA;
+  b8 atlasable = supported_format && data &&
+    width <= R2D_ATLAS_MAX_ENTRY_SIZE && height <= R2D_ATLAS_MAX_ENTRY_SIZE &&
+    wrap_s == TextureWrap_ClampToEdge && wrap_t == TextureWrap_ClampToEdge &&
+    (min == TextureResize_Nearest || min == TextureResize_Linear);
+  
+  if (atlasable && R2D_AtlasInsert(renderer, texture, format, width, height, min, mag, data))
+    return;
+  
+  // Coverage data still has to read as white + alpha when it isn't atlased
+  if (format == TextureFormat_R && data) {
+    M_Arena arena;
+    arena_init(&arena);
+    u8* pixels = R2D_AtlasExpand(&arena, format, width, height, 0, data);
+    R_Texture2DAlloc(texture, TextureFormat_RGBA, width, height, min, mag, wrap_s, wrap_t,
+                     TextureMutability_Immutable, TextureUsage_ShaderResource, pixels);
+    arena_free(&arena);
+    return;
+  }
+  R_Texture2DAlloc(texture, format, width, height, min, mag, wrap_s, wrap_t,
+                   TextureMutability_Immutable, TextureUsage_ShaderResource, data);
+}
+
+void R2D_TextureAllocLoad(R2D_Renderer* renderer, R_Texture2D* texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t) {
+  i32 width, height, channels;
+  stbi_set_flip_vertically_on_load(true);
+  u8* data = stbi_load((const char*)filepath.str, &width, &height, &channels, 4);
+  if (!data) {
+    LogError("[Render2D] Failed to load texture '%.*s'", str_expand(filepath));
+    return;
+  }
+  R2D_TextureAlloc(renderer, texture, TextureFormat_RGBA, width, height, min, mag, wrap_s, wrap_t, data);
+  stbi_image_free(data);
+}
+
+b8 R2D_TextureIsAtlased(R2D_Renderer* renderer, R_Texture2D* texture) {
+  return swiss_table_get(R2D_TextureKey, R2D_AtlasRegion, &renderer->atlas.regions, R2D_TextureKeyOf(texture), nullptr);
+}
+
+void R2D_TextureFree(R2D_Renderer* renderer, R_Texture2D* texture) {
+  // NOTE(voxel): Shelf space isn't reclaimed, the page only goes away with the renderer
+  if (swiss_table_del(R2D_TextureKey, R2D_AtlasRegion, &renderer->atlas.regions, R2D_TextureKeyOf(texture)))
+    return;
+  R_Texture2DFree(texture);
+}
+
 //~ Renderer Core
 
 void R2D_Init(OS_Window* window, R2D_Renderer* renderer) {
@@ -68,7 +258,9 @@ void R2D_Init(OS_Window* window, R2D_Renderer* renderer) {
 	renderer->current_batch = 0;
 	renderer->cull_quad = (rect) { 0, 0, window->width, window->height };
   renderer->offset = (vec2) { 0.f, 0.f };
-	darray_add(R2D_Batch, &renderer->batches, (R2D_Batch) {0});
+	arena_array_init(R2D_Batch, &renderer->batches, &renderer->arena);
+	arena_array_reserve(R2D_Batch, &renderer->batches, R2D_INITIAL_BATCH_CAP);
+	arena_array_add(R2D_Batch, &renderer->batches, (R2D_Batch) {0});
 	renderer->batches.elems[renderer->current_batch].cache = R2D_VertexCacheCreate(&renderer->arena, R2D_MAX_INTERNAL_CACHE_VCOUNT);
 	
 	R_ShaderPackAllocLoad(&renderer->shader, str_lit("res/shaders/render_2d"));
@@ -100,15 +292,21 @@ void R2D_Init(OS_Window* window, R2D_Renderer* renderer) {
 	mat4 projection = mat4_ortho(0, window->width, 0, window->height, -1, 1000);
 	R_UniformBufferSetMat4(&renderer->constants, str_lit("u_projection"), projection);
 	
-	R_Texture2DWhite(&renderer->white_texture);
-	R_Texture2DAllocLoad(&renderer->circle_texture, str_lit("res/circle.png"), TextureResize_Linear,
-                       TextureResize_Linear, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge,
-                       TextureMutability_Immutable, TextureUsage_ShaderResource);
+	swiss_table_init(R2D_TextureKey, R2D_AtlasRegion, &renderer->atlas.regions);
+	u8 white[] = { 255, 255, 255, 255 };
+	R2D_TextureAlloc(renderer, &renderer->white_texture, TextureFormat_RGBA, 1, 1, TextureResize_Linear,
+                   TextureResize_Linear, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge, white);
+	R2D_TextureAllocLoad(renderer, &renderer->circle_texture, str_lit("res/circle.png"), TextureResize_Linear,
+                       TextureResize_Linear, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge);
 }
 
 void R2D_Free(R2D_Renderer* renderer) {
 	R_UniformBufferFree(&renderer->constants);
-	R_Texture2DFree(&renderer->white_texture);
+	R2D_TextureFree(renderer, &renderer->white_texture);
+	R2D_TextureFree(renderer, &renderer->circle_texture);
+	for (u32 i = 0; i < renderer->atlas.page_count; i++)
+		R_Texture2DFree(&renderer->atlas.pages[i].texture);
+	swiss_table_free(R2D_TextureKey, R2D_AtlasRegion, &renderer->atlas.regions);
 	R_BufferFree(&renderer->buffer);
 	R_PipelineFree(&renderer->pipeline);
 	R_ShaderPackFree(&renderer->shader);
@@ -130,6 +328,7 @@ void R2D_BeginDraw(R2D_Renderer* renderer) {
 }
 
 void R2D_EndDraw(R2D_Renderer* renderer) {
+	R_GPUTimerBegin(str_lit("R2D_EndDraw"));
 	R_PipelineBind(&renderer->pipeline);
 	for (u32 i = 0; i < renderer->current_batch+1; i++) {
 		for (u32 t = 0; t < renderer->batches.elems[i].tex_count; t++) {
@@ -139,6 +338,7 @@ void R2D_EndDraw(R2D_Renderer* renderer) {
 		R_BufferUpdate(&renderer->buffer, 0, cache->count * sizeof(R2D_Vertex), (void*) cache->vertices);
 		R_Draw(&renderer->pipeline, 0, cache->count);
 	}
+	R_GPUTimerEnd(str_lit("R2D_EndDraw"));
 }
 
 rect D_PushCullRect(R2D_Renderer* renderer, rect new_quad) {
@@ -167,9 +367,10 @@ void R2D_DrawQuad(R2D_Renderer* renderer, rect quad, R_Texture2D* texture, rect
 	
 	if (!rect_overlaps(quad, renderer->cull_quad)) return;
 	
+	rect uv_culled = rect_uv_cull(quad, uvs, renderer->cull_quad);
+	R2D_AtlasRemap(renderer, &texture, &uv_culled);
 	R2D_Batch* batch = R2D_BatchGetCurrent(renderer, 6, texture);
 	i32 idx = R2D_BatchAddTexture(renderer, batch, texture);
-	rect uv_culled = rect_uv_cull(quad, uvs, renderer->cull_quad);
 	
 	R2D_Vertex vertices[] = {
 		{
@@ -249,9 +450,10 @@ void R2D_DrawQuadRotated(R2D_Renderer* renderer, rect quad, R_Texture2D* texture
 	
 	if (!rect_overlaps(quad, renderer->cull_quad)) return;
 	
+	rect uv_culled = rect_uv_cull(quad, uvs, renderer->cull_quad);
+	R2D_AtlasRemap(renderer, &texture, &uv_culled);
 	R2D_Batch* batch = R2D_BatchGetCurrent(renderer, 6, texture);
 	i32 idx = R2D_BatchAddTexture(renderer, batch, texture);
-	rect uv_culled = rect_uv_cull(quad, uvs, renderer->cull_quad);
 	
 	R2D_Vertex vertices_to_batch[] = {
 		{
@@ -328,9 +530,10 @@ void R2D_DrawLine(R2D_Renderer* renderer, vec2 start, vec2 end, f32 thickness, R
 	};
 	
 	
+	rect uv_culled = uvs;
+	R2D_AtlasRemap(renderer, &texture, &uv_culled);
 	R2D_Batch* batch = R2D_BatchGetCurrent(renderer, 6, texture);
 	i32 idx = R2D_BatchAddTexture(renderer, batch, texture);
-	rect uv_culled = uvs;
 	
 	R2D_Vertex vertices_to_batch[] = {
 		{
@@ -43,18 +43,66 @@ typedef struct R2D_Batch {
     u8 tex_count;
 } R2D_Batch;
 
-DArray_Prototype(R2D_Batch);
+ArenaArray_Prototype(R2D_Batch);
+
+// Batches come out of the renderer's arena right before their vertex caches do, so growing
+// the array moves it. Reserving up front keeps that from happening in a normal frame
+#define R2D_INITIAL_BATCH_CAP 8
+
+//~ Texture Atlas
+
+// NOTE(voxel): Small clamped textures get packed into shared pages so a scene full of
+// sprites only ever references a couple of textures and doesn't split batches.
+// The handle of the R_Texture2D handed out is the key: R2D_Draw* looks it up and remaps
+// the uvs, so the texture can be copied around by value like any other.
+#define R2D_ATLAS_PAGE_SIZE 2048
+#define R2D_ATLAS_MAX_PAGES 4
+#define R2D_ATLAS_MAX_SHELVES 128
+#define R2D_ATLAS_MAX_ENTRY_SIZE 256
+#define R2D_ATLAS_PADDING 1
+
+typedef struct R2D_AtlasShelf {
+	u32 y;
+	u32 height;
+	u32 cursor_x;
+} R2D_AtlasShelf;
+
+typedef struct R2D_AtlasPage {
+	R_Texture2D texture;
+	R_TextureResizeParam min;
+	R_TextureResizeParam mag;
+	
+	R2D_AtlasShelf shelves[R2D_ATLAS_MAX_SHELVES];
+	u32 shelf_count;
+	u32 shelf_top;
+} R2D_AtlasPage;
+
+typedef struct R2D_AtlasRegion {
+	R2D_AtlasPage* page;
+	rect uvs;
+} R2D_AtlasRegion;
+
+typedef u64 R2D_TextureKey;
+SwissTable_Prototype(R2D_TextureKey, R2D_AtlasRegion);
+
+typedef struct R2D_Atlas {
+	R2D_AtlasPage pages[R2D_ATLAS_MAX_PAGES];
+	u32 page_count;
+	u64 next_id;
+	swiss_table(R2D_TextureKey, R2D_AtlasRegion) regions;
+} R2D_Atlas;
 
 typedef struct R2D_Renderer {
 	M_Arena arena;
 	
-	darray(R2D_Batch) batches;
+	arena_array(R2D_Batch) batches;
     u8 current_batch;
     rect cull_quad;
     vec2 offset;
     
 	R_Texture2D white_texture;
 	R_Texture2D circle_texture;
+	R2D_Atlas atlas;
 	
 	R_UniformBuffer constants;
 	R_Pipeline pipeline;
@@ -69,6 +117,14 @@ void R2D_ResizeProjection(R2D_Renderer* renderer, vec2 render_size);
 void R2D_BeginDraw(R2D_Renderer* renderer);
 void R2D_EndDraw(R2D_Renderer* renderer);
 
+// Textures from these are packed into the atlas when they are small enough, don't repeat
+// and don't use mipmaps. Otherwise they fall back to a standalone texture.
+// Either way they have to be freed with R2D_TextureFree
+void R2D_TextureAlloc(R2D_Renderer* renderer, R_Texture2D* texture, R_TextureFormat format, u32 width, u32 height, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t, void* data);
+void R2D_TextureAllocLoad(R2D_Renderer* renderer, R_Texture2D* texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t);
+b8   R2D_TextureIsAtlased(R2D_Renderer* renderer, R_Texture2D* texture);
+void R2D_TextureFree(R2D_Renderer* renderer, R_Texture2D* texture);
+
 rect D_PushCullRect(R2D_Renderer* renderer, rect new_quad);
 void D_PopCullRect(R2D_Renderer* renderer, rect old_quad);
 vec2 D_PushOffset(R2D_Renderer* renderer, vec2 new_offset);
@@ -20,56 +20,298 @@ static u8* UI_ConvertSingleChannelToRGBA(M_Arena* arena, u8* bitmap, u32 width,
 	return ret_bitmap;
 }
 
+static b8 UI_GlyphKeyIsNull(UI_GlyphKey a) { return a.id == 0; }
+static b8 UI_GlyphKeyEquals(UI_GlyphKey a, UI_GlyphKey b) { return a.id == b.id; }
+static u64 UI_GlyphKeyHash(UI_GlyphKey a) { return a.id * 0x9E3779B97F4A7C15ull >> 16; }
+
+StableTable_Impl(UI_GlyphKey, UI_Glyph, UI_GlyphKeyIsNull, UI_GlyphKeyEquals, UI_GlyphKeyHash);
+
+static b8 UI_TextRunKeyIsNull(UI_TextRunKey a) { return a.id == 0; }
+static b8 UI_TextRunKeyEquals(UI_TextRunKey a, UI_TextRunKey b) { return a.id == b.id && str_eq(a.str, b.str); }
+static u64 UI_TextRunKeyHash(UI_TextRunKey a) { return a.id; }
+
+StableTable_Impl(UI_TextRunKey, UI_TextRun, UI_TextRunKeyIsNull, UI_TextRunKeyEquals, UI_TextRunKeyHash);
+
 void UI_LoadFont(UI_FontInfo* fontinfo, string filepath, f32 size) {
-	M_Arena arena;
-	arena_init(&arena);
+	MemoryZeroStruct(fontinfo, UI_FontInfo);
+	arena_init(&fontinfo->arena);
 	
 	FILE* ttfile = fopen((char*)filepath.str, "rb");
     AssertTrue(ttfile, "Failed to find Font file %.*s", str_expand(filepath));
 	fseek(ttfile, 0, SEEK_END);
 	u64 length = ftell(ttfile);
 	rewind(ttfile);
-	u8* buffer = arena_alloc(&arena, length);
+	u8* buffer = arena_alloc(&fontinfo->arena, length);
 	MemoryZero(buffer, length);
 	fread(buffer, length, 1, ttfile);
 	fclose(ttfile);
 	
-	u8* temp_bitmap = arena_alloc(&arena, 512 * 512);
-	MemoryZero(temp_bitmap, 512 * 512);
-	
-	stbtt_fontinfo finfo = {0};
-	stbtt_pack_context packctx;
-	stbtt_InitFont(&finfo, buffer, 0);
-	stbtt_PackBegin(&packctx, temp_bitmap, 512, 512, 0, 1, 0);
-	stbtt_PackSetOversampling(&packctx, 1, 1);
-	stbtt_PackFontRange(&packctx, buffer, 0, size, 32, 95, fontinfo->cdata);
-	stbtt_PackEnd(&packctx);
-	
-	u8* rgbmap = UI_ConvertSingleChannelToRGBA(&arena, temp_bitmap, 512, 512);
-	
-	R_Texture2DAlloc(&fontinfo->font_texture, TextureFormat_RGBA, 512, 512, TextureResize_Linear, TextureResize_Linear, TextureWrap_Repeat, TextureWrap_Repeat, TextureMutability_Immutable, TextureUsage_ShaderResource, rgbmap);
-	
-	fontinfo->scale = stbtt_ScaleForPixelHeight(&finfo, size);
-	stbtt_GetFontVMetrics(&finfo, &fontinfo->ascent, &fontinfo->descent, nullptr);
+	stbtt_InitFont(&fontinfo->face, buffer, 0);
+	fontinfo->scale = stbtt_ScaleForPixelHeight(&fontinfo->face, size);
+	stbtt_GetFontVMetrics(&fontinfo->face, &fontinfo->ascent, &fontinfo->descent, nullptr);
 	fontinfo->baseline = (i32) (fontinfo->ascent * fontinfo->scale);
 	fontinfo->font_size = size;
 	
-	arena_free(&arena);
+	stable_table_init(UI_GlyphKey, UI_Glyph, &fontinfo->glyphs, 512);
+	stable_table_init(UI_TextRunKey, UI_TextRun, &fontinfo->runs, 1024);
+	pool_init(&fontinfo->glyph_chunks, sizeof(UI_TextGlyphChunk));
 }
 
 f32 UI_GetStringSize(UI_FontInfo* fontinfo, string str) {
-    f32 sz = 0.f;
-    for (u32 i = 0; i < str.size; i++) {
-        if (str.str[i] >= 32 && str.str[i] < 128) {
-            stbtt_packedchar* info = &fontinfo->cdata[str.str[i] - 32];
-            sz += info->xadvance;
-        }
-    }
-    return sz;
+	f32 sz = 0.f;
+	for (u64 i = 0; i < str.size;) {
+		str_decode decode = str_decode_utf8(str.str + i, str.size - i);
+		i += decode.size;
+		if (decode.codepoint < 32) continue;
+		sz += UI_GlyphGet(fontinfo, decode.codepoint, fontinfo->font_size)->advance;
+	}
+	return sz;
 }
 
 void UI_FreeFont(UI_FontInfo* fontinfo) {
-	R_Texture2DFree(&fontinfo->font_texture);
+	for (u32 i = 0; i < fontinfo->page_count; i++)
+		R_Texture2DFree(&fontinfo->pages[i].texture);
+	stable_table_free(UI_GlyphKey, UI_Glyph, &fontinfo->glyphs);
+	stable_table_foreach(UI_TextRunKey, UI_TextRun, &fontinfo->runs, curr) {
+		M_Free(curr->key.str.str);
+	}
+	stable_table_free(UI_TextRunKey, UI_TextRun, &fontinfo->runs);
+	pool_free(&fontinfo->glyph_chunks);
+	arena_free(&fontinfo->arena);
+}
+
+//- Text Run Cache 
+
+// NOTE(voxel): 0 is what an empty slot in the stable table looks like
+static u64 UI_TextRunHash(string str) {
+	u64 hash = str_hash_64(str);
+	return hash ? hash : 1;
+}
+
+static void UI_TextRunFreeGlyphs(UI_FontInfo* fontinfo, UI_TextRun* run) {
+	UI_TextGlyphChunk* chunk = run->first_chunk;
+	while (chunk) {
+		UI_TextGlyphChunk* next = chunk->next;
+		pool_dealloc(&fontinfo->glyph_chunks, chunk);
+		chunk = next;
+	}
+	run->first_chunk = nullptr;
+}
+
+static void UI_TextRunBuild(UI_FontInfo* fontinfo, UI_TextRun* run, string str) {
+	UI_TextGlyphChunk* last_chunk = nullptr;
+	f32 pen_x = 0.f;
+	
+	for (u64 i = 0; i < str.size;) {
+		str_decode decode = str_decode_utf8(str.str + i, str.size - i);
+		i += decode.size;
+		if (decode.codepoint < 32) continue;
+		
+		UI_Glyph* glyph = UI_GlyphGet(fontinfo, decode.codepoint, fontinfo->font_size);
+		if (glyph->page != UI_GLYPH_NO_PAGE) {
+			if (!last_chunk || last_chunk->count == UI_TEXT_RUN_CHUNK_GLYPHS) {
+				UI_TextGlyphChunk* chunk = pool_alloc(&fontinfo->glyph_chunks);
+				chunk->next = nullptr;
+				chunk->count = 0;
+				if (last_chunk) last_chunk->next = chunk;
+				else run->first_chunk = chunk;
+				last_chunk = chunk;
+			}
+			
+			UI_TextGlyph* run_glyph = &last_chunk->glyphs[last_chunk->count++];
+			run_glyph->offset = glyph->offset;
+			run_glyph->offset.x += pen_x;
+			run_glyph->uvs = glyph->uvs;
+			run_glyph->page = glyph->page;
+			run->page_mask |= 1u << glyph->page;
+		}
+		pen_x += glyph->advance;
+	}
+	
+	run->width = pen_x;
+}
+
+// Evicts runs that are too old, or that use any of the pages in page_mask
+static void UI_TextRunEvict(UI_FontInfo* fontinfo, u64 frame_index, u32 page_mask) {
+	stable_table_foreach(UI_TextRunKey, UI_TextRun, &fontinfo->runs, curr) {
+		if (curr->last_frame_touched_index + UI_TEXT_RUN_MAX_AGE > frame_index &&
+			!(curr->page_mask & page_mask)) continue;
+		
+		UI_TextRunFreeGlyphs(fontinfo, curr);
+		UI_TextRunKey key = curr->key;
+		stable_table_del(UI_TextRunKey, UI_TextRun, &fontinfo->runs, key);
+		M_Free(key.str.str);
+	}
+}
+
+UI_TextRun* UI_TextRunGet(UI_FontInfo* fontinfo, string str, u64 frame_index) {
+	fontinfo->current_frame_index = frame_index;
+	if (frame_index >= fontinfo->last_prune_frame_index + UI_TEXT_RUN_PRUNE_INTERVAL) {
+		UI_TextRunEvict(fontinfo, frame_index, 0);
+		fontinfo->last_prune_frame_index = frame_index;
+	}
+	
+	UI_TextRunKey key = { UI_TextRunHash(str), str };
+	
+	UI_TextRun* run = nullptr;
+	if (!stable_table_get(UI_TextRunKey, UI_TextRun, &fontinfo->runs, key, &run)) {
+		// Building can empty a glyph page, which evicts runs, so this one goes in after
+		UI_TextRun built = {0};
+		UI_TextRunBuild(fontinfo, &built, str);
+		stable_table_get_guarantee(UI_TextRunKey, UI_TextRun, &fontinfo->runs, key, &run);
+		// str is usually in a frame arena, the run keeps its own copy to compare against
+		u8* text = M_Alloc(str.size);
+		MemoryCopy(text, str.str, str.size);
+		run->key.str = (string) { text, str.size };
+		run->width = built.width;
+		run->page_mask = built.page_mask;
+		run->first_chunk = built.first_chunk;
+	}
+	
+	// Keeps the pages this run draws from off the eviction list
+	for (u32 i = 0; i < fontinfo->page_count; i++) {
+		if (run->page_mask & (1u << i))
+			fontinfo->pages[i].last_used_frame_index = frame_index;
+	}
+	
+	run->last_frame_touched_index = frame_index;
+	return run;
+}
+
+//- Glyph Atlas 
+
+static void UI_GlyphPageCreate(UI_FontInfo* fontinfo) {
+	UI_GlyphPage* page = &fontinfo->pages[fontinfo->page_count];
+	MemoryZeroStruct(page, UI_GlyphPage);
+	// Nothing is ever sampled outside of an uploaded glyph and its padding, so the page
+	// doesn't need clearing
+	R_Texture2DAlloc(&page->texture, TextureFormat_RGBA, UI_GLYPH_PAGE_SIZE, UI_GLYPH_PAGE_SIZE,
+					 TextureResize_Linear, TextureResize_Linear, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge,
+					 TextureMutability_Uncommon, TextureUsage_ShaderResource, nullptr);
+	page->last_used_frame_index = fontinfo->current_frame_index;
+	fontinfo->current_page = fontinfo->page_count++;
+}
+
+// Drops every glyph and run on the page so it can be packed from scratch
+static void UI_GlyphPageEmpty(UI_FontInfo* fontinfo, u32 page_index) {
+	stable_table_foreach(UI_GlyphKey, UI_Glyph, &fontinfo->glyphs, curr) {
+		if (curr->page == page_index)
+			stable_table_del(UI_GlyphKey, UI_Glyph, &fontinfo->glyphs, curr->key);
+	}
+	UI_TextRunEvict(fontinfo, 0, 1u << page_index);
+	
+	UI_GlyphPage* page = &fontinfo->pages[page_index];
+	page->cursor_x = 0;
+	page->cursor_y = 0;
+	page->row_height = 0;
+	page->last_used_frame_index = fontinfo->current_frame_index;
+	fontinfo->current_page = page_index;
+}
+
+// Rows of glyphs left to right, a new row starts when the current one runs out of width
+static b8 UI_GlyphPagePack(UI_GlyphPage* page, u32 width, u32 height, u32* x, u32* y) {
+	if (page->cursor_x + width > UI_GLYPH_PAGE_SIZE) {
+		page->cursor_x = 0;
+		page->cursor_y += page->row_height;
+		page->row_height = 0;
+	}
+	if (width > UI_GLYPH_PAGE_SIZE || page->cursor_y + height > UI_GLYPH_PAGE_SIZE)
+		return false;
+	
+	*x = page->cursor_x;
+	*y = page->cursor_y;
+	page->cursor_x += width;
+	page->row_height = Max(page->row_height, height);
+	return true;
+}
+
+static b8 UI_GlyphAllocate(UI_FontInfo* fontinfo, u32 width, u32 height, u32* page_index, u32* x, u32* y) {
+	if (width > UI_GLYPH_PAGE_SIZE || height > UI_GLYPH_PAGE_SIZE) return false;
+	
+	if (fontinfo->page_count &&
+		UI_GlyphPagePack(&fontinfo->pages[fontinfo->current_page], width, height, x, y)) {
+		*page_index = fontinfo->current_page;
+		return true;
+	}
+	
+	if (fontinfo->page_count < UI_GLYPH_MAX_PAGES) {
+		UI_GlyphPageCreate(fontinfo);
+	} else {
+		// Pages drawn from this frame already have quads pointing into them
+		u32 lru = UI_GLYPH_NO_PAGE;
+		for (u32 i = 0; i < fontinfo->page_count; i++) {
+			if (fontinfo->pages[i].last_used_frame_index >= fontinfo->current_frame_index) continue;
+			if (lru == UI_GLYPH_NO_PAGE || fontinfo->pages[i].last_used_frame_index < fontinfo->pages[lru].last_used_frame_index)
+				lru = i;
+		}
+		if (lru == UI_GLYPH_NO_PAGE) return false;
+		UI_GlyphPageEmpty(fontinfo, lru);
+	}
+	
+	*page_index = fontinfo->current_page;
+	return UI_GlyphPagePack(&fontinfo->pages[fontinfo->current_page], width, height, x, y);
+}
+
+static void UI_GlyphRasterize(UI_FontInfo* fontinfo, UI_Glyph* glyph, u32 codepoint, f32 size) {
+	f32 scale = stbtt_ScaleForPixelHeight(&fontinfo->face, size);
+	i32 glyph_index = stbtt_FindGlyphIndex(&fontinfo->face, codepoint);
+	i32 advance, left_side_bearing;
+	stbtt_GetGlyphHMetrics(&fontinfo->face, glyph_index, &advance, &left_side_bearing);
+	i32 x0, y0, x1, y1;
+	stbtt_GetGlyphBitmapBox(&fontinfo->face, glyph_index, scale, scale, &x0, &y0, &x1, &y1);
+	u32 width = x1 - x0;
+	u32 height = y1 - y0;
+	
+	glyph->page = UI_GLYPH_NO_PAGE;
+	glyph->offset = (rect) { x0, y0, width, height };
+	glyph->advance = advance * scale;
+	if (!width || !height) return;
+	
+	// The padding goes up with the glyph, so filtering at the edges only ever sees zeroes
+	u32 padded_width = width + UI_GLYPH_PADDING * 2;
+	u32 padded_height = height + UI_GLYPH_PADDING * 2;
+	u32 page_index, x, y;
+	if (!UI_GlyphAllocate(fontinfo, padded_width, padded_height, &page_index, &x, &y)) {
+		LogError("[UI] No room in the glyph atlas for codepoint %u at size %.1f", codepoint, size);
+		return;
+	}
+	
+	M_ArenaTemp temp = arena_begin_temp(&fontinfo->arena);
+	u8* bitmap = arena_alloc_zero(&fontinfo->arena, padded_width * padded_height);
+	stbtt_MakeGlyphBitmap(&fontinfo->face, bitmap + UI_GLYPH_PADDING * padded_width + UI_GLYPH_PADDING,
+						  width, height, padded_width, scale, scale, glyph_index);
+	u8* rgbmap = UI_ConvertSingleChannelToRGBA(&fontinfo->arena, bitmap, padded_width, padded_height);
+	R_Texture2DSubData(&fontinfo->pages[page_index].texture, x, y, padded_width, padded_height, rgbmap);
+	arena_end_temp(temp);
+	
+	glyph->page = page_index;
+	glyph->uvs = (rect) {
+		(f32) (x + UI_GLYPH_PADDING) / UI_GLYPH_PAGE_SIZE,
+		(f32) (y + UI_GLYPH_PADDING) / UI_GLYPH_PAGE_SIZE,
+		(f32) width / UI_GLYPH_PAGE_SIZE,
+		(f32) height / UI_GLYPH_PAGE_SIZE,
+	};
+}
+
+UI_Glyph* UI_GlyphGet(UI_FontInfo* fontinfo, u32 codepoint, f32 size) {
+	// Size in 1/64ths of a pixel up top, codepoint below. Never null since size > 0
+	UI_GlyphKey key = { ((u64) (size * 64.f) << 32) | codepoint };
+	
+	UI_Glyph* glyph = nullptr;
+	if (!stable_table_get(UI_GlyphKey, UI_Glyph, &fontinfo->glyphs, key, &glyph)) {
+		// Rasterizing can empty a page, which deletes glyphs and may move entries around
+		UI_Glyph rasterized = {0};
+		UI_GlyphRasterize(fontinfo, &rasterized, codepoint, size);
+		stable_table_get_guarantee(UI_GlyphKey, UI_Glyph, &fontinfo->glyphs, key, &glyph);
+		glyph->page = rasterized.page;
+		glyph->uvs = rasterized.uvs;
+		glyph->offset = rasterized.offset;
+		glyph->advance = rasterized.advance;
+	}
+	
+	if (glyph->page != UI_GLYPH_NO_PAGE)
+		fontinfo->pages[glyph->page].last_used_frame_index = fontinfo->current_frame_index;
+	return glyph;
 }
 
 //- UI Caching Helpers 
@@ -100,9 +342,10 @@ static u64 UI_KeyHashID(UI_Key a) { return a.id; }
 StableTable_Impl(UI_Key, UI_Box, UI_KeyIsNull, UI_KeyEquals, UI_KeyHashID);
 
 UI_Box* UI_BoxMake(UI_Cache* ui_cache, UI_BoxFlags flags, string str) {
+	ui_cache->box_count++;
 	if (str.size == 0) {
 		// If this is an ID-less Box, allocate it on the Frame Arena
-		UI_Box* to_ret = arena_alloc(U_GetFrameArena(), sizeof(UI_Box));
+		UI_Box* to_ret = arena_alloc_zero(U_GetFrameArena(), sizeof(UI_Box));
 		
 		UI_Box* parent = UI_ParentPeek(ui_cache);
 		to_ret->parent = parent;
@@ -139,6 +382,7 @@ UI_Box* UI_BoxMake(UI_Cache* ui_cache, UI_BoxFlags flags, string str) {
 	UI_Box* to_ret = nullptr;
 	if (stable_table_get(UI_Key, UI_Box, &ui_cache->cache, key, &to_ret)) {
 		to_ret->last_frame_touched_index = ui_cache->current_frame_index;
+		to_ret->custom_render_hash = 0;
 		
 		if (ui_cache->parent_stack.len != 0) {
 			// setting up box parent based on stack state
@@ -214,12 +458,8 @@ UI_Box* UI_BoxMake(UI_Cache* ui_cache, UI_BoxFlags flags, string str) {
 UI_Box* UI_BoxMakeF(UI_Cache* ui_cache, UI_BoxFlags flags, const char* fmt, ...) {
 	va_list args;
 	va_start(args, fmt);
-	const char buf[8092];
-	vsnprintf(buf, 8092, fmt, args);
+	string s = str_from_formatv(U_GetFrameArena(), fmt, args);
 	va_end(args);
-	u64 size = strlen(buf);
-	string s = str_alloc(U_GetFrameArena(), size);
-	memmove(s.str, buf, size);
 	return UI_BoxMake(ui_cache, flags, s);
 }
 
@@ -261,30 +501,14 @@ UI_QuadVec4ColorSet UI_ColorSetLerp(UI_QuadVec4ColorSet* a, UI_QuadVec4ColorSet*
 	};
 }
 
-static b8 UI_RecurseCheckChildrenMouseTest(UI_Box* box) {
-	if (box->flags & BoxFlag_Clickable &&
-		rect_contains_point(box->bounds, v2(OS_InputGetMouseX(), OS_InputGetMouseY())))
-		return true;
-	UI_Box* curr = box->first;
-	while (curr) {
-		if (UI_RecurseCheckChildrenMouseTest(curr)) return true;
-		curr = curr->next;
-	}
-	return false;
-}
-
 UI_Signal UI_SignalFromBox(UI_Box* box) {
 	UI_Signal ret = {0};
-	if (!rect_contains_point(box->clipped_bounds, v2(OS_InputGetMouseX(), OS_InputGetMouseY())))
+	// Keyless boxes aren't hit tested and their frame indices both stay 0
+	if (UI_KeyIsNull(box->key)) return ret;
+	// Decided by the hit test at the end of the previous frame
+	if (box->hover_frame_index != box->last_frame_touched_index)
 		return ret;
 	
-	UI_Box* curr = box->first;
-	while (curr) {
-		if (UI_RecurseCheckChildrenMouseTest(curr))
-			return ret;
-		curr = curr->next;
-	}
-	
 	ret.hovering = true;
 	if (box->flags & BoxFlag_Clickable) {
 		ret.pressed  = (b8) OS_InputButtonPressed(Input_MouseButton_Left);
@@ -308,30 +532,35 @@ UI_Signal UI_SignalFromBox(UI_Box* box) {
 
 //~ UI Rendering Layer
 
+#define UI_ANIMATION_SETTLE_T 0.002f
+#define UI_ANIMATION_SETTLE_PIXELS 0.01f
+
 static void UI_InitializeRenderer(OS_Window* window, UI_Cache* ui_cache) {
 	arena_init(&ui_cache->arena);
 	
-	// TODO(voxel): Change input rate of a few of these attributes for saving vram
-	u32 attrib_count = 7;
+	u32 attrib_count = 9;
 	R_Attribute* attributes = arena_alloc(&ui_cache->arena, sizeof(R_Attribute) * attrib_count);
 	attributes[0] = (R_Attribute) { str_lit("BoxSize"),                     AttributeType_Float2 },
 	attributes[1] = (R_Attribute) { str_lit("BoxCenter"),                   AttributeType_Float2 },
-	attributes[2] = (R_Attribute) { str_lit("TexCoord"),                    AttributeType_Float2 },
-	attributes[3] = (R_Attribute) { str_lit("TexIndex"),                    AttributeType_Float1 },
-	attributes[4] = (R_Attribute) { str_lit("Color"),                       AttributeType_Float4 },
-	attributes[5] = (R_Attribute) { str_lit("ClipQuad"),                    AttributeType_Float4 },
-	attributes[6] = (R_Attribute) { str_lit("RoundingSoftnessAndEdgeSize"), AttributeType_Float3 },
+	attributes[2] = (R_Attribute) { str_lit("TexRect"),                     AttributeType_Float4 },
+	attributes[3] = (R_Attribute) { str_lit("ColorTL"),                     AttributeType_UByte4Norm },
+	attributes[4] = (R_Attribute) { str_lit("ColorTR"),                     AttributeType_UByte4Norm },
+	attributes[5] = (R_Attribute) { str_lit("ColorBR"),                     AttributeType_UByte4Norm },
+	attributes[6] = (R_Attribute) { str_lit("ColorBL"),                     AttributeType_UByte4Norm },
+	attributes[7] = (R_Attribute) { str_lit("RoundingSoftnessAndEdgeSize"), AttributeType_Float3 },
+	attributes[8] = (R_Attribute) { str_lit("TexAndClipIndex"),             AttributeType_UShort2 },
 	
 	R_ShaderPackAllocLoad(&ui_cache->shaderpack, str_lit("res/shaders/ui"));
 	R_PipelineAlloc(&ui_cache->pipeline, InputAssembly_Triangles, attributes, attrib_count,
 					&ui_cache->shaderpack, BlendMode_Alpha);
 	
-	R_BufferAlloc(&ui_cache->gpu_side_buffer, BufferFlag_Dynamic | BufferFlag_Type_Vertex, sizeof(UI_Vertex));
-	R_BufferData(&ui_cache->gpu_side_buffer, MAX_UI_QUADS * 6 * sizeof(UI_Vertex), nullptr);
+	R_BufferAlloc(&ui_cache->gpu_side_buffer, BufferFlag_Dynamic | BufferFlag_Type_Vertex | BufferFlag_PerInstance, sizeof(UI_Instance));
+	R_BufferData(&ui_cache->gpu_side_buffer, MAX_UI_QUADS * sizeof(UI_Instance), nullptr);
 	R_PipelineAddBuffer(&ui_cache->pipeline, &ui_cache->gpu_side_buffer, attrib_count);
 	
 	string_array ActualConstants_var_names = {0};
 	string_array_add(&ActualConstants_var_names, str_lit("u_projection"));
+	string_array_add(&ActualConstants_var_names, str_lit("u_clip_rects"));
 	R_UniformBufferAlloc(&ui_cache->constants, str_lit("ActualConstants"), ActualConstants_var_names,
 						 &ui_cache->shaderpack, ShaderType_Vertex);
 	string_array_free(&ActualConstants_var_names);
@@ -360,15 +589,31 @@ static void UI_FreeRenderer(UI_Cache* ui_cache) {
 static void UI_BeginRendererFrame(UI_Cache* ui_cache) {
 	ui_cache->quad_count = 0;
 	ui_cache->textures_count = 0;
+	ui_cache->clip_rect_count = 0;
 }
 
 static void UI_EndRendererFrame(UI_Cache* ui_cache) {
+	if (!ui_cache->quad_count) return;
+	ui_cache->batch_count++;
+	
 	for (u32 i = 0; i < ui_cache->textures_count; i++) {
 		R_Texture2DBindTo(&ui_cache->textures[i], i);
 	}
+	R_UniformBufferSetVec4Array(&ui_cache->constants, str_lit("u_clip_rects"), ui_cache->clip_rects, ui_cache->clip_rect_count);
 	R_PipelineBind(&ui_cache->pipeline);
-	R_BufferUpdate(&ui_cache->gpu_side_buffer, 0, ui_cache->quad_count * 6 * sizeof(UI_Vertex), ui_cache->cpu_side_buffer); 
-	R_Draw(&ui_cache->pipeline, 0, ui_cache->quad_count * 6);
+	R_BufferUpdate(&ui_cache->gpu_side_buffer, 0, ui_cache->quad_count * sizeof(UI_Instance), ui_cache->cpu_side_buffer); 
+	R_DrawInstanced(&ui_cache->pipeline, 0, 6, ui_cache->quad_count);
+}
+
+// The instances, clip rects and textures of the last batch are all still in place
+static void UI_RedrawRetained(UI_Cache* ui_cache) {
+	if (!ui_cache->quad_count) return;
+	
+	for (u32 i = 0; i < ui_cache->textures_count; i++) {
+		R_Texture2DBindTo(&ui_cache->textures[i], i);
+	}
+	R_PipelineBind(&ui_cache->pipeline);
+	R_DrawInstanced(&ui_cache->pipeline, 0, 6, ui_cache->quad_count);
 }
 
 static i32 UI_GetTextureIndex(UI_Cache* ui_cache, R_Texture2D* texture) {
@@ -380,44 +625,67 @@ static i32 UI_GetTextureIndex(UI_Cache* ui_cache, R_Texture2D* texture) {
 	return ui_cache->textures_count++;
 }
 
+static u32 UI_PackColor(vec4 color) {
+	u32 r = (u32) (Clamp(0.f, color.x, 1.f) * 255.f + 0.5f);
+	u32 g = (u32) (Clamp(0.f, color.y, 1.f) * 255.f + 0.5f);
+	u32 b = (u32) (Clamp(0.f, color.z, 1.f) * 255.f + 0.5f);
+	u32 a = (u32) (Clamp(0.f, color.w, 1.f) * 255.f + 0.5f);
+	return r | (g << 8) | (b << 16) | (a << 24);
+}
+
 void UI_PushQuad(UI_Cache* ui_cache, rect bounds, rect uvs, R_Texture2D* texture, UI_QuadVec4ColorSet colors, f32 rounding, f32 softness, f32 edge_size) {
-	if (ui_cache->quad_count == MAX_UI_QUADS || ui_cache->textures_count == 8) {
+	// Consecutive quads almost always share the clip rect, so only the last one is checked
+	rect clip = UI_ClippingRectPeek(ui_cache);
+	vec4 clipping_quad = v4(clip.x, clip.y, clip.w, clip.h);
+	b8 new_clip_rect = !ui_cache->clip_rect_count ||
+		memcmp(&ui_cache->clip_rects[ui_cache->clip_rect_count - 1], &clipping_quad, sizeof(vec4)) != 0;
+	
+	if (ui_cache->quad_count == MAX_UI_QUADS || ui_cache->textures_count == 8 ||
+		(new_clip_rect && ui_cache->clip_rect_count == UI_MAX_CLIP_RECTS)) {
 		UI_EndRendererFrame(ui_cache);
 		UI_BeginRendererFrame(ui_cache);
+		new_clip_rect = true;
+	}
+	if (new_clip_rect) {
+		ui_cache->clip_rects[ui_cache->clip_rect_count++] = clipping_quad;
 	}
 	
-	rect clipping_quad = UI_ClippingRectPeek(ui_cache);
 	i32 tex_idx = UI_GetTextureIndex(ui_cache, texture);
-	vec2 size = (vec2) { bounds.w, bounds.h };
-	vec2 center = (vec2) { bounds.x + bounds.w/2.f, bounds.y + bounds.h/2.f };
-	vec2 uv_vertices[] = {
-		v2(uvs.x, uvs.y),
-		v2(uvs.x + uvs.w, uvs.y),
-		v2(uvs.x + uvs.w, uvs.y + uvs.h),
-		v2(uvs.x, uvs.y),
-		v2(uvs.x + uvs.w, uvs.y + uvs.h),
-		v2(uvs.x, uvs.y + uvs.h),
+	ui_cache->cpu_side_buffer[ui_cache->quad_count] = (UI_Instance) {
+		.box_size = (vec2) { bounds.w, bounds.h },
+		.box_center = (vec2) { bounds.x + bounds.w/2.f, bounds.y + bounds.h/2.f },
+		.uvs = uvs,
+		.colors = {
+			UI_PackColor(colors.tl), UI_PackColor(colors.tr),
+			UI_PackColor(colors.br), UI_PackColor(colors.bl),
+		},
+		.rounding_softness_and_edge_size = v3(rounding, softness, edge_size),
+		.tex_idx = (u16) tex_idx,
+		.clip_idx = (u16) (ui_cache->clip_rect_count - 1),
 	};
-	vec4 vertex_colors[] = {
-		colors.tl,
-		colors.tr,
-		colors.br,
-		colors.tl,
-		colors.br,
-		colors.bl,
-	};
-	for (u32 i = 0; i < 6; i++) {
-		ui_cache->cpu_side_buffer[ui_cache->quad_count * 6 + i] = (UI_Vertex) {
-			size, center, uv_vertices[i], tex_idx, vertex_colors[i], *((vec4*)&clipping_quad),
-			v3(rounding, softness, edge_size)
-		};
-	}
 	
 	ui_cache->quad_count++;
 }
 
 #define UI_Vec4ColorSetUniform(color) ((UI_QuadVec4ColorSet) { color, color, color, color })
 
+// Centered horizontally, y_offset is from the vertical center to the baseline
+static void UI_PushText(UI_Cache* ui_cache, UI_Box* box, f32 y_offset) {
+	UI_TextRun* run = UI_TextRunGet(box->font, box->identifier, ui_cache->current_frame_index);
+	vec2 pos = v2(box->bounds.x + (box->bounds.w / 2.f), box->bounds.y + (box->bounds.h / 2.f));
+	pos.x -= run->width / 2.f;
+	pos.y += y_offset;
+	UI_QuadVec4ColorSet colors = UI_Vec4ColorSetUniform(color_code_to_vec4(box->text_color));
+	
+	for (UI_TextGlyphChunk* chunk = run->first_chunk; chunk; chunk = chunk->next) {
+		for (u32 i = 0; i < chunk->count; i++) {
+			UI_TextGlyph* glyph = &chunk->glyphs[i];
+			rect loc = { pos.x + glyph->offset.x, pos.y + glyph->offset.y, glyph->offset.w, glyph->offset.h };
+			UI_PushQuad(ui_cache, loc, glyph->uvs, &box->font->pages[glyph->page].texture, colors, 0.f, 0.f, 0.f);
+		}
+	}
+}
+
 static void UI_PushBox(UI_Cache* ui_cache, UI_Box* box) {
 	if (box->flags & BoxFlag_CustomRenderer) {
 		box->custom_render(ui_cache, box);
@@ -448,27 +716,7 @@ static void UI_PushBox(UI_Cache* ui_cache, UI_Box* box) {
 	}
 	
 	if (box->flags & BoxFlag_DrawText) {
-		f32 string_size = UI_GetStringSize(box->font, box->identifier);
-		vec2 pos = v2(box->bounds.x + (box->bounds.w / 2.f), box->bounds.y + (box->bounds.h / 2.f));
-		pos.x -= string_size / 2.f;
-		pos.y += box->font->baseline / 2.f;
-		vec4 vcolor = color_code_to_vec4(box->text_color);
-		
-		for (u32 i = 0; i < box->identifier.size; i++) {
-			if (box->identifier.str[i] >= 32 && box->identifier.str[i] < 128) {
-				stbtt_packedchar* info = &box->font->cdata[box->identifier.str[i] - 32];
-				rect uvs = {
-					info->x0 / 512.f,
-					info->y0 / 512.f,
-					(info->x1 - info->x0) / 512.f,
-					(info->y1 - info->y0) / 512.f
-				};
-				rect loc = { pos.x + info->xoff, pos.y + info->yoff, info->x1 - info->x0, info->y1 - info->y0 };
-				UI_PushQuad(ui_cache, loc, uvs, &box->font->font_texture,
-							UI_Vec4ColorSetUniform(vcolor), 0.f, 0.f, 0.f);
-				pos.x += info->xadvance;
-			}
-		}
+		UI_PushText(ui_cache, box, box->font->baseline / 2.f);
 	}
 	
 	if (box->flags & BoxFlag_DrawBorder) {
@@ -480,9 +728,14 @@ static void UI_PushBox(UI_Cache* ui_cache, UI_Box* box) {
 	}
 }
 
-//- Layouting Helpers TODO(voxel): @rework replace recursives with queue/stack 
-//                                 Callstack size may become an issue
-static void UI_LayoutRecurseForward(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
+//- Layouting Helpers
+
+// NOTE(voxel): Every pass reads boxes scattered around the cache's pool, so passes that can
+// share a sweep do. Flattening goes with the sizes that only need the parent, both axes of
+// the sizes that need the children go together, and placing children goes with bounds
+
+// Sizes that only depend on the box itself or its parent
+static void UI_LayoutSizeFromParent(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
 	f32 edge_correction_factor = box->parent ?
 		box->parent->edge_size + (box->parent->edge_size)*0.25 : 0;
 	
@@ -490,7 +743,7 @@ static void UI_LayoutRecurseForward(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
 		box->computed_size[axis] = box->semantic_size[axis].value;
 	} else if (box->semantic_size[axis].kind == SizeKind_TextContent) {
 		if (axis == axis2_x) {
-			box->computed_size[axis] = UI_GetStringSize(box->font, box->identifier) + box->semantic_size[axis].value * 2;
+			box->computed_size[axis] = UI_TextRunGet(box->font, box->identifier, ui_cache->current_frame_index)->width + box->semantic_size[axis].value * 2;
 		} else {
 			box->computed_size[axis] = box->font->font_size + box->semantic_size[axis].value * 2;
 		}
@@ -498,99 +751,192 @@ static void UI_LayoutRecurseForward(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
 		box->computed_size[axis] = (box->parent->computed_size[axis] - edge_correction_factor*2) * 
 			box->semantic_size[axis].value / 100.f;
 	}
-	
-	UI_Box* curr = box->first;
-	while (curr) {
-		UI_LayoutRecurseForward(ui_cache, curr, axis);
-		curr = curr->next;
-	}
 }
 
-static b8 UI_StateRecurseCheckHotAndActive(UI_Cache* ui_cache, UI_Box* box) {
-	UI_Box* curr = box->first;
-	while (curr) {
-		if (UI_StateRecurseCheckHotAndActive(ui_cache, curr)) return true;
-		curr = curr->next;
+// Pre-order walk over the first/next/parent links, no recursion and no stack
+static void UI_LayoutFlatten(UI_Cache* ui_cache) {
+	ui_cache->layout_nodes = arena_alloc(U_GetFrameArena(), ui_cache->box_count * sizeof(UI_LayoutNode));
+	UI_LayoutNode* nodes = ui_cache->layout_nodes;
+	u32 count = 0;
+	u32 parent = 0;
+	u32 prev_sibling = 0;
+	UI_Box* box = ui_cache->root;
+	// The count check only matters if an id got used twice and tangled the links
+	while (box && count < ui_cache->box_count) {
+		u32 index = count++;
+		nodes[index] = (UI_LayoutNode) { .box = box, .parent = parent };
+		if (prev_sibling) nodes[prev_sibling].next_sibling = index;
+		else if (index) nodes[parent].first_child = index;
+		
+		UI_LayoutSizeFromParent(ui_cache, box, axis2_x);
+		UI_LayoutSizeFromParent(ui_cache, box, axis2_y);
+		
+		if (box->first) {
+			parent = index;
+			prev_sibling = 0;
+			box = box->first;
+			continue;
+		}
+		
+		// Climb until there's a next sibling to go to
+		while (box != ui_cache->root && !box->next) {
+			box = box->parent;
+			index = nodes[index].parent;
+		}
+		if (box == ui_cache->root) break;
+		box = box->next;
+		prev_sibling = index;
+		parent = nodes[index].parent;
 	}
-	
-	if (!box->parent || UI_KeyIsNull(box->key)) return false;
-	if (rect_contains_point(box->clipped_bounds, v2(OS_InputGetMouseX(), OS_InputGetMouseY()))) {
-		if (OS_InputButton(Input_MouseButton_Left)) {
-			ui_cache->hot_key = (UI_Key) {0};
-			ui_cache->active_key = box->key;
-		} else {
-			ui_cache->hot_key = box->key;
-			ui_cache->active_key = (UI_Key) {0};
+	ui_cache->layout_node_count = count;
+}
+
+// Sizes that depend on the children
+static void UI_LayoutSizesFromChildren(UI_Cache* ui_cache) {
+	UI_LayoutNode* nodes = ui_cache->layout_nodes;
+	for (u32 i = ui_cache->layout_node_count; i-- > 0;) {
+		UI_Box* box = nodes[i].box;
+		f32 size[axis2_count] = {0};
+		for (u32 c = nodes[i].first_child; c; c = nodes[c].next_sibling) {
+			size[axis2_x] += nodes[c].box->computed_size[axis2_x];
+			size[axis2_y] += nodes[c].box->computed_size[axis2_y];
 		}
-		return true;
+		for (u32 axis = axis2_x; axis < axis2_count; axis++) {
+			if (box->semantic_size[axis].kind == SizeKind_ChildrenSum) {
+				box->computed_size[axis] = size[axis];
+			}
+		}
+		box->content_size = size[box->layout_axis];
 	}
-	return false;
 }
 
-static void UI_LayoutRecurseBackward(UI_Cache* ui_cache, UI_Box* box, u32 axis) {
-	UI_Box* curr = box->first;
-	f32 size = 0.f;
-	while (curr) {
-		UI_LayoutRecurseBackward(ui_cache, curr, axis);
-		size += curr->computed_size[axis];
+// Leaves don't store subtree_bounds, it would just be a copy of clipped_bounds
+static inline rect UI_BoxSubtreeBounds(UI_Box* box) {
+	return box->first ? box->subtree_bounds : box->clipped_bounds;
+}
+
+// NOTE(voxel): Anything inside a scroll view snaps to its place. Rows of a list come and
+// go while scrolling, and animating only the ones that stayed looks broken
+static void UI_LayoutPlace(UI_Cache* ui_cache) {
+	UI_LayoutNode* nodes = ui_cache->layout_nodes;
+	for (u32 i = 0; i < ui_cache->layout_node_count; i++) {
+		UI_LayoutNode* node = &nodes[i];
+		UI_Box* box = node->box;
+		UI_Box* parent = i ? nodes[node->parent].box : nullptr;
+		b8 snap = i ? nodes[node->parent].snap_children : false;
 		
-		curr = curr->next;
+		box->target_bounds.x = (parent ? parent->target_bounds.x : 0.f) + box->computed_rel_position[axis2_x];
+		box->target_bounds.y = (parent ? parent->target_bounds.y : 0.f) + box->computed_rel_position[axis2_y];
+		box->target_bounds.w = box->computed_size[axis2_x];
+		box->target_bounds.h = box->computed_size[axis2_y];
+		if (snap) {
+			box->bounds = box->target_bounds;
+			box->direct_set = false;
+		}
+		
+		rect clippable_bounds = box->bounds;
+		if (box->flags & BoxFlag_DrawBorder) {
+			f32 edge_correction_factor = box->parent ? (box->parent->edge_size)*0.25 : 0;
+			clippable_bounds.x += box->edge_size + edge_correction_factor;
+			clippable_bounds.y += box->edge_size + edge_correction_factor;
+			clippable_bounds.w -= box->edge_size * 2 + edge_correction_factor;
+			clippable_bounds.h -= box->edge_size * 2 + edge_correction_factor;
+		}
+		
+		rect clipping_quad = i ? nodes[node->parent].child_clip : UI_ClippingRectPeek(ui_cache);
+		box->clipped_bounds = rect_get_overlap(clippable_bounds, clipping_quad);
+		
+		node->child_clip = (box->flags & BoxFlag_Clip) ? box->clipped_bounds : clipping_quad;
+		node->snap_children = snap || (box->flags & BoxFlag_ViewScroll);
+		node->subtree_min = v2(box->clipped_bounds.x, box->clipped_bounds.y);
+		node->subtree_max = v2(box->clipped_bounds.x + box->clipped_bounds.w, box->clipped_bounds.y + box->clipped_bounds.h);
+		
+		// Children get placed one after the other along the layout axis
+		f32 edge_correction_factor = box->parent ? (box->parent->edge_size)*0.25 : 0;
+		f32 child_edge_correction_factor = (box->edge_size)*0.25;
+		f32 child_depth = box->edge_size + edge_correction_factor;
+		if (box->flags & BoxFlag_ViewScroll) child_depth -= box->view_offset;
+		for (u32 c = node->first_child; c; c = nodes[c].next_sibling) {
+			UI_Box* child = nodes[c].box;
+			child->computed_rel_position[box->layout_axis] = child_depth;
+			child->computed_rel_position[!box->layout_axis] = box->edge_size + child_edge_correction_factor;
+			child_depth += child->computed_size[box->layout_axis];
+		}
 	}
-	if (box->semantic_size[axis].kind == SizeKind_ChildrenSum) {
-		box->computed_size[axis] = size;
+	
+	// NOTE(voxel): A child that got clipped away entirely has its corners swapped, but they
+	// are still inside its parent's extent so taking them in only ever makes bounds looser
+	for (u32 i = ui_cache->layout_node_count; i-- > 0;) {
+		UI_LayoutNode* node = &nodes[i];
+		if (node->first_child) {
+			node->box->subtree_bounds = (rect) {
+				node->subtree_min.x, node->subtree_min.y,
+				node->subtree_max.x - node->subtree_min.x, node->subtree_max.y - node->subtree_min.y
+			};
+		}
+		if (!i) break;
+		UI_LayoutNode* parent = &nodes[node->parent];
+		parent->subtree_min.x = Min(parent->subtree_min.x, node->subtree_min.x);
+		parent->subtree_min.y = Min(parent->subtree_min.y, node->subtree_min.y);
+		parent->subtree_max.x = Max(parent->subtree_max.x, node->subtree_max.x);
+		parent->subtree_max.y = Max(parent->subtree_max.y, node->subtree_max.y);
 	}
 }
 
-static void UI_LayoutRecursePositionForward(UI_Cache* ui_cache, UI_Box* box, f32 depth) {
-	f32 edge_correction_factor = box->parent ? (box->parent->edge_size)*0.25 : 0;
-	f32 child_depth = box->edge_size + edge_correction_factor;
+// Children first, so hot/active goes to the same box a full walk of the tree would pick.
+// Returns whether a clickable box at or under this one is hit, which keeps every box
+// above it from hovering
+static b8 UI_HitTestRecurse(UI_Cache* ui_cache, UI_Box* box, vec2 mouse, b8* hot_found) {
+	if (!rect_contains_point(UI_BoxSubtreeBounds(box), mouse)) return false;
+	
+	b8 blocked = false;
 	UI_Box* curr = box->first;
 	while (curr) {
-		UI_LayoutRecursePositionForward(ui_cache, curr, child_depth);
-		child_depth += curr->computed_size[box->layout_axis];
+		blocked |= UI_HitTestRecurse(ui_cache, curr, mouse, hot_found);
 		curr = curr->next;
 	}
 	
-	if (box->parent) {
-		box->computed_rel_position[box->parent->layout_axis] = depth;
-		box->computed_rel_position[!box->parent->layout_axis] = box->parent->edge_size + edge_correction_factor;
+	if (!rect_contains_point(box->clipped_bounds, mouse)) return blocked;
+	if (!*hot_found && box->parent && !UI_KeyIsNull(box->key)) {
+		if (OS_InputButton(Input_MouseButton_Left)) ui_cache->active_key = box->key;
+		else ui_cache->hot_key = box->key;
+		*hot_found = true;
 	}
+	// Signals for this box get asked for while building the next frame
+	if (!blocked) box->hover_frame_index = ui_cache->current_frame_index + 1;
+	return blocked || (box->flags & BoxFlag_Clickable);
 }
 
-static void UI_LayoutRecurseCalculateBounds(UI_Cache* ui_cache, UI_Box* box, f32 xoff, f32 yoff) {
-	xoff += box->computed_rel_position[axis2_x];
-	yoff += box->computed_rel_position[axis2_y];
-	
-	box->target_bounds.x = xoff;
-	box->target_bounds.y = yoff;
-	box->target_bounds.w = box->computed_size[axis2_x];
-	box->target_bounds.h = box->computed_size[axis2_y];
-	
-	rect clippable_bounds = box->bounds;
-	if (box->flags & BoxFlag_DrawBorder) {
-		f32 edge_correction_factor = box->parent ? (box->parent->edge_size)*0.25 : 0;
-		clippable_bounds.x += box->edge_size + edge_correction_factor;
-		clippable_bounds.y += box->edge_size + edge_correction_factor;
-		clippable_bounds.w -= box->edge_size * 2 + edge_correction_factor;
-		clippable_bounds.h -= box->edge_size * 2 + edge_correction_factor;
-	}
-	
-	rect clipping_quad = UI_ClippingRectPeek(ui_cache);
-	box->clipped_bounds = rect_get_overlap(clippable_bounds, clipping_quad);
-	
-	if (box->flags & BoxFlag_Clip) {
-		UI_ClippingRectPush(ui_cache, box->clipped_bounds);
-	}
-	
+// NOTE(voxel): The one point query of the frame. subtree_bounds makes the box tree its own
+// bounding volume hierarchy, so only the boxes along the way to the mouse get visited
+static void UI_HitTest(UI_Cache* ui_cache) {
+	ui_cache->hot_key = (UI_Key) {0};
+	ui_cache->active_key = (UI_Key) {0};
+	b8 hot_found = false;
+	UI_HitTestRecurse(ui_cache, ui_cache->root, v2(OS_InputGetMouseX(), OS_InputGetMouseY()), &hot_found);
+}
+
+#define UI_VIEW_SCROLL_SPEED 60.f // Pixels per wheel notch
+
+// Innermost scroll view under the mouse takes the wheel. Returns whether it was taken
+static b8 UI_ViewScrollRecurse(UI_Cache* ui_cache, UI_Box* box, f32 scroll) {
+	b8 used = false;
 	UI_Box* curr = box->first;
 	while (curr) {
-		UI_LayoutRecurseCalculateBounds(ui_cache, curr, xoff, yoff);
+		used |= UI_ViewScrollRecurse(ui_cache, curr, used ? 0.f : scroll);
 		curr = curr->next;
 	}
 	
-	if (box->flags & BoxFlag_Clip) {
-		UI_ClippingRectPop(ui_cache);
+	if (box->flags & BoxFlag_ViewScroll) {
+		if (!used && scroll != 0.f &&
+			rect_contains_point(box->clipped_bounds, v2(OS_InputGetMouseX(), OS_InputGetMouseY()))) {
+			box->view_offset -= scroll * UI_VIEW_SCROLL_SPEED;
+			used = true;
+		}
+		f32 viewport = box->computed_size[box->layout_axis] - box->edge_size * 2;
+		box->view_offset = Clamp(0.f, box->view_offset, Max(0.f, box->content_size - viewport));
 	}
+	return used;
 }
 
 // Required?
@@ -630,36 +976,24 @@ void UI_Free(UI_Cache* ui_cache) {
 }
 
 void UI_Resize(UI_Cache* ui_cache, i32 w, i32 h) {
-	R_PipelineBind(&ui_cache->pipeline);
-	
 	ui_cache->root->computed_size[0] = w;
 	ui_cache->root->computed_size[1] = h;
 	ui_cache->clipping_rect_stack.elems[0].w = w;
 	ui_cache->clipping_rect_stack.elems[0].h = h;
 	
+	// u_projection lives in the uniform buffer, the plain uniform upload never reached it
 	mat4 projection = mat4_ortho(0, w, 0, h, -1, 1000);
-	R_ShaderPackUploadMat4(&ui_cache->shaderpack, str_lit("u_projection"), projection);
+	R_UniformBufferSetMat4(&ui_cache->constants, str_lit("u_projection"), projection);
 }
 
 void UI_BeginFrame(OS_Window* window, UI_Cache* ui_cache) {
 	// NOTE(voxel): EVICTION PASS
-	Iterate (ui_cache->cache, i) {
-		UI_Box* curr = &ui_cache->cache.elems[i];
-		if (UI_KeyIsNull(curr->key)) continue;
-		while (curr) {
-			if (!UI_KeyIsNull(curr->key)) {
-				if (curr->last_frame_touched_index < ui_cache->current_frame_index) {
-					UI_Key todel = curr->key;
-					curr = curr->hash_next;
-					stable_table_del(UI_Key, UI_Box, &ui_cache->cache, todel);
-					continue;
-				}
-			}
-			
-			curr = curr->hash_next;
-		}
+	stable_table_foreach(UI_Key, UI_Box, &ui_cache->cache, curr) {
+		if (curr->last_frame_touched_index < ui_cache->current_frame_index)
+			stable_table_del(UI_Key, UI_Box, &ui_cache->cache, curr->key);
 	}
 	ui_cache->current_frame_index++;
+	ui_cache->box_count = 0;
 	
 	// NOTE(voxel): Reset all the stacks and push default values
 	UI_POP_ALL_STACKS_TO_ONE;
@@ -677,6 +1011,70 @@ void UI_BeginFrame(OS_Window* window, UI_Cache* ui_cache) {
 	ui_cache->root = container;
 }
 
+//- Draw List Retention
+
+// Everything UI_PushBox and the custom renderers read from a box, packed so each box is
+// one str_hash_64. previous chains the boxes together in the order they're drawn, and
+// with depth that order pins down the whole tree
+typedef struct UI_BoxDrawState {
+	u64 previous;
+	u64 key;
+	u64 identifier_hash;
+	u64 custom_render_hash;
+	UI_FontInfo* font;
+	UI_RenderFunction* custom_render;
+	rect bounds;
+	rect clipped_bounds;
+	UI_BoxFlags flags;
+	u32 depth;
+	f32 hot_t;
+	f32 active_t;
+	u32 hot_color;
+	u32 active_color;
+	u32 color;
+	u32 edge_color;
+	u32 text_color;
+	f32 rounding;
+	f32 softness;
+	f32 edge_size;
+} UI_BoxDrawState;
+
+// Has to visit exactly what UI_PushBoxRecursive visits
+static u64 UI_HashBoxRecursive(u64 hash, UI_Box* box, u32 depth) {
+	if (UI_KeyIsNull(box->key)) return hash;
+	
+	UI_BoxDrawState state;
+	MemoryZeroStruct(&state, UI_BoxDrawState);
+	state.previous = hash;
+	state.key = box->key.id;
+	state.identifier_hash = box->identifier.size ? str_hash_64(box->identifier) : 0;
+	state.custom_render_hash = box->custom_render_hash;
+	state.font = box->font;
+	state.custom_render = box->custom_render;
+	state.bounds = box->bounds;
+	state.clipped_bounds = box->clipped_bounds;
+	state.flags = box->flags;
+	state.depth = depth;
+	state.hot_t = box->hot_t;
+	state.active_t = box->active_t;
+	state.hot_color = box->hot_color;
+	state.active_color = box->active_color;
+	state.color = box->color;
+	state.edge_color = box->edge_color;
+	state.text_color = box->text_color;
+	state.rounding = box->rounding;
+	state.softness = box->softness;
+	state.edge_size = box->edge_size;
+	hash = str_hash_64((string_const) { (u8*) &state, sizeof(UI_BoxDrawState) });
+	
+	UI_Box* curr = box->first;
+	while (curr) {
+		hash = UI_HashBoxRecursive(hash, curr, depth + 1);
+		curr = curr->next;
+	}
+	return hash;
+}
+
 static void UI_PushBoxRecursive(UI_Cache* ui_cache, UI_Box* box) {
 	if (UI_KeyIsNull(box->key)) return;
 	UI_PushBox(ui_cache, box);
@@ -697,55 +1095,66 @@ static void UI_PushBoxRecursive(UI_Cache* ui_cache, UI_Box* box) {
 }
 
 void UI_EndFrame(UI_Cache* ui_cache, f32 delta_time) {
-	// TODO(voxel): @rework Use a queue and stack to bypass recusive functions
-	//              I have yet to implement a queue in ds.h so I'll hold off on that for now
-	for (u32 i = axis2_x; i < axis2_count; i++) {
-		UI_LayoutRecurseForward(ui_cache, ui_cache->root, i);
-		UI_LayoutRecurseBackward(ui_cache, ui_cache->root, i);
-		// NOTE(voxel): What the hell is this supposed to do even. I'll implement this
-		//              if I find things to be weird
-		//UI_LayoutRecurseSolveViolations(ui_cache, ui_cache->root, i);
-	}
-	UI_LayoutRecursePositionForward(ui_cache, ui_cache->root, 0.f);
-	UI_LayoutRecurseCalculateBounds(ui_cache, ui_cache->root, 0.f, 0.f);
+	UI_LayoutFlatten(ui_cache);
+	UI_LayoutSizesFromChildren(ui_cache);
+	// NOTE(voxel): What the hell is this supposed to do even. I'll implement this
+	//              if I find things to be weird
+	//UI_LayoutRecurseSolveViolations(ui_cache, ui_cache->root, i);
+	UI_LayoutPlace(ui_cache);
 	
-	ui_cache->hot_key = (UI_Key) {0};
-	ui_cache->active_key = (UI_Key) {0};
-	UI_StateRecurseCheckHotAndActive(ui_cache, ui_cache->root);
+	UI_HitTest(ui_cache);
+	// Takes effect next frame, so virtualized views pick their rows with the new offset
+	UI_ViewScrollRecurse(ui_cache, ui_cache->root, OS_InputGetMouseScrollY());
 	
 	// UI_Animate inlined
 	f32 fast_rate = 1 - pow(2.f, -50.f * delta_time);
 	f32 slow_rate = 1 - pow(2.f, -30.f * delta_time);
-	Iterate (ui_cache->cache, i) {
-		UI_Box* curr = &ui_cache->cache.elems[i];
-		if (UI_KeyIsNull(curr->key)) continue;
-		while (curr) {
-			if (!UI_KeyIsNull(curr->key)) {
-				b8 is_hot        = UI_KeyEquals(ui_cache->hot_key, curr->key);
-				b8 is_active     = UI_KeyEquals(ui_cache->active_key, curr->key);
-				curr->hot_t     += ((f32)!!is_hot - curr->hot_t) * fast_rate;
-				curr->active_t  += ((f32)!!is_active - curr->active_t) * fast_rate;
-				
-				if (curr->direct_set) {
-					curr->bounds.x += curr->target_bounds.x;
-					curr->bounds.y += curr->target_bounds.y;
-					curr->bounds.w += curr->target_bounds.w;
-					curr->bounds.h += curr->target_bounds.h;
-				} else {
-					curr->bounds.x += (curr->target_bounds.x - curr->bounds.x) * slow_rate;
-					curr->bounds.y += (curr->target_bounds.y - curr->bounds.y) * slow_rate;
-					curr->bounds.w += (curr->target_bounds.w - curr->bounds.w) * slow_rate;
-					curr->bounds.h += (curr->target_bounds.h - curr->bounds.h) * slow_rate;
-				}
-			}
-			curr = curr->hash_next;
+	stable_table_foreach(UI_Key, UI_Box, &ui_cache->cache, curr) {
+		b8 is_hot        = UI_KeyEquals(ui_cache->hot_key, curr->key);
+		b8 is_active     = UI_KeyEquals(ui_cache->active_key, curr->key);
+		curr->hot_t     += ((f32)!!is_hot - curr->hot_t) * fast_rate;
+		curr->active_t  += ((f32)!!is_active - curr->active_t) * fast_rate;
+		
+		// NOTE(voxel): Snap once the difference can't be seen anymore. The exponential
+		// approach would otherwise keep changing the values (and the draw hash) for
+		// hundreds of frames after things look settled
+		if (fabsf((f32)!!is_hot - curr->hot_t) < UI_ANIMATION_SETTLE_T) curr->hot_t = (f32)!!is_hot;
+		if (fabsf((f32)!!is_active - curr->active_t) < UI_ANIMATION_SETTLE_T) curr->active_t = (f32)!!is_active;
+		
+		if (curr->direct_set) {
+			curr->bounds.x += curr->target_bounds.x;
+			curr->bounds.y += curr->target_bounds.y;
+			curr->bounds.w += curr->target_bounds.w;
+			curr->bounds.h += curr->target_bounds.h;
+		} else {
+			curr->bounds.x += (curr->target_bounds.x - curr->bounds.x) * slow_rate;
+			curr->bounds.y += (curr->target_bounds.y - curr->bounds.y) * slow_rate;
+			curr->bounds.w += (curr->target_bounds.w - curr->bounds.w) * slow_rate;
+			curr->bounds.h += (curr->target_bounds.h - curr->bounds.h) * slow_rate;
+			
+			if (fabsf(curr->target_bounds.x - curr->bounds.x) < UI_ANIMATION_SETTLE_PIXELS &&
+				fabsf(curr->target_bounds.y - curr->bounds.y) < UI_ANIMATION_SETTLE_PIXELS &&
+				fabsf(curr->target_bounds.w - curr->bounds.w) < UI_ANIMATION_SETTLE_PIXELS &&
+				fabsf(curr->target_bounds.h - curr->bounds.h) < UI_ANIMATION_SETTLE_PIXELS)
+				curr->bounds = curr->target_bounds;
 		}
 	}
 	
 	// NOTE(voxel): RENDERING PASS
-	UI_BeginRendererFrame(ui_cache);
-	UI_PushBoxRecursive(ui_cache, ui_cache->root);
-	UI_EndRendererFrame(ui_cache);
+	// Only a frame that fit in one batch can be redrawn, earlier batches got overwritten
+	R_GPUTimerBegin(str_lit("UI"));
+	u64 draw_hash = UI_HashBoxRecursive(0, ui_cache->root, 0);
+	if (ui_cache->draw_list_retained && draw_hash == ui_cache->last_draw_hash) {
+		UI_RedrawRetained(ui_cache);
+	} else {
+		ui_cache->batch_count = 0;
+		UI_BeginRendererFrame(ui_cache);
+		UI_PushBoxRecursive(ui_cache, ui_cache->root);
+		UI_EndRendererFrame(ui_cache);
+		ui_cache->last_draw_hash = draw_hash;
+		ui_cache->draw_list_retained = ui_cache->batch_count <= 1;
+	}
+	R_GPUTimerEnd(str_lit("UI"));
 }
 
 //~ UI Builder
@@ -794,27 +1203,7 @@ static void UI_ButtonRenderFunction(UI_Cache* ui_cache, UI_Box* box) {
 	
 	//b8 is_hot = UI_KeyEquals(ui_cache->hot_key, box->key);
 	
-	f32 string_size = UI_GetStringSize(box->font, box->identifier);
-	vec2 pos = v2(box->bounds.x + (box->bounds.w / 2.f), box->bounds.y + (box->bounds.h / 2.f));
-	pos.x -= string_size / 2.f;
-	pos.y += (box->font->baseline / 2.f - 2.f) * box->hot_t + (box->font->baseline / 2.f) * (1 - box->hot_t);
-	vec4 vcolor = color_code_to_vec4(box->text_color);
-	
-	for (u32 i = 0; i < box->identifier.size; i++) {
-		if (box->identifier.str[i] >= 32 && box->identifier.str[i] < 128) {
-			stbtt_packedchar* info = &box->font->cdata[box->identifier.str[i] - 32];
-			rect uvs = {
-				info->x0 / 512.f,
-				info->y0 / 512.f,
-				(info->x1 - info->x0) / 512.f,
-				(info->y1 - info->y0) / 512.f
-			};
-			rect loc = { pos.x + info->xoff, pos.y + info->yoff, info->x1 - info->x0, info->y1 - info->y0 };
-			UI_PushQuad(ui_cache, loc, uvs, &box->font->font_texture,
-						UI_Vec4ColorSetUniform(vcolor), 0.f, 0.f, 0.f);
-			pos.x += info->xadvance;
-		}
-	}
+	UI_PushText(ui_cache, box, (box->font->baseline / 2.f - 2.f) * box->hot_t + (box->font->baseline / 2.f) * (1 - box->hot_t));
 	
 	vec4 bcolor = color_code_to_vec4(box->edge_color);
 	UI_QuadVec4ColorSet bcolor_set = { bcolor, bcolor, bcolor, bcolor };
@@ -835,12 +1224,8 @@ UI_Signal UI_Button(UI_Cache* ui_cache, string id) {
 UI_Signal UI_ButtonF(UI_Cache* ui_cache, const char* fmt, ...) {
 	va_list args;
 	va_start(args, fmt);
-	const char buf[8092];
-	vsnprintf(buf, 8092, fmt, args);
+	string s = str_from_formatv(U_GetFrameArena(), fmt, args);
 	va_end(args);
-	u64 size = strlen(buf);
-	string s = str_alloc(U_GetFrameArena(), size);
-	memmove(s.str, buf, size);
 	return UI_Button(ui_cache, s);
 }
 
@@ -865,12 +1250,8 @@ b8 UI_Checkbox(UI_Cache* ui_cache, string id) {
 b8 UI_CheckboxF(UI_Cache* ui_cache, const char* fmt, ...) {
 	va_list args;
 	va_start(args, fmt);
-	const char buf[8092];
-	vsnprintf(buf, 8092, fmt, args);
+	string s = str_from_formatv(U_GetFrameArena(), fmt, args);
 	va_end(args);
-	u64 size = strlen(buf);
-	string s = str_alloc(U_GetFrameArena(), size);
-	memmove(s.str, buf, size);
 	return UI_Checkbox(ui_cache, s);
 }
 
@@ -882,3 +1263,75 @@ void UI_Spacer(UI_Cache* ui_cache, UI_Size size) {
 	
 	UI_BoxMake(ui_cache, 0, str_lit(""));
 }
+
+//- Virtualized Views 
+
+UI_ListRange UI_ListBegin(UI_Cache* ui_cache, string id, f32 row_height, u64 row_count) {
+	UI_Box* list = UI_BoxMake(ui_cache, BoxFlag_ViewScroll | BoxFlag_Clip | BoxFlag_DrawBackground | BoxFlag_DrawBorder, id);
+	list->layout_axis = axis2_y;
+	
+	// Rows get picked with last frame's size, except when it's known up front
+	f32 viewport = list->semantic_size[axis2_y].kind == SizeKind_Pixels ?
+		list->semantic_size[axis2_y].value : list->computed_size[axis2_y];
+	viewport -= list->edge_size * 2;
+	
+	f32 offset = Clamp(0.f, list->view_offset, Max(0.f, row_count * row_height - viewport));
+	UI_ListRange range = {0};
+	if (row_height > 0.f && viewport > 0.f) {
+		range.first = (u64) (offset / row_height);
+		range.one_past_last = (u64) ceilf((offset + viewport) / row_height);
+		range.first = Min(range.first, row_count);
+		range.one_past_last = Min(range.one_past_last, row_count);
+	}
+	
+	UI_ParentPush(ui_cache, list);
+	UI_Spacer(ui_cache, UI_Pixels(range.first * row_height));
+	UI_PrefWidthPush(ui_cache, UI_Percentage(100));
+	UI_PrefHeightPush(ui_cache, UI_Pixels(row_height));
+	
+	ui_cache->list_box = list;
+	ui_cache->list_row_height = row_height;
+	ui_cache->list_row_count = row_count;
+	ui_cache->list_range = range;
+	return range;
+}
+
+void UI_ListEnd(UI_Cache* ui_cache) {
+	UI_PrefHeightPop(ui_cache);
+	UI_PrefWidthPop(ui_cache);
+	u64 rows_after = ui_cache->list_row_count - ui_cache->list_range.one_past_last;
+	UI_Spacer(ui_cache, UI_Pixels(rows_after * ui_cache->list_row_height));
+	UI_ParentPop(ui_cache);
+	ui_cache->list_box = nullptr;
+}
+
+i64 UI_MemoryView(UI_Cache* ui_cache, string id, u8* memory, u64 size, u32 bytes_per_row, u64 base_address) {
+	M_Arena* frame_arena = U_GetFrameArena();
+	f32 row_height = UI_FontPeek(ui_cache)->font_size + 4.f;
+	u64 row_count = (size + bytes_per_row - 1) / bytes_per_row;
+	i64 hovered = -1;
+	
+	UI_ListRange range;
+	UI_List(ui_cache, id, row_height, row_count, &range) {
+		for (u64 row = range.first; row < range.one_past_last; row++) {
+			// Cached boxes keep what they were made with, so the text is set every frame
+			UI_Box* row_box = UI_BoxMakeF(ui_cache, 0, "##%.*s_row_%llu", str_expand(id), row);
+			row_box->layout_axis = axis2_x;
+			
+			UI_Parent(ui_cache, row_box)
+				UI_PrefWidth(ui_cache, UI_TextContent(6)) {
+				UI_Box* address = UI_BoxMakeF(ui_cache, BoxFlag_DrawText, "##%.*s_address_%llu", str_expand(id), row);
+				address->identifier = str_from_format(frame_arena, "%04llX", base_address + row * bytes_per_row);
+				
+				for (u64 i = row * bytes_per_row; i < Min((row + 1) * bytes_per_row, size); i++) {
+					UI_Box* cell = UI_BoxMakeF(ui_cache, BoxFlag_DrawText | BoxFlag_DrawBackground | BoxFlag_HotAnimation | BoxFlag_Clickable,
+											   "##%.*s_byte_%llu", str_expand(id), i);
+					cell->identifier = str_from_format(frame_arena, "%02X", memory[i]);
+					if (UI_SignalFromBox(cell).hovering) hovered = (i64) i;
+				}
+			}
+		}
+	}
+	
+	return hovered;
+}
@@ -23,23 +23,115 @@
 
 //~ UI Text Caching Layer
 // TODO(voxel): Switch over from temporary STBTTF to Freetype.
-// TODO(voxel): Implement a Glyph Cache and Unicode stuff and things
-// TODO(voxel): It's quite tedious so for now I'll use stb-ttf
+
+// NOTE(voxel): Glyphs are rasterized the first time a (codepoint, size) pair gets used
+// and packed into UI_GLYPH_PAGE_SIZE square pages, each glyph uploaded as its own
+// sub-image. Pages get allocated as the previous one fills up. Once there are
+// UI_GLYPH_MAX_PAGES of them, the page that went the longest without being drawn from
+// is emptied and packed again.
+#define UI_GLYPH_PAGE_SIZE 256
+#define UI_GLYPH_MAX_PAGES 16
+#define UI_GLYPH_PADDING 1
+#define UI_GLYPH_NO_PAGE 0xFFFFFFFF
+
+typedef struct UI_GlyphKey {
+	u64 id;
+} UI_GlyphKey;
+
+typedef struct UI_Glyph UI_Glyph;
+struct UI_Glyph {
+	UI_GlyphKey key;
+	UI_Glyph* hash_next;
+	UI_Glyph* hash_prev;
+	
+	u32  page; // UI_GLYPH_NO_PAGE for glyphs with nothing to draw, like spaces
+	rect uvs;
+	rect offset; // From the pen position on the baseline
+	f32  advance;
+};
+
+StableTable_Prototype(UI_GlyphKey, UI_Glyph);
+
+typedef struct UI_GlyphPage {
+	R_Texture2D texture;
+	u32 cursor_x;
+	u32 cursor_y;
+	u32 row_height;
+	u64 last_used_frame_index;
+} UI_GlyphPage;
+
+// NOTE(voxel): Text that gets drawn keeps its width and glyph quads (relative to the pen
+// start) cached on the font, keyed by the string. Labels don't change much
+// between frames, so after the first frame measuring and drawing one is a lookup.
+// Runs that go unused for UI_TEXT_RUN_MAX_AGE frames get evicted, checked every
+// UI_TEXT_RUN_PRUNE_INTERVAL frames so text that changes every frame can't pile up.
+// Runs on a glyph page that gets emptied are evicted with it.
+#define UI_TEXT_RUN_MAX_AGE 60
+#define UI_TEXT_RUN_PRUNE_INTERVAL 15
+#define UI_TEXT_RUN_CHUNK_GLYPHS 16
+
+// id is the hash of str. Once a run is in the table its str is a copy it owns
+typedef struct UI_TextRunKey {
+	u64 id;
+	string str;
+} UI_TextRunKey;
+
+typedef struct UI_TextGlyph {
+	rect offset;
+	rect uvs;
+	u32  page;
+} UI_TextGlyph;
+
+typedef struct UI_TextGlyphChunk UI_TextGlyphChunk;
+struct UI_TextGlyphChunk {
+	UI_TextGlyphChunk* next;
+	u32 count;
+	UI_TextGlyph glyphs[UI_TEXT_RUN_CHUNK_GLYPHS];
+};
+
+typedef struct UI_TextRun UI_TextRun;
+struct UI_TextRun {
+	UI_TextRunKey key;
+	UI_TextRun* hash_next;
+	UI_TextRun* hash_prev;
+	
+	u64 last_frame_touched_index;
+	f32 width;
+	u32 page_mask;
+	UI_TextGlyphChunk* first_chunk;
+};
+
+StableTable_Prototype(UI_TextRunKey, UI_TextRun);
 
 typedef struct UI_FontInfo {
-	R_Texture2D font_texture;
-    stbtt_packedchar cdata[95];
+	// Holds the font file, the stbtt face points into it
+	M_Arena arena;
+	stbtt_fontinfo face;
     f32 scale;
     f32 font_size;
     i32 ascent;
     i32 descent;
     i32 baseline;
+	
+	stable_table(UI_GlyphKey, UI_Glyph) glyphs;
+	UI_GlyphPage pages[UI_GLYPH_MAX_PAGES];
+	u32 page_count;
+	u32 current_page;
+	u64 current_frame_index;
+	
+	stable_table(UI_TextRunKey, UI_TextRun) runs;
+	M_Pool glyph_chunks;
+	u64 last_prune_frame_index;
 } UI_FontInfo;
 
 void UI_LoadFont(UI_FontInfo* fontinfo, string filepath, f32 size);
 f32  UI_GetStringSize(UI_FontInfo* fontinfo, string str);
 void UI_FreeFont(UI_FontInfo* fontinfo);
 
+// Returned pointers are valid until the next lookup on the same font
+UI_Glyph*   UI_GlyphGet(UI_FontInfo* fontinfo, u32 codepoint, f32 size);
+UI_TextRun* UI_TextRunGet(UI_FontInfo* fontinfo, string str, u64 frame_index);
+
 //~ Main UI Layer
 
 //- UI Caching Helpers 
@@ -111,7 +203,7 @@ typedef struct UI_Cache UI_Cache;
 typedef u32 UI_BoxFlags;
 enum {
 	BoxFlag_Clickable       = 0x1,    // @done
-	BoxFlag_ViewScroll      = 0x2,    // TODO hard
+	BoxFlag_ViewScroll      = 0x2,    // @done
 	BoxFlag_DrawText        = 0x4,    // @done
 	BoxFlag_DrawBorder      = 0x8,    // @done
 	BoxFlag_DrawBackground  = 0x10,   // @done
@@ -149,15 +241,25 @@ struct UI_Box {
 	
 	// input things
 	b32 pressed_on_this;
+	// Frame the hit test found the mouse over this box for, with no clickable box under
+	// it in the way. See UI_HitTest
+	u64 hover_frame_index;
 	
 	// layouting
 	UI_Size semantic_size[axis2_count];
 	f32 computed_size[axis2_count];
 	axis2 layout_axis;
 	f32 computed_rel_position[axis2_count];
+	// BoxFlag_ViewScroll: children are shifted back by view_offset along layout_axis,
+	// which stays within the size of the children (content_size) minus the box's own
+	f32 view_offset;
+	f32 content_size;
 	rect target_bounds;
 	rect bounds;
 	rect clipped_bounds;
+	// Covers the clipped bounds of the box and everything under it, hit testing skips
+	// the whole subtree when the mouse is outside of it
+	rect subtree_bounds;
 	
 	// Properties!!
 	f32 hot_t;
@@ -174,8 +276,29 @@ struct UI_Box {
 	f32 softness;
 	f32 edge_size;
 	UI_RenderFunction* custom_render;
+	// Goes into the draw hash next to the fields above. A custom renderer that draws
+	// anything the box doesn't hold has to put a hash of it here after every UI_BoxMake, or the
+	// retained draw list keeps showing what it drew the first time
+	u64 custom_render_hash;
 };
 
+// NOTE(voxel): The box tree gets flattened into one of these per box, in pre-order, before
+// layouting. Every layout pass is then a sweep over the array, forward when parents have
+// to go first and backward when children have to. Index 0 is the root, which is never a
+// child or a sibling, so 0 also means none for first_child and next_sibling
+typedef struct UI_LayoutNode {
+	UI_Box* box;
+	u32 parent;
+	u32 first_child;
+	u32 next_sibling;
+	// What the children of this box get clipped to and whether they snap
+	b8 snap_children;
+	rect child_clip;
+	// Corners of the clipped bounds of the box and everything under it
+	vec2 subtree_min;
+	vec2 subtree_max;
+} UI_LayoutNode;
+
 UI_Box* UI_BoxMake(UI_Cache* cache, UI_BoxFlags flags, string str);
 UI_Box* UI_BoxMakeF(UI_Cache* cache, UI_BoxFlags flags, const char* fmt, ...);
 
@@ -202,23 +325,33 @@ UI_Signal UI_SignalFromBox(UI_Box* box);
 // TODO(voxel): This exposed API will be for custom rendering procedures
 
 #define MAX_UI_QUADS 2048
+// Must match the size of u_clip_rects in res/shaders/ui.vert.*
+#define UI_MAX_CLIP_RECTS 128
 
-typedef struct UI_Vertex {
+// NOTE(voxel): One of these per quad, drawn instanced. The vertex shader expands it into
+// six vertices, so nothing here gets repeated per vertex. Clip rects go into a uniform
+// array that the quads index, since most quads in a batch share just a few of them.
+typedef struct UI_Instance {
 	// We get box size and center instead of vertex position, since vertex pos can be calculated
 	// and box size/center cannot. Compression is being done basically
-    vec2 box_size;
+	vec2 box_size;
 	vec2 box_center;
-	vec2 uv;
-	f32  tex_idx;
-	vec4 color;
-	vec4 clip_quad;
+	rect uvs;
+	u32  colors[4]; // RGBA8, tl tr br bl
 	vec3 rounding_softness_and_edge_size;
-} UI_Vertex;
+	u16  tex_idx;
+	u16  clip_idx;
+} UI_Instance;
 
 void UI_PushQuad(UI_Cache* ui_cache, rect bounds, rect uvs, R_Texture2D* texture, UI_QuadVec4ColorSet colors, f32 rounding, f32 softness, f32 edge_size);
 
 //~ UI Main Things 
 
+typedef struct UI_ListRange {
+	u64 first;
+	u64 one_past_last;
+} UI_ListRange;
+
 // UI_Box* doesn't really work ;-; so let's just use u64
 // Some things about these macros are not nice, I really gotta make the names not tied to type again
 
@@ -235,6 +368,11 @@ struct UI_Cache {
 	
 	UI_Box* root;
 	u64 current_frame_index;
+	// Boxes made this frame, an upper bound on how many end up in layout_nodes
+	u32 box_count;
+	// On the frame arena, rebuilt by UI_EndFrame
+	UI_LayoutNode* layout_nodes;
+	u32 layout_node_count;
 	
 	UI_Key hot_key;
 	UI_Key active_key;
@@ -244,12 +382,26 @@ struct UI_Cache {
 	R_Pipeline pipeline;
 	R_UniformBuffer constants;
 	R_Buffer gpu_side_buffer;
-	UI_Vertex cpu_side_buffer[MAX_UI_QUADS * 6];
+	UI_Instance cpu_side_buffer[MAX_UI_QUADS];
 	u32 quad_count;
+	vec4 clip_rects[UI_MAX_CLIP_RECTS];
+	u32 clip_rect_count;
+	u32 batch_count;
+	
+	// Hash of everything UI_PushBoxRecursive reads from the box tree. If it matches the
+	// previous frame, the previous frame's instances get drawn again as they are
+	u64 last_draw_hash;
+	b8  draw_list_retained;
 	R_Texture2D textures[8];
 	u32 textures_count;
 	
 	R_Texture2D white_texture;
+	
+	// The list being built between UI_ListBegin and UI_ListEnd, lists don't nest
+	UI_Box* list_box;
+	f32 list_row_height;
+	u64 list_row_count;
+	UI_ListRange list_range;
 };
 
 void UI_Init(OS_Window* window, UI_Cache* ui_cache);
@@ -269,6 +421,22 @@ b8        UI_Checkbox(UI_Cache* ui_cache, string id);
 b8        UI_CheckboxF(UI_Cache* ui_cache, const char* fmt, ...);
 void      UI_Spacer(UI_Cache* ui_cache, UI_Size size);
 
+// NOTE(voxel): Virtualized views. Only rows that intersect the viewport get boxes, and
+// spacers stand in for the rest, so the cost follows the size of the view instead of
+// the amount of data behind it. Every row has to be exactly row_height tall, which
+// UI_ListBegin sets up as the preferred height.
+//   UI_ListRange range;
+//   UI_List(ui_cache, str_lit("Disassembly"), 24, line_count, &range) {
+//     for (u64 i = range.first; i < range.one_past_last; i++) ...
+//   }
+UI_ListRange UI_ListBegin(UI_Cache* ui_cache, string id, f32 row_height, u64 row_count);
+void         UI_ListEnd(UI_Cache* ui_cache);
+#define UI_List(ui_cache, id, row_height, row_count, range) UI_DeferLoop(*(range) = UI_ListBegin(ui_cache, id, row_height, row_count), UI_ListEnd(ui_cache))
+
+// Hex grid, bytes_per_row cells per row after the address. Returns the index of the
+// hovered byte, or -1
+i64       UI_MemoryView(UI_Cache* ui_cache, string id, u8* memory, u64 size, u32 bytes_per_row, u64 base_address);
+
 // TODO(voxel): A Lot more widgets to be added here
 
 #endif //UI_H
@@ -7,28 +7,32 @@
 
 #include <dirent.h>
 #include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <dlfcn.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 // TODO(voxel): Error Checking ?!
 
 //~ OS Init
 
-static pthread_key_t linux_thread_context_key;
-
-void OS_Init(void) {
-    pthread_key_create(&linux_thread_context_key, nullptr);
-}
+void OS_Init(void) {}
 
 //~ TLS
 
+// NOTE(voxel): Every M_Alloc and scratch_get looks this up, a __thread variable is a single
+// fs relative load where pthread_getspecific is a call into libc
+static __thread void* linux_thread_context;
+
 void OS_ThreadContextSet(void* ctx) {
-    pthread_setspecific(linux_thread_context_key, ctx);
+    linux_thread_context = ctx;
 }
 
 void* OS_ThreadContextGet(void) {
-    return pthread_getspecific(linux_thread_context_key);
+    return linux_thread_context;
 }
 
 //~ Memory
@@ -42,9 +46,17 @@ void OS_MemoryCommit(void* memory, u64 size) {
 }
 
 void OS_MemoryDecommit(void* memory, u64 size) {
+    // PROT_NONE alone keeps the pages resident, they have to be dropped first
+    madvise(memory, size, MADV_DONTNEED);
     mprotect(memory, size, PROT_NONE);
 }
 
+void OS_MemoryAdviseHugePages(void* memory, u64 size) {
+#if defined(MADV_HUGEPAGE)
+    madvise(memory, size, MADV_HUGEPAGE);
+#endif
+}
+
 void OS_MemoryRelease(void* memory, u64 size) {
     munmap(memory, size);
 }
@@ -175,7 +187,7 @@ b32 OS_FileCreateDir(string dirname) {
     string nt = str_copy(&scratch.arena, dirname);
 	b32 result = true;
 	// NOTE(voxel): Not sure what mode is actually a good default...
-	size_t o = mkdir((const char*) nt.str, S_IRUSR | S_IRGRP | S_IROTH | S_IWOTH | S_IRGRP | S_IWGRP);
+	size_t o = mkdir((const char*) nt.str, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
 	if (o == -1) result = false;
 	scratch_return(&scratch);
 	return result;
@@ -203,23 +215,23 @@ string OS_Filepath(M_Arena* arena, OS_SystemPath path) {
 	switch (path) {
 		case SystemPath_CurrentDir: {
 			M_Scratch scratch = scratch_get();
-			u8* buffer = malloc(4096); // Should be plenty of space?
+			u8* buffer = M_Alloc(4096); // Should be plenty of space?
 			getcwd((i8*)buffer, 4096);
 			result.size = strlen((const char*)buffer);
 			result = str_alloc(arena, result.size);
 			memcpy(result.str, buffer, result.size);
-			free(buffer);
+			M_Free(buffer);
 			scratch_return(&scratch);
 		} break;
 		
 		case SystemPath_Binary: {
 			M_Scratch scratch = scratch_get();
-			u8* buffer = malloc(4096); // Should be plenty of space?
+			u8* buffer = M_Alloc(4096); // Should be plenty of space?
 			readlink("/proc/self/exe", (i8*)buffer, 4096);
 			result.size = strlen((const char*)buffer);
 			result = str_alloc(arena, result.size);
 			memcpy(result.str, buffer, result.size);
-			free(buffer);
+			M_Free(buffer);
 			u64 end = str_find_last(result, str_lit("/"), 0);
 			result.size = end - 1;
 			scratch_return(&scratch);
@@ -422,11 +434,22 @@ U_DateTime OS_TimeUniversalFromLocal(U_DateTime* date_time) {
 }
 
 
-u64 OS_TimeMicrosecondsNow(void) {
+// NOTE(voxel): CLOCK_MONOTONIC rather than CLOCK_MONOTONIC_RAW, since clock_nanosleep
+// doesn't take the raw clock and deadlines have to be on the same timeline.
+u64 OS_TimeNanosecondsNow(void) {
 	struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
-	u64 us = ((u64)ts.tv_sec * 1000000) + ((u64)ts.tv_nsec / 1000000);
-    return us;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((u64)ts.tv_sec * 1000000000ull) + (u64)ts.tv_nsec;
+}
+
+u64 OS_TimeMicrosecondsNow(void) {
+	return OS_TimeNanosecondsNow() / 1000;
+}
+
+void OS_TimeSleepUntilNanoseconds(u64 deadline) {
+	struct timespec until = { (time_t)(deadline / 1000000000ull), (long)(deadline % 1000000000ull) };
+	// Restart on EINTR, the deadline is absolute so nothing drifts
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, nullptr) == EINTR);
 }
 
 void OS_TimeSleepMilliseconds(u32 t) {
@@ -470,14 +493,207 @@ OS_Thread OS_ThreadCreate(thread_func* start, void* context) {
 	return ret;
 }
 
+// glibc only declares it with _GNU_SOURCE, which would have to come before every include
+int pthread_tryjoin_np(pthread_t thread, void** retval);
+
+// A thread that already got joined has a zero handle, joining it again does nothing
 void OS_ThreadWaitForJoin(OS_Thread* other) {
 	Linux_Thread* linux_thread = (Linux_Thread*) other;
+	if (!linux_thread->handle) return;
 	pthread_join(linux_thread->handle, nullptr);
+	linux_thread->handle = 0;
+}
+
+void OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count) {
+	for (u32 i = 0; i < count; i++)
+		OS_ThreadWaitForJoin(threads[i]);
+}
+
+// NOTE(voxel): pthreads can't wait on a set of threads, so this polls. The thread that
+// finished gets joined here and its handle zeroed
+void OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count) {
+	for (;;) {
+		b8 waiting = false;
+		for (u32 i = 0; i < count; i++) {
+			Linux_Thread* linux_thread = (Linux_Thread*) threads[i];
+			// Joined on an earlier call
+			if (!linux_thread->handle) continue;
+			waiting = true;
+			if (pthread_tryjoin_np(linux_thread->handle, nullptr) == 0) {
+				linux_thread->handle = 0;
+				return;
+			}
+		}
+		if (!waiting) return;
+		OS_TimeSleepMilliseconds(1);
+	}
 }
 
-// NOTE(voxel): Will uncomment this if I find a way of doing this for linux.
-//              The only way I can think of is to use mutexes and conditions myself.
-//              That would take some time. so I'll just keep it commented so it throws a link error
-//void OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count) {}
-//void OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count) {}
+void OS_ThreadYield(void) {
+	sched_yield();
+}
+
+u32 OS_ProcessorCount(void) {
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32) count : 1;
+}
+
+//~ Synchronization
+
+// Only sleeps if *address still holds expected by the time the kernel looks at it
+// True only if it got woken up, which can still be spurious
+static b8 linux_futex_wait(u32* address, u32 expected) {
+	return syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0) == 0;
+}
+
+// Returns how many threads it woke up
+static u32 linux_futex_wake(u32* address, u32 count) {
+	long woken = syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, (int) Min(count, (u32) INT_MAX), nullptr, nullptr, 0);
+	return woken > 0 ? (u32) woken : 0;
+}
+
+//- Mutex
+
+// NOTE(voxel): Drepper, "Futexes Are Tricky", the third mutex. state is 0 when unlocked,
+// 1 when locked and 2 when locked with someone possibly asleep on it, so unlocking only
+// has to make a syscall in the last case. Spins for a bit first, critical sections are
+// usually shorter than a trip through the kernel
+typedef struct Linux_Mutex {
+	u32 state;
+} Linux_Mutex;
+
+#define LINUX_MUTEX_SPINS 128
+
+void OS_MutexInit(OS_Mutex* mutex) {
+	MemoryZeroStruct(mutex, OS_Mutex);
+}
+
+void OS_MutexFree(OS_Mutex* mutex) {}
+
+b8 OS_MutexTryLock(OS_Mutex* mutex) {
+	Linux_Mutex* linux_mutex = (Linux_Mutex*) mutex;
+	u32 expected = 0;
+	return OS_AtomicCompareExchange(&linux_mutex->state, &expected, 1, MemoryOrder_Acquire);
+}
+
+void OS_MutexLock(OS_Mutex* mutex) {
+	Linux_Mutex* linux_mutex = (Linux_Mutex*) mutex;
+	u32 state = 0;
+	for (u32 i = 0; i < LINUX_MUTEX_SPINS; i++) {
+		if (OS_AtomicCompareExchange(&linux_mutex->state, &state, 1, MemoryOrder_Acquire)) return;
+		if (state == 2) break;
+		state = 0;
+	}
+	
+	// Whoever holds it has to wake someone up now
+	if (state != 2) state = OS_AtomicExchange(&linux_mutex->state, 2, MemoryOrder_Acquire);
+	while (state != 0) {
+		linux_futex_wait(&linux_mutex->state, 2);
+		state = OS_AtomicExchange(&linux_mutex->state, 2, MemoryOrder_Acquire);
+	}
+}
+
+void OS_MutexUnlock(OS_Mutex* mutex) {
+	Linux_Mutex* linux_mutex = (Linux_Mutex*) mutex;
+	if (OS_AtomicExchange(&linux_mutex->state, 0, MemoryOrder_Release) == 2)
+		linux_futex_wake(&linux_mutex->state, 1);
+}
+
+//- Condition Variable
+
+// NOTE(voxel): Waiters sleep on a sequence number that every signal bumps, so a signal that
+// lands between unlocking the mutex and going to sleep makes the futex wait return right away.
+// state packs how many threads are in Wait (low half) and how many of those were woken by a
+// signal and haven't come back out yet (high half). When every waiter already has a wake up
+// coming there's nobody asleep to wake, so the signal skips the syscall. That's the common
+// case when a producer signals faster than the woken consumers get scheduled.
+// The signal only adds to woken after the syscall says how many it woke, so woken can dip
+// below zero for a moment, and a spurious return takes off one it never got. Both only
+// ever make it count low, which costs an extra wake, never a missed one
+typedef struct Linux_CondVar {
+	u32 sequence;
+	u32 padding;
+	u64 state;
+} Linux_CondVar;
+
+#define LINUX_CONDVAR_WAITER 1ull
+#define LINUX_CONDVAR_WOKEN (1ull << 32)
+
+void OS_CondVarInit(OS_CondVar* cv) {
+	MemoryZeroStruct(cv, OS_CondVar);
+}
+
+void OS_CondVarFree(OS_CondVar* cv) {}
+
+void OS_CondVarWait(OS_CondVar* cv, OS_Mutex* mutex) {
+	Linux_CondVar* linux_cv = (Linux_CondVar*) cv;
+	OS_AtomicFetchAdd(&linux_cv->state, LINUX_CONDVAR_WAITER, MemoryOrder_SeqCst);
+	u32 sequence = OS_AtomicLoad(&linux_cv->sequence, MemoryOrder_SeqCst);
+	OS_MutexUnlock(mutex);
+	
+	// Woken comes off before the waiter does, so it never counts someone who already left
+	if (linux_futex_wait(&linux_cv->sequence, sequence))
+		OS_AtomicFetchAdd(&linux_cv->state, -LINUX_CONDVAR_WOKEN, MemoryOrder_SeqCst);
+	OS_AtomicFetchAdd(&linux_cv->state, -LINUX_CONDVAR_WAITER, MemoryOrder_SeqCst);
+	OS_MutexLock(mutex);
+}
+
+static void linux_condvar_wake(Linux_CondVar* linux_cv, u32 count) {
+	OS_AtomicFetchAdd(&linux_cv->sequence, 1, MemoryOrder_SeqCst);
+	u64 state = OS_AtomicLoad(&linux_cv->state, MemoryOrder_SeqCst);
+	i64 waiters = (u32) state;
+	i64 woken = (i32) (state >> 32);
+	if (waiters <= woken) return;
+	
+	u32 newly_woken = linux_futex_wake(&linux_cv->sequence, count);
+	if (newly_woken) OS_AtomicFetchAdd(&linux_cv->state, newly_woken * LINUX_CONDVAR_WOKEN, MemoryOrder_SeqCst);
+}
+
+void OS_CondVarSignal(OS_CondVar* cv) {
+	linux_condvar_wake((Linux_CondVar*) cv, 1);
+}
+
+void OS_CondVarBroadcast(OS_CondVar* cv) {
+	linux_condvar_wake((Linux_CondVar*) cv, u32_max);
+}
+
+//- Semaphore
+
+// NOTE(voxel): waiters lets Signal skip the syscall when nobody is asleep. Both sides go
+// seq_cst so that either the signal sees the waiter, or the waiter sees the new count
+typedef struct Linux_Semaphore {
+	u32 count;
+	u32 waiters;
+} Linux_Semaphore;
+
+void OS_SemaphoreInit(OS_Semaphore* semaphore, u32 initial_count) {
+	Linux_Semaphore* linux_semaphore = (Linux_Semaphore*) semaphore;
+	linux_semaphore->count = initial_count;
+	linux_semaphore->waiters = 0;
+}
+
+void OS_SemaphoreFree(OS_Semaphore* semaphore) {}
+
+void OS_SemaphoreWait(OS_Semaphore* semaphore) {
+	Linux_Semaphore* linux_semaphore = (Linux_Semaphore*) semaphore;
+	for (;;) {
+		u32 count = OS_AtomicLoad(&linux_semaphore->count, MemoryOrder_Relaxed);
+		while (count > 0) {
+			if (OS_AtomicCompareExchange(&linux_semaphore->count, &count, count - 1, MemoryOrder_Acquire))
+				return;
+		}
+		
+		OS_AtomicFetchAdd(&linux_semaphore->waiters, 1, MemoryOrder_SeqCst);
+		if (OS_AtomicLoad(&linux_semaphore->count, MemoryOrder_SeqCst) == 0)
+			linux_futex_wait(&linux_semaphore->count, 0);
+		OS_AtomicFetchAdd(&linux_semaphore->waiters, -1, MemoryOrder_Relaxed);
+	}
+}
+
+void OS_SemaphoreSignal(OS_Semaphore* semaphore, u32 count) {
+	Linux_Semaphore* linux_semaphore = (Linux_Semaphore*) semaphore;
+	OS_AtomicFetchAdd(&linux_semaphore->count, count, MemoryOrder_SeqCst);
+	if (OS_AtomicLoad(&linux_semaphore->waiters, MemoryOrder_SeqCst))
+		linux_futex_wake(&linux_semaphore->count, count);
+}
 
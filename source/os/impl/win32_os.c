@@ -41,6 +41,10 @@ void OS_MemoryDecommit(void* memory, u64 size) {
     VirtualFree(memory, size, MEM_DECOMMIT);
 }
 
+// NOTE(voxel): Large pages on windows need SeLockMemoryPrivilege and have to be reserved
+// and committed in one go with MEM_LARGE_PAGES, which doesn't fit reserve-then-commit
+void OS_MemoryAdviseHugePages(void* memory, u64 size) {}
+
 void OS_MemoryRelease(void* memory, u64 size) {
     VirtualFree(memory, 0, MEM_RELEASE);
 }
@@ -594,16 +598,29 @@ U_DateTime OS_TimeUniversalFromLocal(U_DateTime* date_time) {
 	return result;
 }
 
-u64 OS_TimeMicrosecondsNow(void) {
+u64 OS_TimeNanosecondsNow(void) {
 	u64 result = 0;
 	LARGE_INTEGER perf_counter = {0};
 	if (QueryPerformanceCounter(&perf_counter)) {
 		u64 ticks = ((u64)perf_counter.HighPart << 32) | perf_counter.LowPart;
-		result = ticks * 1000000 / w32_ticks_per_sec;
+		// Split into whole seconds first, ticks * 1e9 overflows after a few hours of uptime
+		u64 seconds = ticks / w32_ticks_per_sec;
+		u64 remainder = ticks % w32_ticks_per_sec;
+		result = seconds * 1000000000ull + remainder * 1000000000ull / w32_ticks_per_sec;
 	}
 	return result;
 }
 
+u64 OS_TimeMicrosecondsNow(void) {
+	return OS_TimeNanosecondsNow() / 1000;
+}
+
+void OS_TimeSleepUntilNanoseconds(u64 deadline) {
+	// Sleep only has the 1ms granularity from timeBeginPeriod in OS_Init
+	u64 now = OS_TimeNanosecondsNow();
+	if (deadline > now) Sleep((DWORD)((deadline - now) / 1000000));
+}
+
 void OS_TimeSleepMilliseconds(u32 t) {
 	Sleep(t);
 }
@@ -642,20 +659,87 @@ void OS_ThreadWaitForJoin(OS_Thread* other) {
 	WaitForSingleObject((HANDLE)other->v[0], INFINITE);
 }
 
-void _OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count) {
+void OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count) {
 	M_Scratch scratch = scratch_get();
-	HANDLE* handles = arena_alloc(&scratch.arena, count);
+	HANDLE* handles = arena_alloc(&scratch.arena, count * sizeof(HANDLE));
 	for (u32 i = 0; i < count; i++)
 		handles[i] = (HANDLE) threads[i]->v[0];
 	WaitForMultipleObjects(count, handles, TRUE, INFINITE);
 	scratch_return(&scratch);
 }
 
-void _OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count) {
+void OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count) {
 	M_Scratch scratch = scratch_get();
-	HANDLE* handles = arena_alloc(&scratch.arena, count);
+	HANDLE* handles = arena_alloc(&scratch.arena, count * sizeof(HANDLE));
 	for (u32 i = 0; i < count; i++)
 		handles[i] = (HANDLE) threads[i]->v[0];
 	WaitForMultipleObjects(count, handles, FALSE, INFINITE);
 	scratch_return(&scratch);
 }
+
+void OS_ThreadYield(void) {
+	SwitchToThread();
+}
+
+u32 OS_ProcessorCount(void) {
+	SYSTEM_INFO info = {0};
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors ? info.dwNumberOfProcessors : 1;
+}
+
+//~ Synchronization
+
+// NOTE(voxel): SRW locks and condition variables are pointer sized and zero initialized, the
+// same as the futex versions on linux. Neither needs freeing
+void OS_MutexInit(OS_Mutex* mutex) {
+	InitializeSRWLock((SRWLOCK*) mutex);
+}
+
+void OS_MutexFree(OS_Mutex* mutex) {}
+
+void OS_MutexLock(OS_Mutex* mutex) {
+	AcquireSRWLockExclusive((SRWLOCK*) mutex);
+}
+
+b8 OS_MutexTryLock(OS_Mutex* mutex) {
+	return TryAcquireSRWLockExclusive((SRWLOCK*) mutex) != 0;
+}
+
+void OS_MutexUnlock(OS_Mutex* mutex) {
+	ReleaseSRWLockExclusive((SRWLOCK*) mutex);
+}
+
+void OS_CondVarInit(OS_CondVar* cv) {
+	InitializeConditionVariable((CONDITION_VARIABLE*) cv);
+}
+
+void OS_CondVarFree(OS_CondVar* cv) {}
+
+void OS_CondVarWait(OS_CondVar* cv, OS_Mutex* mutex) {
+	SleepConditionVariableSRW((CONDITION_VARIABLE*) cv, (SRWLOCK*) mutex, INFINITE, 0);
+}
+
+void OS_CondVarSignal(OS_CondVar* cv) {
+	WakeConditionVariable((CONDITION_VARIABLE*) cv);
+}
+
+void OS_CondVarBroadcast(OS_CondVar* cv) {
+	WakeAllConditionVariable((CONDITION_VARIABLE*) cv);
+}
+
+void OS_SemaphoreInit(OS_Semaphore* semaphore, u32 initial_count) {
+	semaphore->v[0] = (u64) CreateSemaphoreW(nullptr, initial_count, MAXLONG, nullptr);
+}
+
+void OS_SemaphoreFree(OS_Semaphore* semaphore) {
+	CloseHandle((HANDLE) semaphore->v[0]);
+	semaphore->v[0] = 0;
+}
+
+void OS_SemaphoreWait(OS_Semaphore* semaphore) {
+	WaitForSingleObject((HANDLE) semaphore->v[0], INFINITE);
+}
+
+void OS_SemaphoreSignal(OS_Semaphore* semaphore, u32 count) {
+	ReleaseSemaphore((HANDLE) semaphore->v[0], (LONG) count, nullptr);
+}
@@ -33,7 +33,7 @@ OS_Window* OS_WindowCreate(u32 width, u32 height, string title) {
 		string prefix = str_lit("ClassOf_");
 		string final = str_cat(&scratch.arena, prefix, title);
 		final = str_copy(&scratch.arena, final);
-		_classname_buffer = calloc(final.size + 1, sizeof(char));
+		_classname_buffer = M_AllocZero((final.size + 1) * sizeof(char));
 		_classname_buffer = memmove(_classname_buffer, final.str, final.size + 1);
 		
 		WNDCLASSA wc = {
@@ -50,7 +50,7 @@ OS_Window* OS_WindowCreate(u32 width, u32 height, string title) {
 		}
 	}
 	
-	W32_Window* window = malloc(sizeof(W32_Window));
+	W32_Window* window = M_Alloc(sizeof(W32_Window));
 	MemoryZeroStruct(window, W32_Window);
 	window->width = width;
 	window->height = height;
@@ -115,9 +115,9 @@ void OS_WindowClose(OS_Window* _window) {
 	_window_ct--;
 	if (_window_ct == 0) {
 		UnregisterClass(_classname_buffer, GetModuleHandle(0));
-		free(_classname_buffer);
+		M_Free(_classname_buffer);
 	}
-	free(window);
+	M_Free(window);
 }
 
 static void CALLBACK OS_PollEvents_Fiber(W32_Window* param) {
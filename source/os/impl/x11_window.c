@@ -12,36 +12,40 @@ static b8 _should_close = false;
 
 // Sadly for event callbacks we need to have a hash table.
 typedef X11_Window* X11_WindowHandle;
-HashTable_Prototype(Window, X11_WindowHandle);
+SwissTable_Prototype(Window, X11_WindowHandle);
 
-b8 X11WindowHandleIsNull(Window w) { return w == 0; }
 b8 X11WindowHandlesAreEqual(Window a, Window b) { return a == b; }
 u64 X11WindowHash(Window w) { return (u64)w; }
-b8 OSWindowHandleIsNull(X11_WindowHandle w) { return (u64)w == 0; }
-b8 OSWindowHandleIsTomb(X11_WindowHandle w) { return (u64)w == 69; }
-HashTable_Impl(Window, X11_WindowHandle, X11WindowHandleIsNull, X11WindowHandlesAreEqual,
-			   X11WindowHash, (X11_WindowHandle)69, OSWindowHandleIsNull, OSWindowHandleIsTomb);
+SwissTable_Impl(Window, X11_WindowHandle, X11WindowHandlesAreEqual, X11WindowHash);
 
-hash_table(Window, X11_WindowHandle) _window_map;
+swiss_table(Window, X11_WindowHandle) _window_map;
 
 OS_Window* OS_WindowCreate(u32 width, u32 height, string title) {
 	if (_window_ct == 0) {
 		_display = XOpenDisplay(NULL);
 		if (_display == NULL) {
+#if defined(BACKEND_SOFT)
+			// NOTE(voxel): The soft backend can still render into its offscreen buffer,
+			// so no display just means a window that is never shown and gets no events
+			Log("X11 Window Display Opening Failed, running headless");
+#else
 			LogReturn((OS_Window*) 0, "X11 Window Display Opening Failed");
+#endif
+		} else {
+			XAutoRepeatOn(_display);
+			_screen = DefaultScreen(_display);
 		}
-		XAutoRepeatOn(_display);
-		_screen = DefaultScreen(_display);
 		_window_ct += 1;
-		hash_table_init(Window, X11_WindowHandle, &_window_map);
+		swiss_table_init(Window, X11_WindowHandle, &_window_map);
 	}
 	
-	X11_Window* window = malloc(sizeof(X11_Window));
+	X11_Window* window = M_Alloc(sizeof(X11_Window));
 	MemoryZeroStruct(window, X11_Window);
 	window->width = width;
 	window->height = height;
 	window->title = title;
 	window->display = _display;
+	if (!_display) return (OS_Window*) window;
 	
 	window->handle =
 		XCreateSimpleWindow(_display, RootWindow(_display, _screen), 30, 30, width, height, 0, 0, 0);
@@ -50,13 +54,14 @@ OS_Window* OS_WindowCreate(u32 width, u32 height, string title) {
 				 PointerMotionMask | ResizeRedirectMask | ExposureMask);
 	XStoreName(_display, window->handle, (char*)title.str);
 	
-	hash_table_set(Window, X11_WindowHandle, &_window_map, window->handle, window);
+	swiss_table_set(Window, X11_WindowHandle, &_window_map, window->handle, window);
 	
 	return (OS_Window*) window;
 }
 
 void OS_WindowShow(OS_Window* _window) {
 	X11_Window* window = (X11_Window*) _window;
+	if (!_display) return;
 	XMapWindow(_display, window->handle);
 }
 
@@ -79,6 +84,7 @@ b8 OS_WindowIsOpen(OS_Window* _window) {
 
 void OS_PollEvents(void) {
 	__OS_InputReset();
+	if (!_display) return;
 	XEvent event;
 	while (XPending(_display)) {
 		XNextEvent(_display, &event);
@@ -87,7 +93,7 @@ void OS_PollEvents(void) {
 			
 			u8 translated = __X11KeyCode_Translate(k);
 			X11_Window* window;
-			hash_table_get(Window, X11_WindowHandle, &_window_map, event.xkey.window, &window);
+			swiss_table_get(Window, X11_WindowHandle, &_window_map, event.xkey.window, &window);
 			b8 did_repeat = __OS_InputKeyCallbackCheckRepeat(translated, Input_Press);
 			
 			if (window->key_callback) window->key_callback((OS_Window*) window, translated, did_repeat ? Input_Repeat : Input_Press);
@@ -101,7 +107,7 @@ void OS_PollEvents(void) {
 					  nev.xkey.keycode == event.xkey.keycode)) {
 					u8 translated = __X11KeyCode_Translate(k);
 					X11_Window* window;
-					hash_table_get(Window, X11_WindowHandle, &_window_map, event.xkey.window,
+					swiss_table_get(Window, X11_WindowHandle, &_window_map, event.xkey.window,
 								   &window);
 					__OS_InputKeyCallbackCheckRepeat(translated, Input_Release);
 					if (window->key_callback) window->key_callback((OS_Window*) window, translated, Input_Release);
@@ -110,7 +116,7 @@ void OS_PollEvents(void) {
 				
 				u8 translated = __X11KeyCode_Translate(k);
 				X11_Window* window;
-				hash_table_get(Window, X11_WindowHandle, &_window_map, event.xkey.window, &window);
+				swiss_table_get(Window, X11_WindowHandle, &_window_map, event.xkey.window, &window);
 				__OS_InputKeyCallbackCheckRepeat(translated, Input_Release);
 				if (window->key_callback) window->key_callback((OS_Window*) window, translated, Input_Release);
 			}
@@ -118,7 +124,7 @@ void OS_PollEvents(void) {
 			if (event.xbutton.button != 4 && event.xbutton.button != 5) {
 				u8 translated = event.xbutton.button - 1;
 				X11_Window* window;
-				hash_table_get(Window, X11_WindowHandle, &_window_map, event.xbutton.window, &window);
+				swiss_table_get(Window, X11_WindowHandle, &_window_map, event.xbutton.window, &window);
 				__OS_InputButtonCallback(translated, Input_Press);
 				if (window->button_callback) window->button_callback((OS_Window*) window, translated, Input_Press);
 			} else {
@@ -129,7 +135,7 @@ void OS_PollEvents(void) {
 			if (event.xbutton.button != 4 && event.xbutton.button != 5) {
 				u8 translated = event.xbutton.button - 1;
 				X11_Window* window;
-				hash_table_get(Window, X11_WindowHandle, &_window_map, event.xbutton.window, &window);
+				swiss_table_get(Window, X11_WindowHandle, &_window_map, event.xbutton.window, &window);
 				__OS_InputButtonCallback(translated, Input_Release);
 				if (window->button_callback) window->button_callback((OS_Window*) window, translated, Input_Release);
 			}
@@ -137,7 +143,7 @@ void OS_PollEvents(void) {
 			__OS_InputCursorPosCallback((f32)event.xmotion.x, (f32)event.xmotion.y);
 		} else if (event.type == Expose) {
 			X11_Window* window;
-			hash_table_get(Window, X11_WindowHandle, &_window_map, event.xexpose.window, &window);
+			swiss_table_get(Window, X11_WindowHandle, &_window_map, event.xexpose.window, &window);
 			if (window->resize_callback) window->resize_callback((OS_Window*) window, event.xexpose.width, event.xexpose.height);
 		}
 	}
@@ -145,11 +151,15 @@ void OS_PollEvents(void) {
 
 void OS_WindowClose(OS_Window* _window) {
 	X11_Window* window = (X11_Window*) _window;
-	XDestroyWindow(_display, window->handle);
+	if (_display) {
+		XDestroyWindow(_display, window->handle);
+		swiss_table_del(Window, X11_WindowHandle, &_window_map, window->handle);
+	}
 	_window_ct -= 1;
 	
 	if (!_window_ct) {
-		XCloseDisplay(_display);
-		hash_table_free(Window, X11_WindowHandle, &_window_map);
+		if (_display) XCloseDisplay(_display);
+		swiss_table_free(Window, X11_WindowHandle, &_window_map);
 	}
+	M_Free(window);
 }
@@ -26,6 +26,11 @@ typedef struct X11_Window {
 	struct {
 		GLXContext gl_context;
 	};
+#elif defined(BACKEND_SOFT)
+	struct {
+		XImage* image;
+		GC gc;
+	};
 #endif
 } X11_Window;
 
@@ -7,3 +7,43 @@
 #elif defined(PLATFORM_LINUX)
 #include "impl/linux_os.c"
 #endif
+
+//~ Frame Pacing
+
+#define OS_FRAME_PACER_MIN_SPIN 50000ull
+#define OS_FRAME_PACER_MAX_SPIN 4000000ull
+
+void OS_FramePacerInit(OS_FramePacer* pacer, u64 target_ns) {
+	pacer->target_ns = target_ns;
+	pacer->last_frame = OS_TimeNanosecondsNow();
+	pacer->deadline = pacer->last_frame + target_ns;
+	pacer->spin_ns = 1000000ull;
+}
+
+u64 OS_FramePacerWait(OS_FramePacer* pacer) {
+	u64 now = OS_TimeNanosecondsNow();
+	
+	if (now + pacer->spin_ns < pacer->deadline) {
+		u64 wake_target = pacer->deadline - pacer->spin_ns;
+		OS_TimeSleepUntilNanoseconds(wake_target);
+		now = OS_TimeNanosecondsNow();
+		
+		// Grow quickly when a sleep overshoots, shrink slowly so one lucky wakeup
+		// doesn't make the next frame late
+		u64 late = now > wake_target ? now - wake_target : 0;
+		if (late > pacer->spin_ns) pacer->spin_ns = late + late / 4;
+		else pacer->spin_ns -= (pacer->spin_ns - late) / 16;
+		pacer->spin_ns = Clamp(OS_FRAME_PACER_MIN_SPIN, pacer->spin_ns, OS_FRAME_PACER_MAX_SPIN);
+	}
+	
+	while (now < pacer->deadline) now = OS_TimeNanosecondsNow();
+	
+	// A frame that ran long moves the schedule instead of trying to catch up with a
+	// burst of zero-length frames
+	pacer->deadline += pacer->target_ns;
+	if (pacer->deadline <= now) pacer->deadline = now + pacer->target_ns;
+	
+	u64 delta = now - pacer->last_frame;
+	pacer->last_frame = now;
+	return delta;
+}
@@ -22,6 +22,8 @@ void* OS_MemoryReserve(u64 size);
 void  OS_MemoryCommit(void* memory, u64 size);
 void  OS_MemoryDecommit(void* memory, u64 size);
 void  OS_MemoryRelease(void* memory, u64 size);
+// Only a hint, the OS may or may not back the range with huge pages
+void  OS_MemoryAdviseHugePages(void* memory, u64 size);
 
 //~ Files
 
@@ -96,8 +98,29 @@ U_DateTime OS_TimeUniversalNow(void);
 U_DateTime OS_TimeLocalFromUniversal(U_DateTime* date_time);
 U_DateTime OS_TimeUniversalFromLocal(U_DateTime* date_time);
 
+// Monotonic, only meaningful relative to each other
+u64  OS_TimeNanosecondsNow(void);
 u64  OS_TimeMicrosecondsNow(void);
 void OS_TimeSleepMilliseconds(u32 t);
+// Coarse, can wake up late by the scheduler's granularity. Use OS_FramePacer for precision
+void OS_TimeSleepUntilNanoseconds(u64 deadline);
+
+//~ Frame Pacing
+
+// NOTE(voxel): Deadlines are scheduled as start + n * target, not relative to when the
+// previous frame finished, so wakeup error never accumulates. The OS sleep is stopped
+// spin_ns short of the deadline and the rest is spun. spin_ns follows how late the
+// sleeps actually wake up.
+typedef struct OS_FramePacer {
+	u64 target_ns;
+	u64 deadline;
+	u64 last_frame;
+	u64 spin_ns;
+} OS_FramePacer;
+
+void OS_FramePacerInit(OS_FramePacer* pacer, u64 target_ns);
+// Waits out the rest of the current frame, returns the nanoseconds since the previous call
+u64  OS_FramePacerWait(OS_FramePacer* pacer);
 
 //~ Shared Libraries
 
@@ -122,5 +145,194 @@ OS_Thread OS_ThreadCreate(thread_func* start, void* context);
 void      OS_ThreadWaitForJoin(OS_Thread* other);
 void      OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count);
 void      OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count);
+void      OS_ThreadYield(void);
+u32       OS_ProcessorCount(void);
+
+//~ Atomics
+
+// NOTE(voxel): Thin wrappers over the __atomic builtins on gcc and clang, and over the
+// Interlocked intrinsics on msvc. They work on 32 and 64 bit integers and on pointers.
+// Compare exchange is the strong version and writes what it found into *expected when it fails
+typedef i32 OS_MemoryOrder;
+
+#if defined(COMPILER_CL)
+
+#include <intrin.h>
+
+enum {
+	MemoryOrder_Relaxed,
+	MemoryOrder_Acquire,
+	MemoryOrder_Release,
+	MemoryOrder_AcqRel,
+	MemoryOrder_SeqCst,
+};
+
+// NOTE(voxel): x64 only. Interlocked operations are full barriers there, and aligned loads
+// and stores are atomic with acquire and release semantics already, so those only have to
+// keep the compiler from moving things around. A seq_cst store goes through an exchange so
+// later loads can't pass it. _Generic picks the width, which needs /std:c11 or later
+#define OS_AtomicDefineCL(T, Name, IT, Suffix)\
+static inline T OS_AtomicLoad_##Name(T volatile* p, OS_MemoryOrder order) {\
+T value = *p;\
+_ReadWriteBarrier();\
+return value;\
+}\
+static inline void OS_AtomicStore_##Name(T volatile* p, T value, OS_MemoryOrder order) {\
+if (order == MemoryOrder_SeqCst) {\
+_InterlockedExchange##Suffix((IT volatile*) p, (IT) value);\
+return;\
+}\
+_ReadWriteBarrier();\
+*p = value;\
+}\
+static inline T OS_AtomicExchange_##Name(T volatile* p, T value, OS_MemoryOrder order) {\
+return (T) _InterlockedExchange##Suffix((IT volatile*) p, (IT) value);\
+}\
+static inline b8 OS_AtomicCompareExchange_##Name(T volatile* p, T* expected, T desired, OS_MemoryOrder order) {\
+T found = (T) _InterlockedCompareExchange##Suffix((IT volatile*) p, (IT) desired, (IT) *expected);\
+if (found == *expected) return true;\
+*expected = found;\
+return false;\
+}\
+static inline T OS_AtomicFetchAdd_##Name(T volatile* p, T value, OS_MemoryOrder order) {\
+return (T) _InterlockedExchangeAdd##Suffix((IT volatile*) p, (IT) value);\
+}
+
+OS_AtomicDefineCL(i8, i8, char, 8)
+OS_AtomicDefineCL(u8, u8, char, 8)
+OS_AtomicDefineCL(i16, i16, short, 16)
+OS_AtomicDefineCL(u16, u16, short, 16)
+OS_AtomicDefineCL(i32, i32, long, )
+OS_AtomicDefineCL(u32, u32, long, )
+OS_AtomicDefineCL(i64, i64, __int64, 64)
+OS_AtomicDefineCL(u64, u64, __int64, 64)
+
+// p points at a pointer. Takes void* so any pointer type goes in without a cast
+static inline void* OS_AtomicLoad_ptr(void* p, OS_MemoryOrder order) {
+	void* value = *(void* volatile*) p;
+	_ReadWriteBarrier();
+	return value;
+}
+
+static inline void OS_AtomicStore_ptr(void* p, void* value, OS_MemoryOrder order) {
+	if (order == MemoryOrder_SeqCst) {
+		_InterlockedExchangePointer((void* volatile*) p, value);
+		return;
+	}
+	_ReadWriteBarrier();
+	*(void* volatile*) p = value;
+}
+
+static inline void* OS_AtomicExchange_ptr(void* p, void* value, OS_MemoryOrder order) {
+	return _InterlockedExchangePointer((void* volatile*) p, value);
+}
+
+static inline b8 OS_AtomicCompareExchange_ptr(void* p, void* expected, void* desired, OS_MemoryOrder order) {
+	void* expected_value = *(void**) expected;
+	void* found = _InterlockedCompareExchangePointer((void* volatile*) p, desired, expected_value);
+	if (found == expected_value) return true;
+	*(void**) expected = found;
+	return false;
+}
+
+static inline void OS_AtomicFence_CL(OS_MemoryOrder order) {
+	if (order == MemoryOrder_SeqCst) _mm_mfence();
+	else _ReadWriteBarrier();
+}
+
+// Anything that isn't one of the integer types is taken to be a pointer. If it isn't pointer
+// sized either (f32, a small struct) the array size goes negative and it doesn't compile,
+// rather than the 8 byte pointer functions running over it
+#define OS_AtomicCheckCL(p) ((void) sizeof(char[_Generic(*(p),\
+i8: 1, u8: 1, i16: 1, u16: 1, i32: 1, u32: 1, i64: 1, u64: 1,\
+default: sizeof(*(p)) == sizeof(void*) ? 1 : -1)]))
+
+#define OS_AtomicSelectCL(p, Operation) (OS_AtomicCheckCL(p), _Generic(*(p),\
+i8: Operation##_i8,\
+u8: Operation##_u8,\
+i16: Operation##_i16,\
+u16: Operation##_u16,\
+i32: Operation##_i32,\
+u32: Operation##_u32,\
+i64: Operation##_i64,\
+u64: Operation##_u64,\
+default: Operation##_ptr))
+
+#define OS_AtomicLoad(p, order) OS_AtomicSelectCL(p, OS_AtomicLoad)(p, order)
+#define OS_AtomicStore(p, value, order) OS_AtomicSelectCL(p, OS_AtomicStore)(p, value, order)
+#define OS_AtomicExchange(p, value, order) OS_AtomicSelectCL(p, OS_AtomicExchange)(p, value, order)
+#define OS_AtomicCompareExchange(p, expected, desired, order) \
+OS_AtomicSelectCL(p, OS_AtomicCompareExchange)(p, expected, desired, order)
+// Returns the value from before the add. Integers only
+#define OS_AtomicFetchAdd(p, value, order) _Generic(*(p),\
+i8: OS_AtomicFetchAdd_i8,\
+u8: OS_AtomicFetchAdd_u8,\
+i16: OS_AtomicFetchAdd_i16,\
+u16: OS_AtomicFetchAdd_u16,\
+i32: OS_AtomicFetchAdd_i32,\
+u32: OS_AtomicFetchAdd_u32,\
+i64: OS_AtomicFetchAdd_i64,\
+u64: OS_AtomicFetchAdd_u64)(p, value, order)
+#define OS_AtomicFence(order) OS_AtomicFence_CL(order)
+
+#else
+
+enum {
+	MemoryOrder_Relaxed = __ATOMIC_RELAXED,
+	MemoryOrder_Acquire = __ATOMIC_ACQUIRE,
+	MemoryOrder_Release = __ATOMIC_RELEASE,
+	MemoryOrder_AcqRel  = __ATOMIC_ACQ_REL,
+	MemoryOrder_SeqCst  = __ATOMIC_SEQ_CST,
+};
+
+// A failed compare exchange only loads, so it can't have release semantics
+#define OS_AtomicFailureOrder(order) \
+((order) == MemoryOrder_Release ? MemoryOrder_Relaxed : (order) == MemoryOrder_AcqRel ? MemoryOrder_Acquire : (order))
+
+#define OS_AtomicLoad(p, order) __atomic_load_n(p, order)
+#define OS_AtomicStore(p, value, order) __atomic_store_n(p, value, order)
+#define OS_AtomicExchange(p, value, order) __atomic_exchange_n(p, value, order)
+#define OS_AtomicCompareExchange(p, expected, desired, order) \
+__atomic_compare_exchange_n(p, expected, desired, false, order, OS_AtomicFailureOrder(order))
+// Returns the value from before the add
+#define OS_AtomicFetchAdd(p, value, order) __atomic_fetch_add(p, value, order)
+#define OS_AtomicFence(order) __atomic_thread_fence(order)
+
+#endif
+
+//~ Synchronization
+
+// NOTE(voxel): All of these are OS specific buffers. Zeroed mutexes and condition variables
+// are ready to use, Init is there for symmetry. Semaphores have to go through Init and Free.
+// On linux everything is a futex and the uncontended paths never leave userspace
+typedef struct OS_Mutex {
+	u64 v[1];
+} OS_Mutex;
+
+typedef struct OS_CondVar {
+	u64 v[2];
+} OS_CondVar;
+
+typedef struct OS_Semaphore {
+	u64 v[1];
+} OS_Semaphore;
+
+void OS_MutexInit(OS_Mutex* mutex);
+void OS_MutexFree(OS_Mutex* mutex);
+void OS_MutexLock(OS_Mutex* mutex);
+b8   OS_MutexTryLock(OS_Mutex* mutex);
+void OS_MutexUnlock(OS_Mutex* mutex);
+
+void OS_CondVarInit(OS_CondVar* cv);
+void OS_CondVarFree(OS_CondVar* cv);
+// Can wake up spuriously, so check the condition in a loop
+void OS_CondVarWait(OS_CondVar* cv, OS_Mutex* mutex);
+void OS_CondVarSignal(OS_CondVar* cv);
+void OS_CondVarBroadcast(OS_CondVar* cv);
+
+void OS_SemaphoreInit(OS_Semaphore* semaphore, u32 initial_count);
+void OS_SemaphoreFree(OS_Semaphore* semaphore);
+void OS_SemaphoreWait(OS_Semaphore* semaphore);
+void OS_SemaphoreSignal(OS_Semaphore* semaphore, u32 count);
 
 #endif //OS_H